@@ -0,0 +1,478 @@
+#include "alarm_schedule.hpp"
+#include "local_time.hpp"
+#include <SDL3/SDL_time.h>
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <print>
+#include <random>
+
+namespace {
+
+// The first day from `day` on the rule goes off on
+std::optional<Sint64> get_first_day_from(const AlarmRule& rule, Sint64 day) {
+    switch (rule.repeat) {
+        case AlarmRepeat::Dates: {
+            auto it = std::lower_bound(rule.dates.begin(), rule.dates.end(), day);
+            if (it == rule.dates.end())
+                return std::nullopt;
+            return *it;
+        }
+
+        case AlarmRepeat::Daily:
+            return day;
+
+        case AlarmRepeat::Weekdays:
+            for (Sint64 next = day; next < day + 7; next++)
+                if (rule.weekdays & 1 << get_weekday(next))
+                    return next;
+            return std::nullopt;
+
+        case AlarmRepeat::EveryNDays: {
+            if (rule.interval_days <= 0)
+                return std::nullopt;
+            if (day <= rule.first_day)
+                return rule.first_day;
+            Sint64 periods = (day - rule.first_day + rule.interval_days - 1) / rule.interval_days;
+            return rule.first_day + periods * rule.interval_days;
+        }
+    }
+    return std::nullopt;
+}
+
+// Converts through the system's time zone each time
+struct SystemTimeZone {
+    Sint64 get_local_day(Sint64 wall_ms) { return ::get_local_day(wall_ms); }
+    Sint64 get_wall_ms_from_local(Sint64 day, Sint64 second_of_day) {
+        return ::get_wall_ms_from_local(day, second_of_day);
+    }
+};
+
+template <typename Zone>
+std::optional<Sint64> find_next_alarm_ms(const AlarmRule& rule, Sint64 after_ms, Zone& zone) {
+    // from the day before, a daylight saving change can push its time past
+    // midnight
+    Sint64 day = zone.get_local_day(after_ms) - 1;
+    while (auto found = get_first_day_from(rule, day)) {
+        Sint64 ms = zone.get_wall_ms_from_local(*found, rule.time_of_day_s);
+        if (ms > after_ms)
+            return ms;
+        day = *found + 1;
+    }
+    return std::nullopt;
+}
+
+}
+
+std::optional<Sint64> get_next_alarm_ms(const AlarmRule& rule, Sint64 after_ms) {
+    SystemTimeZone zone;
+    return find_next_alarm_ms(rule, after_ms, zone);
+}
+
+std::optional<Sint64> get_next_alarm_ms(const AlarmRule& rule, Sint64 after_ms, TimeZoneCache& zone) {
+    return find_next_alarm_ms(rule, after_ms, zone);
+}
+
+std::string format_alarm_dates(const std::vector<Sint64>& dates) {
+    std::string text;
+    for (Sint64 day : dates) {
+        CivilDate date = get_civil_from_days(day);
+        if (!text.empty())
+            text += ' ';
+        text += std::format("{:04}-{:02}-{:02}", date.year, date.month, date.day);
+    }
+    return text;
+}
+
+std::optional<std::vector<Sint64>> parse_alarm_dates(std::string_view text) {
+    std::vector<Sint64> dates;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        if (text[pos] == ' ' || text[pos] == ',') {
+            pos++;
+            continue;
+        }
+        size_t end = text.find_first_of(" ,", pos);
+        std::string_view date = text.substr(pos, end == std::string_view::npos ? std::string_view::npos : end - pos);
+        pos = end == std::string_view::npos ? text.size() : end;
+
+        if (date.size() != 10 || date[4] != '-' || date[7] != '-')
+            return std::nullopt;
+        auto parse = [&](size_t start, size_t length, int& value) {
+            auto [last, ec] = std::from_chars(date.data() + start, date.data() + start + length, value);
+            return ec == std::errc() && last == date.data() + start + length;
+        };
+        int year, month, day;
+        if (!parse(0, 4, year) || !parse(5, 2, month) || !parse(8, 2, day))
+            return std::nullopt;
+        if (month < 1 || month > 12 || day < 1 || day > SDL_GetDaysInMonth(year, month))
+            return std::nullopt;
+        dates.push_back(get_days_from_civil(year, month, day));
+    }
+
+    std::sort(dates.begin(), dates.end());
+    dates.erase(std::unique(dates.begin(), dates.end()), dates.end());
+    return dates;
+}
+
+std::string describe_alarm_rule(const AlarmRule& rule) {
+    switch (rule.repeat) {
+        case AlarmRepeat::Dates:
+            if (rule.dates.size() == 1)
+                return "Once, " + format_alarm_dates(rule.dates);
+            return std::format("On {} dates", rule.dates.size());
+
+        case AlarmRepeat::Daily:
+            return "Daily";
+
+        case AlarmRepeat::Weekdays: {
+            if (rule.weekdays == 0b0111110)
+                return "Weekdays";
+            if (rule.weekdays == 0b1000001)
+                return "Weekends";
+            if ((rule.weekdays & 0x7F) == 0x7F)
+                return "Daily";
+            // starting on Monday
+            static constexpr const char* names[] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+            std::string text;
+            for (int i = 1; i <= 7; i++) {
+                if (!(rule.weekdays & 1 << (i % 7)))
+                    continue;
+                if (!text.empty())
+                    text += ", ";
+                text += names[i % 7];
+            }
+            return text;
+        }
+
+        case AlarmRepeat::EveryNDays:
+            return std::format("Every {} days", rule.interval_days);
+    }
+    return "-";
+}
+
+SlotHandle AlarmScheduler::add(Alarm alarm, Sint64 now_ms) {
+    if (alarmsM.empty())
+        remember_time_zone(now_ms);
+    auto handle = alarmsM.emplace(std::move(alarm));
+    schedule(handle, *alarmsM.get(handle), now_ms);
+    versionM++;
+    return handle;
+}
+
+void AlarmScheduler::update(SlotHandle handle, Sint64 now_ms) {
+    if (Alarm* alarm = alarmsM.get(handle)) {
+        schedule(handle, *alarm, now_ms);
+        versionM++;
+    }
+}
+
+bool AlarmScheduler::remove(SlotHandle handle) {
+    firesM.cancel(handle.to_key());
+    versionM++;
+    return alarmsM.erase(handle);
+}
+
+size_t AlarmScheduler::pop_due(Sint64 now_ms, std::vector<SlotHandle>& out) {
+    dueM.clear();
+    size_t count = firesM.pop_due(static_cast<Uint64>(now_ms), dueM);
+    for (const DueEvent& ev : dueM) {
+        SlotHandle handle = SlotHandle::from_key(ev.id);
+        if (Alarm* alarm = alarmsM.get(handle)) {
+            out.push_back(handle);
+            schedule(handle, *alarm, now_ms);
+        }
+    }
+    if (count != 0)
+        versionM++;
+    return count;
+}
+
+std::optional<Sint64> AlarmScheduler::next_fire_ms() {
+    auto next = firesM.next_deadline();
+    if (!next.has_value())
+        return std::nullopt;
+    return static_cast<Sint64>(*next);
+}
+
+bool AlarmScheduler::check_time_zone(Sint64 now_ms) {
+    if (zoneM.is_watching()) {
+        if (!zoneM.take_change())
+            return false;
+    } else {
+        reread_time_zone();
+        if (get_utc_offset_s(now_ms) == offset_now_sM && get_utc_offset_s(now_ms + 182 * ms_per_day) == offset_later_sM)
+            return false;
+        zoneM.clear();
+    }
+    reschedule_all(now_ms);
+    return true;
+}
+
+void AlarmScheduler::schedule(SlotHandle handle, Alarm& alarm, Sint64 now_ms) {
+    alarm.next_ms = alarm.enabled ? get_next_alarm_ms(alarm.rule, now_ms, zoneM) : std::nullopt;
+    if (alarm.next_ms.has_value()) {
+        firesM.schedule(handle.to_key(), static_cast<Uint64>(*alarm.next_ms));
+    } else {
+        // a one-off that went off turns itself off
+        alarm.enabled = false;
+        firesM.cancel(handle.to_key());
+    }
+}
+
+void AlarmScheduler::reschedule_all(Sint64 now_ms) {
+    remember_time_zone(now_ms);
+    for (size_t i = 0; i < alarmsM.size(); i++)
+        schedule(alarmsM.handle_at(i), alarmsM[i], now_ms);
+    versionM++;
+}
+
+void AlarmScheduler::remember_time_zone(Sint64 now_ms) {
+    offset_now_sM = get_utc_offset_s(now_ms);
+    offset_later_sM = get_utc_offset_s(now_ms + 182 * ms_per_day);
+}
+
+namespace {
+
+Sint64 get_utc_ms(Sint64 year, unsigned month, unsigned day, int hour, int minute) {
+    return get_days_from_civil(year, month, day) * ms_per_day + (hour * 60 + minute) * 60 * 1000LL;
+}
+
+void use_time_zone(const char* zone) {
+#ifdef _WIN32
+    _putenv_s("TZ", zone != nullptr ? zone : "");
+#else
+    if (zone != nullptr)
+        setenv("TZ", zone, 1);
+    else
+        unsetenv("TZ");
+#endif
+    reread_time_zone();
+}
+
+struct DstCase {
+    const char* zone;
+    const char* what;
+    AlarmRule rule;
+    Sint64 after_ms;
+    // the times the rule goes off at next, in UTC
+    std::vector<Sint64> expected_ms;
+};
+
+AlarmRule make_rule(AlarmRepeat repeat, int hour, int minute) {
+    AlarmRule rule;
+    rule.repeat = repeat;
+    rule.time_of_day_s = (hour * 60 + minute) * 60;
+    return rule;
+}
+
+bool check_dst_cases() {
+    std::vector<DstCase> cases;
+    cases.push_back({"America/New_York", "a skipped time goes off an hour later", make_rule(AlarmRepeat::Daily, 2, 30),
+                     get_utc_ms(2026, 3, 8, 0, 0), {get_utc_ms(2026, 3, 8, 7, 30), get_utc_ms(2026, 3, 9, 6, 30)}});
+    cases.push_back({"America/New_York", "a repeated time goes off once", make_rule(AlarmRepeat::Daily, 1, 30),
+                     get_utc_ms(2026, 11, 1, 0, 0), {get_utc_ms(2026, 11, 1, 5, 30), get_utc_ms(2026, 11, 2, 6, 30)}});
+    cases.push_back({"America/New_York", "07:00 stays 07:00", make_rule(AlarmRepeat::Daily, 7, 0),
+                     get_utc_ms(2026, 3, 7, 0, 0), {get_utc_ms(2026, 3, 7, 12, 0), get_utc_ms(2026, 3, 8, 11, 0)}});
+    cases.push_back({"America/New_York", "weekdays over the change", make_rule(AlarmRepeat::Weekdays, 7, 0),
+                     get_utc_ms(2026, 3, 6, 13, 0), {get_utc_ms(2026, 3, 9, 11, 0), get_utc_ms(2026, 3, 10, 11, 0)}});
+    AlarmRule every_other = make_rule(AlarmRepeat::EveryNDays, 7, 0);
+    every_other.first_day = get_days_from_civil(2026, 3, 7);
+    cases.push_back({"America/New_York", "every other day over the change", every_other, get_utc_ms(2026, 3, 7, 12, 0),
+                     {get_utc_ms(2026, 3, 9, 11, 0), get_utc_ms(2026, 3, 11, 11, 0)}});
+    AlarmRule dates = make_rule(AlarmRepeat::Dates, 2, 30);
+    dates.dates = {get_days_from_civil(2026, 3, 8), get_days_from_civil(2026, 11, 1)};
+    cases.push_back({"America/New_York", "dates on both changes", dates, get_utc_ms(2026, 1, 1, 0, 0),
+                     {get_utc_ms(2026, 3, 8, 7, 30), get_utc_ms(2026, 11, 1, 7, 30)}});
+    cases.push_back({"Europe/Berlin", "a skipped time goes off an hour later", make_rule(AlarmRepeat::Daily, 2, 30),
+                     get_utc_ms(2026, 3, 28, 12, 0), {get_utc_ms(2026, 3, 29, 1, 30), get_utc_ms(2026, 3, 30, 0, 30)}});
+    cases.push_back({"Europe/Berlin", "a repeated time goes off once", make_rule(AlarmRepeat::Daily, 2, 30),
+                     get_utc_ms(2026, 10, 24, 12, 0), {get_utc_ms(2026, 10, 25, 0, 30), get_utc_ms(2026, 10, 26, 1, 30)}});
+    cases.push_back({"Australia/Sydney", "a repeated time goes off once", make_rule(AlarmRepeat::Daily, 2, 30),
+                     get_utc_ms(2026, 4, 4, 12, 0), {get_utc_ms(2026, 4, 4, 15, 30), get_utc_ms(2026, 4, 5, 16, 30)}});
+
+    bool ok = true;
+    for (const DstCase& test : cases) {
+        use_time_zone(test.zone);
+        Sint64 after_ms = test.after_ms;
+        for (Sint64 expected_ms : test.expected_ms) {
+            auto next = get_next_alarm_ms(test.rule, after_ms);
+            if (next != expected_ms) {
+                std::println(stderr, "{}, {}: expected {} but got {}", test.zone, test.what, expected_ms, next.value_or(-1));
+                ok = false;
+                break;
+            }
+            after_ms = *next;
+        }
+    }
+    // the last date was the last time
+    ok = ok && !get_next_alarm_ms(dates, get_utc_ms(2026, 11, 1, 7, 30)).has_value();
+
+    // moving to another zone moves the alarms with it
+    use_time_zone("America/New_York");
+    Sint64 now_ms = get_utc_ms(2026, 6, 1, 0, 0);
+    AlarmScheduler scheduler;
+    auto handle = scheduler.add({make_rule(AlarmRepeat::Daily, 7, 0), "", "", true, std::nullopt}, now_ms);
+    bool same_zone_kept = !scheduler.check_time_zone(now_ms);
+    use_time_zone("Europe/Berlin");
+    bool moved = scheduler.check_time_zone(now_ms) && scheduler.get(handle)->next_ms == get_utc_ms(2026, 6, 1, 5, 0) &&
+                 scheduler.next_fire_ms() == get_utc_ms(2026, 6, 1, 5, 0);
+    if (!same_zone_kept || !moved) {
+        std::println(stderr, "Alarms didn't follow the change from America/New_York to Europe/Berlin");
+        ok = false;
+    }
+    return ok;
+}
+
+// The cache against converting every time, for every day of two years in
+// zones with hour long, half hour long and no daylight saving changes
+bool check_time_zone_cache() {
+    static constexpr const char* zones[] = {"America/New_York", "Europe/Berlin", "Australia/Sydney",
+                                            "Australia/Lord_Howe", "Asia/Kolkata", "UTC"};
+    static constexpr Sint64 times_s[] = {0, 90 * 60, 150 * 60, 3 * 60 * 60, 12 * 60 * 60, 24 * 60 * 60 - 60};
+    Sint64 first_day = get_days_from_civil(2026, 1, 1);
+    Sint64 last_day = first_day + 2 * 365;
+
+    bool ok = true;
+    for (const char* zone_name : zones) {
+        use_time_zone(zone_name);
+        TimeZoneCache zone;
+        for (Sint64 day = first_day; day < last_day; day++) {
+            for (Sint64 time_s : times_s) {
+                if (zone.get_wall_ms_from_local(day, time_s) != get_wall_ms_from_local(day, time_s)) {
+                    std::println(stderr, "{}: day {} at {} s isn't converted like without the cache", zone_name, day, time_s);
+                    ok = false;
+                }
+            }
+        }
+        for (Sint64 ms = first_day * ms_per_day; ms < last_day * ms_per_day; ms += 15 * 60 * 1000) {
+            if (zone.get_local_day(ms) != get_local_day(ms)) {
+                std::println(stderr, "{}: the local day of {} isn't the same as without the cache", zone_name, ms);
+                ok = false;
+            }
+        }
+    }
+    return ok;
+}
+
+}
+
+bool run_alarm_benchmark() {
+    using clock = std::chrono::steady_clock;
+    auto get_ns = [](clock::time_point start) {
+        return std::chrono::duration<double, std::nano>(clock::now() - start).count();
+    };
+
+    const char* zone = std::getenv("TZ");
+    std::string saved_zone = zone != nullptr ? zone : "";
+
+    // reading a zone's file, which the cache's thread does at startup
+    static constexpr const char* unread_zones[] = {"Asia/Tokyo", "America/Chicago", "Europe/London", "Africa/Nairobi"};
+    Sint64 sample_ms = get_utc_ms(2026, 10, 19, 12, 0);
+    int offsets = 0;
+    auto start = clock::now();
+    for (const char* unread : unread_zones) {
+        use_time_zone(unread);
+        offsets += get_utc_offset_s(sample_ms);
+    }
+    double first_use_us = get_ns(start) / 1000 / std::size(unread_zones);
+
+    bool ok = check_dst_cases();
+    bool cache_ok = check_time_zone_cache();
+    ok = ok && cache_ok;
+
+    // the days and times alarms convert, spread over a year either way
+    use_time_zone("Europe/Berlin");
+    constexpr int conversions = 200'000;
+    std::mt19937 conversion_rng {7};
+    std::vector<std::pair<Sint64, Sint64>> local_times(conversions);
+    Sint64 sample_day = get_days_from_civil(2026, 10, 19);
+    for (auto& [day, time_s] : local_times) {
+        day = sample_day - 365 + static_cast<Sint64>(conversion_rng() % 730);
+        time_s = static_cast<Sint64>(conversion_rng() % (24 * 60)) * 60;
+    }
+    start = clock::now();
+    for (auto [day, time_s] : local_times)
+        offsets += static_cast<int>(get_wall_ms_from_local(day, time_s) & 1);
+    double uncached_ns = get_ns(start) / conversions;
+    TimeZoneCache cache;
+    for (auto [day, time_s] : local_times)
+        offsets += static_cast<int>(cache.get_wall_ms_from_local(day, time_s) & 1);
+    start = clock::now();
+    for (auto [day, time_s] : local_times)
+        offsets += static_cast<int>(cache.get_wall_ms_from_local(day, time_s) & 1);
+    double cached_ns = get_ns(start) / conversions;
+    double hit_rate = 100.0 * static_cast<double>(cache.get_lookups() - cache.get_misses()) / cache.get_lookups();
+
+    // a mix of every kind of rule at any minute of the day
+    constexpr size_t alarm_count = 10'000;
+    constexpr Sint64 week_ms = 7 * ms_per_day;
+    use_time_zone("Europe/Berlin");
+    Sint64 start_ms = get_utc_ms(2026, 10, 19, 12, 0);
+    Sint64 today = get_local_day(start_ms);
+    std::mt19937 rng {42};
+    std::vector<Alarm> alarms(alarm_count);
+    for (Alarm& alarm : alarms) {
+        AlarmRule& rule = alarm.rule;
+        rule.repeat = static_cast<AlarmRepeat>(rng() % 4);
+        rule.time_of_day_s = static_cast<Sint32>(rng() % (24 * 60)) * 60;
+        rule.weekdays = static_cast<Uint8>(1 + rng() % 127);
+        rule.interval_days = static_cast<Sint32>(1 + rng() % 10);
+        rule.first_day = today - static_cast<Sint64>(rng() % 10);
+        for (int i = 0; i < 3; i++)
+            rule.dates.push_back(today + static_cast<Sint64>(rng() % 14));
+        std::sort(rule.dates.begin(), rule.dates.end());
+        rule.dates.erase(std::unique(rule.dates.begin(), rule.dates.end()), rule.dates.end());
+    }
+
+    AlarmScheduler scheduler;
+    start = clock::now();
+    for (const Alarm& alarm : alarms)
+        scheduler.add(alarm, start_ms);
+    double add_us = get_ns(start) / 1000 / alarm_count;
+
+    // what waking up for the soonest alarm costs while nothing is due
+    constexpr int rounds = 100'000;
+    Sint64 checksum = 0;
+    start = clock::now();
+    for (int i = 0; i < rounds; i++)
+        checksum += scheduler.next_fire_ms().value_or(0);
+    double peek_ns = get_ns(start) / rounds;
+
+    // a week of waking up only when the soonest alarm is due
+    std::vector<SlotHandle> fired;
+    size_t fire_count = 0, wakeups = 0;
+    start = clock::now();
+    for (auto next = scheduler.next_fire_ms(); next.has_value() && *next <= start_ms + week_ms; next = scheduler.next_fire_ms()) {
+        fired.clear();
+        fire_count += scheduler.pop_due(*next, fired);
+        wakeups++;
+    }
+    double fire_us = get_ns(start) / 1000 / std::max<size_t>(fire_count, 1);
+
+    // every time any alarm goes off in the week, counted one alarm at a time
+    size_t expected = 0;
+    for (const Alarm& alarm : alarms)
+        for (auto next = get_next_alarm_ms(alarm.rule, start_ms); next.has_value() && *next <= start_ms + week_ms;
+             next = get_next_alarm_ms(alarm.rule, *next))
+            expected++;
+    if (fire_count != expected) {
+        std::println(stderr, "Alarm benchmark: {} alarms went off in the week, expected {}", fire_count, expected);
+        ok = false;
+    }
+
+    use_time_zone(saved_zone.empty() ? nullptr : saved_zone.c_str());
+    ok = ok && checksum != 0 && offsets != 0;
+    if (ok) {
+        std::println("Daylight saving and time zone changes: ok");
+        std::println("Time zones: {:.0f} us to read one the first time, then {:.0f} ns a conversion, {:.0f} ns with the "
+                     "cache ({:.1f}% of days remembered)", first_use_us, uncached_ns, cached_ns, hit_rate);
+        std::println("{} alarms: {:.2f} us to schedule one, {:.0f} ns to find the soonest, a week of {} going off "
+                     "over {} wakeups at {:.2f} us each", alarm_count, add_us, peek_ns, fire_count, wakeups, fire_us);
+    } else {
+        std::println(stderr, "Alarm benchmark failed");
+    }
+    return ok;
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "deadline_queue.hpp"
+#include "slot_map.hpp"
+#include "time_zone_cache.hpp"
+#include <SDL3/SDL_stdinc.h>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+enum class AlarmRepeat : Uint8 {
+    // on each of the rule's dates, a one-off alarm has a single one
+    Dates,
+    Daily,
+    // on the days of the week in the rule's mask
+    Weekdays,
+    // every `interval_days` days from `first_day` on
+    EveryNDays
+};
+
+// When an alarm goes off, in local time so 07:00 stays 07:00 through
+// daylight saving changes and moves with the system's time zone
+struct AlarmRule {
+    AlarmRepeat repeat = AlarmRepeat::Daily;
+    Sint32 time_of_day_s = 7 * 60 * 60;
+    // bit 0 for Sunday to bit 6 for Saturday, Monday to Friday by default
+    Uint8 weekdays = 0b0111110;
+    Sint32 interval_days = 2;
+    Sint64 first_day = 0;
+    // sorted days since 1970-01-01
+    std::vector<Sint64> dates;
+};
+
+// The first time after `after_ms` the rule goes off, nullopt once it won't
+// anymore. Only the days the rule can go off on are looked at, so the
+// cost doesn't depend on how far apart they are.
+std::optional<Sint64> get_next_alarm_ms(const AlarmRule& rule, Sint64 after_ms);
+// The same through the conversions `zone` remembers
+std::optional<Sint64> get_next_alarm_ms(const AlarmRule& rule, Sint64 after_ms, TimeZoneCache& zone);
+
+// "2026-10-19 2026-12-24", the dates of an AlarmRule
+std::string format_alarm_dates(const std::vector<Sint64>& dates);
+// Sorted and without duplicates, nullopt if any of them isn't a valid date
+std::optional<std::vector<Sint64>> parse_alarm_dates(std::string_view text);
+// "Weekdays", "Mon, Wed", "Every 3 days" and so on
+std::string describe_alarm_rule(const AlarmRule& rule);
+
+struct Alarm {
+    AlarmRule rule;
+    std::string label;
+    // empty for the default sound
+    std::string sound;
+    bool enabled = true;
+    // wall time it next goes off at, nullopt while it's disabled or done
+    std::optional<Sint64> next_ms;
+};
+
+// Audio player owner of an alarm's sound, apart from the timers' handles
+inline Uint64 get_alarm_sound_key(SlotHandle handle) {
+    return handle.to_key() | Uint64 {1} << 63;
+}
+
+// Every alarm with its next time in a deadline queue, so only the soonest
+// one is ever looked at while nothing is due and hundreds of alarms cost
+// as little as one. When one goes off only its own next time is worked out.
+// Times are wall clock milliseconds worked out in the time zone at the
+// time, check_time_zone() works them all out again once it changes.
+// Conversions go through a TimeZoneCache, which only watches the zone for
+// changes once it's started.
+class AlarmScheduler {
+public:
+    SlotHandle add(Alarm alarm, Sint64 now_ms);
+    // Works the alarm's next time out again after it was edited
+    void update(SlotHandle handle, Sint64 now_ms);
+    bool remove(SlotHandle handle);
+
+    Alarm* get(SlotHandle handle) { return alarmsM.get(handle); }
+    const SlotMap<Alarm>& get_alarms() const { return alarmsM; }
+    size_t size() const { return alarmsM.size(); }
+    // Changes whenever an alarm is added, edited, removed or goes off
+    Uint64 get_version() const { return versionM; }
+
+    // Moves the alarms due at `now_ms` into `out` and each of them on to
+    // its next time after `now_ms`, so an alarm missed several times over,
+    // during a suspend say, goes off once. Returns how many there were.
+    size_t pop_due(Sint64 now_ms, std::vector<SlotHandle>& out);
+    std::optional<Sint64> next_fire_ms();
+
+    // Works every alarm's time out again if the system's time zone changed,
+    // true if it did. While the zone is watched that's a single atomic load,
+    // otherwise the zone is read again, which is worth doing once a minute.
+    bool check_time_zone(Sint64 now_ms);
+    TimeZoneCache& get_time_zone() { return zoneM; }
+
+private:
+    SlotMap<Alarm> alarmsM;
+    DeadlineQueue firesM;
+    std::vector<DueEvent> dueM;
+    TimeZoneCache zoneM;
+    Uint64 versionM = 0;
+    // offsets now and half a year on when the times were worked out, which
+    // tell zones apart well enough to notice a change while it's not watched
+    int offset_now_sM = 0;
+    int offset_later_sM = 0;
+
+    void schedule(SlotHandle handle, Alarm& alarm, Sint64 now_ms);
+    void reschedule_all(Sint64 now_ms);
+    void remember_time_zone(Sint64 now_ms);
+};
+
+// Checks alarm times across the daylight saving changes of a few zones and
+// a change of zone, then times scheduling 10,000 alarms and a week of them
+// going off, for --alarm-benchmark
+bool run_alarm_benchmark();
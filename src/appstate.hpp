@@ -1,6 +1,7 @@
 #pragma once
 #include <SDL3/SDL.h>
 #include <optional>
+#include "slot_map.hpp"
 
 enum class WhatIsFullscreen {
     Timer, Stopwatch, Pomodoro
@@ -13,13 +14,14 @@ enum class FocusType {
 struct FocusState {
     std::optional<WhatIsFullscreen> what_is_focused = std::nullopt;
     FocusType type = FocusType::None;
-    std::optional<unsigned long> id_of_focussed = std::nullopt;
+    std::optional<SlotHandle> id_of_focussed = std::nullopt;
 };
 
 enum class CurrentTab {
     PomodoroTimer = 1,
     Timer,
     Alarms,
-    Stopwatch
+    Stopwatch,
+    History
 };
 
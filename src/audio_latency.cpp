@@ -0,0 +1,161 @@
+#include "audio_latency.hpp"
+#include "audio_player.hpp"
+#include "ui/timer_display.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <optional>
+#include <print>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+constexpr ma_uint32 sample_rate = 48'000;
+// a common device period, not a whole number of milliseconds
+constexpr ma_uint64 period_frames = 512;
+constexpr double ui_frame_ms = 1000.0 / 60;
+
+// Index of the first frame with a sample that isn't silent
+std::optional<ma_uint64> first_audible_frame(const std::vector<float>& out, ma_uint32 channels) {
+    for (size_t i = 0; i < out.size(); i++)
+        if (out[i] != 0.0f)
+            return i / channels;
+    return std::nullopt;
+}
+
+}
+
+bool run_audio_latency_check(const char* sound_path, int alarms) {
+    std::unique_ptr<AudioPlayer> ap;
+    try {
+        ap = std::make_unique<AudioPlayer>(sound_path, AudioOptions {true, 2, sample_rate});
+    } catch (const std::runtime_error& e) {
+        std::println(stderr, "Audio latency check failed: {}", e.what());
+        return false;
+    }
+
+    ma_uint32 channels = ap->get_channels();
+    std::vector<float> out(period_frames * channels);
+    // the virtual clock, everything else is derived from how much was mixed
+    ma_uint64 rendered = 0;
+    auto now_ms = [&] { return rendered * 1000 / sample_rate; };
+
+    // renders until something is heard, returns the frame it was heard at
+    auto render_period = [&]() -> std::optional<ma_uint64> {
+        ap->render(out.data(), period_frames);
+        auto audible = first_audible_frame(out, channels);
+        ma_uint64 start = rendered;
+        rendered += period_frames;
+        if (audible.has_value())
+            return start + *audible;
+        return std::nullopt;
+    };
+
+    // the sound may open with silence of its own, that isn't latency
+    ma_uint64 calibration_start = rendered;
+    ap->play(0, "", 0);
+    std::optional<ma_uint64> heard;
+    for (int i = 0; i < 1000 && !heard.has_value(); i++)
+        heard = render_period();
+    ap->stop(0);
+    if (!heard.has_value()) {
+        std::println(stderr, "Audio latency check failed: the alarm sound is silent");
+        return false;
+    }
+    ma_uint64 lead_in_silence = *heard - calibration_start;
+
+    std::vector<double> latencies_ms;
+    double next_ui_ms = 0;
+    for (int i = 0; i < alarms; i++) {
+        Uint64 owner = i + 1;
+        // deadlines land at varying points within audio periods and UI frames
+        Uint64 deadline_ms = now_ms() + timer_sound_goes_off_ms + alarm_arm_ahead_ms + 50 + (i * 37) % 1000;
+        Uint64 alarm_ms = deadline_ms - timer_sound_goes_off_ms;
+        bool armed = false;
+
+        heard.reset();
+        while (!heard.has_value()) {
+            // the UI gets to run between two periods, any frames that came
+            // due since then arm the alarm like tick_timers would
+            while (next_ui_ms <= static_cast<double>(now_ms())) {
+                if (!armed && next_ui_ms >= alarm_ms - alarm_arm_ahead_ms) {
+                    ap->play_alarm(owner, "", timer_sound_goes_off_ms, deadline_ms - now_ms());
+                    armed = true;
+                }
+                next_ui_ms += ui_frame_ms;
+            }
+            heard = render_period();
+        }
+        ap->stop(owner);
+
+        double ideal_frame = alarm_ms * (sample_rate / 1000.0) + lead_in_silence;
+        latencies_ms.push_back((*heard - ideal_frame) * 1000.0 / sample_rate);
+    }
+
+    std::sort(latencies_ms.begin(), latencies_ms.end());
+    auto percentile = [&](double p) { return latencies_ms[static_cast<size_t>(p * (latencies_ms.size() - 1))]; };
+    std::println("Audio latency over {} alarms at {} Hz, {} frame periods: p50 {:.3f} ms, p99 {:.3f} ms, max {:.3f} ms",
+                 alarms, sample_rate, period_frames, percentile(0.5), percentile(0.99), latencies_ms.back());
+    return true;
+}
+
+bool run_alarm_stress_check(const char* sound_path) {
+    std::unique_ptr<AudioPlayer> ap;
+    try {
+        ap = std::make_unique<AudioPlayer>(sound_path, AudioOptions {true, 2, sample_rate});
+    } catch (const std::runtime_error& e) {
+        std::println(stderr, "Alarm stress check failed: {}", e.what());
+        return false;
+    }
+
+    constexpr Uint64 alarms = 64;
+    constexpr Uint64 stolen = alarms - AudioPlayer::max_voices;
+    // one alarm going off every 1/64th of a second, with the audio mixed in between
+    constexpr ma_uint64 frames_apart = sample_rate / alarms;
+    std::vector<float> out(frames_apart * ap->get_channels());
+    for (Uint64 owner = 1; owner <= alarms; owner++) {
+        ap->play_alarm(owner, "", 0, 0);
+        ap->render(out.data(), frames_apart);
+    }
+
+    // owners still playing, or not, out of the alarms
+    auto playing_owners = [&] {
+        std::vector<Uint64> playing;
+        for (Uint64 owner = 1; owner <= alarms; owner++)
+            if (ap->is_playing(owner))
+                playing.push_back(owner);
+        return playing;
+    };
+    auto expect_playing = [&](const std::vector<Uint64>& owners, const char* what) {
+        if (playing_owners() == owners)
+            return true;
+        std::println(stderr, "Alarm stress check failed: {}", what);
+        return false;
+    };
+
+    bool ok = true;
+    if (ap->get_voices_stolen() != stolen) {
+        std::println(stderr, "Alarm stress check failed: {} voices were stolen, expected {}", ap->get_voices_stolen(),
+                     stolen);
+        ok = false;
+    }
+    std::vector<Uint64> expected;
+    for (Uint64 owner = stolen + 1; owner <= alarms; owner++)
+        expected.push_back(owner);
+    ok = expect_playing(expected, "the alarms still playing aren't the newest ones") && ok;
+
+    // an alarm whose voice was stolen has nothing left to stop
+    ap->stop(1);
+    ok = expect_playing(expected, "stopping an alarm whose voice was stolen stopped another one") && ok;
+    ap->stop(alarms - 3);
+    std::erase(expected, alarms - 3);
+    ok = expect_playing(expected, "stopping an alarm stopped other ones too") && ok;
+    ap->render(out.data(), frames_apart);
+    ok = expect_playing(expected, "the other alarms didn't keep playing") && ok;
+
+    if (ok)
+        std::println("{} alarms in one second: {} voices stolen, the newest {} still playing", alarms,
+                     ap->get_voices_stolen(), AudioPlayer::max_voices);
+    return ok;
+}
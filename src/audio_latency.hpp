@@ -0,0 +1,16 @@
+#pragma once
+
+// Measures how long after its ideal moment an alarm becomes audible. The
+// audio engine runs without a device and is read from directly, with a
+// virtual clock standing in for the system one, so this works on machines
+// without a sound card and gives the same result on every run. Alarms are
+// armed the way tick_timers arms them, and the first non-silent output
+// sample of each is compared to when it should have been. Prints the p50
+// and p99 latency and returns false if the audio engine couldn't be set up.
+bool run_audio_latency_check(const char* sound_path, int alarms);
+
+// Rings 64 alarms within one second of mixed audio, more than there are
+// voices, again without a device. Checks that 48 voices were stolen, that
+// the 16 newest alarms are the ones still playing and that stopping one
+// alarm silences nothing else. Returns false when any of that doesn't hold.
+bool run_alarm_stress_check(const char* sound_path);
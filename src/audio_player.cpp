@@ -0,0 +1,302 @@
+#include "audio_player.hpp"
+#include <limits>
+#include <stdexcept>
+
+AudioPlayer::AudioPlayer(const char *filePath, const AudioOptions& options)
+    : has_deviceM {false}, device_suspendedM {false}, cacheM {default_cache_budget_bytes}, voicesM {}, next_startM {1}, voices_stolenM {0}, sample_rate {0}
+{
+    ma_engine_config config = ma_engine_config_init();
+    if (options.no_device) {
+        config.noDevice = MA_TRUE;
+        // without a device the engine can't pick these itself
+        config.channels = options.channels != 0 ? options.channels : 2;
+        config.sampleRate = options.sample_rate != 0 ? options.sample_rate : 48000;
+    } else {
+        init_device(options);
+        // the engine takes its format from the device and starts it
+        config.pDevice = &deviceM;
+    }
+
+    ma_result result = ma_engine_init(&config, &engine);
+    if (result != MA_SUCCESS) {
+        uninit_device();
+        throw std::runtime_error("Failed to initialize audio engine.");
+    }
+
+    // the device's own format, the engine mixes in f32
+    ma_uint32 channels = ma_engine_get_channels(&engine);
+    sample_rate = ma_engine_get_sample_rate(&engine);
+
+    // the default sound is never streamed, every alarm may need it
+    auto sound = std::make_shared<Sound>();
+    result = decode_sound(filePath, channels, sample_rate, std::numeric_limits<size_t>::max(), *sound);
+    if (result != MA_SUCCESS) {
+        ma_engine_uninit(&engine);
+        uninit_device();
+        throw std::runtime_error("Failed to load sound file.");
+    }
+    default_soundM = std::move(sound);
+
+    cacheM.start(channels, sample_rate);
+}
+
+AudioPlayer::~AudioPlayer() {
+    for (Voice& voice : voicesM)
+        release_voice(voice);
+    ma_engine_uninit(&engine);
+    uninit_device();
+}
+
+static void device_data_callback(ma_device* device, void* output, const void* input, ma_uint32 frame_count) {
+    (void)input;
+    ma_engine_read_pcm_frames(static_cast<ma_engine*>(device->pUserData), output, frame_count, NULL);
+}
+
+// The engine's own device would take the backend's defaults, which on
+// PulseAudio and PipeWire can put 50-100 ms between mixing an alarm and
+// hearing it, so the device is set up here with the period and thread
+// priority from the options.
+void AudioPlayer::init_device(const AudioOptions& options) {
+    ma_context_config context_config = ma_context_config_init();
+    if (options.realtime_priority)
+        context_config.threadPriority = ma_thread_priority_realtime;
+    if (ma_context_init(NULL, 0, &context_config, &contextM) != MA_SUCCESS)
+        throw std::runtime_error("Failed to initialize audio context.");
+
+    ma_device_config device_config = ma_device_config_init(ma_device_type_playback);
+    device_config.playback.format = ma_format_f32;
+    device_config.playback.channels = options.channels;
+    device_config.sampleRate = options.sample_rate;
+    device_config.periodSizeInMilliseconds = options.period_ms;
+    device_config.performanceProfile = options.profile;
+    device_config.dataCallback = device_data_callback;
+    device_config.pUserData = &engine;
+
+    if (ma_device_init(&contextM, &device_config, &deviceM) != MA_SUCCESS) {
+        ma_context_uninit(&contextM);
+        throw std::runtime_error("Failed to open audio device.");
+    }
+    has_deviceM = true;
+}
+
+void AudioPlayer::uninit_device() {
+    if (!has_deviceM)
+        return;
+
+    ma_device_uninit(&deviceM);
+    ma_context_uninit(&contextM);
+    has_deviceM = false;
+}
+
+AudioLatency AudioPlayer::get_latency() const {
+    AudioLatency latency;
+    if (!has_deviceM)
+        return latency;
+
+    latency.period_frames = deviceM.playback.internalPeriodSizeInFrames;
+    latency.periods = deviceM.playback.internalPeriods;
+    latency.sample_rate = deviceM.playback.internalSampleRate;
+    if (latency.sample_rate != 0)
+        latency.ms = 1000.0 * latency.period_frames * latency.periods / latency.sample_rate;
+    return latency;
+}
+
+void AudioPlayer::play(Uint64 owner, const std::string& path, double seconds, Uint64 delay_ms, Uint64 fade_in_ms) {
+    std::shared_ptr<const Sound> source = default_soundM;
+    if (!path.empty()) {
+        if (auto custom = cacheM.get(path))
+            source = std::move(custom);
+    }
+
+    if (device_suspendedM && ma_engine_start(&engine) == MA_SUCCESS)
+        device_suspendedM = false;
+
+    Voice* voice = find_voice(owner);
+    if (voice == nullptr)
+        voice = &pick_voice();
+    // a voice is set up afresh every time, a sound that was seeked back
+    // would first play whatever miniaudio still had buffered from before
+    release_voice(*voice);
+    if (!bind_voice(*voice, std::move(source)) && !bind_voice(*voice, default_soundM)) {
+        voice->started = 0;
+        return;
+    }
+
+    voice->owner = owner;
+    voice->started = next_startM++;
+    voice->start_frame = ma_engine_get_time_in_pcm_frames(&engine) + delay_ms * sample_rate / 1000;
+    voice->fade_out_frame = 0;
+
+    ma_sound_seek_to_pcm_frame(&voice->sound, static_cast<ma_uint64>(seconds * sample_rate));
+    ma_sound_set_start_time_in_pcm_frames(&voice->sound, delay_ms != 0 ? voice->start_frame : 0);
+    if (fade_in_ms != 0)
+        ma_sound_set_fade_start_in_pcm_frames(&voice->sound, 0, 1, fade_in_ms * sample_rate / 1000, voice->start_frame);
+    ma_sound_start(&voice->sound);
+}
+
+void AudioPlayer::play_alarm(Uint64 owner, const std::string& path, Uint64 lead_ms, Uint64 remaining_ms, Uint64 fade_in_ms) {
+    if (remaining_ms >= lead_ms)
+        // scheduled on the engine's clock, so the sound starts on the exact sample
+        play(owner, path, 0, remaining_ms - lead_ms, fade_in_ms);
+    else
+        // too late for all of the lead in, skip into the sound by however much is missing
+        play(owner, path, (lead_ms - remaining_ms) / 1000.0, 0, fade_in_ms);
+}
+
+void AudioPlayer::crossfade(Uint64 from, Uint64 to, const std::string& path, Uint64 delay_ms, Uint64 fade_ms) {
+    ma_uint64 fade_frames = fade_ms * sample_rate / 1000;
+    ma_uint64 fade_start = ma_engine_get_time_in_pcm_frames(&engine) + delay_ms * sample_rate / 1000;
+
+    Voice* voice = find_voice(from);
+    if (voice != nullptr) {
+        // the fader starts from whatever volume the sound is at by then
+        ma_sound_set_stop_time_with_fade_in_pcm_frames(&voice->sound, fade_start + fade_frames, fade_frames);
+        voice->fade_out_frame = fade_start;
+    }
+
+    play(to, path, 0, delay_ms, fade_ms);
+}
+
+void AudioPlayer::render(float* out, ma_uint64 frames) {
+    ma_engine_read_pcm_frames(&engine, out, frames, NULL);
+}
+
+void AudioPlayer::stop(Uint64 owner) {
+    Voice* voice = find_voice(owner);
+    if (voice == nullptr)
+        return;
+
+    ma_sound_stop(&voice->sound);
+    ma_sound_seek_to_pcm_frame(&voice->sound, 0);
+    voice->started = 0;
+}
+
+void AudioPlayer::cancel_pending(Uint64 owner) {
+    Voice* voice = find_voice(owner);
+    if (voice == nullptr)
+        return;
+
+    if (is_pending(*voice))
+        stop(owner);
+    else
+        cancel_fade_out(*voice);
+}
+
+void AudioPlayer::cancel_all_pending() {
+    for (Voice& voice : voicesM) {
+        if (voice.started == 0)
+            continue;
+
+        if (is_pending(voice)) {
+            ma_sound_stop(&voice.sound);
+            voice.started = 0;
+        } else {
+            cancel_fade_out(voice);
+        }
+    }
+}
+
+void AudioPlayer::stop_all() {
+    for (Voice& voice : voicesM) {
+        if (voice.source != nullptr)
+            ma_sound_stop(&voice.sound);
+        voice.started = 0;
+    }
+}
+
+bool AudioPlayer::is_playing(Uint64 owner) const {
+    const Voice* voice = find_voice(owner);
+    return voice != nullptr && ma_sound_is_playing(&voice->sound);
+}
+
+void AudioPlayer::suspend_if_idle() {
+    if (!has_deviceM || device_suspendedM)
+        return;
+
+    for (const Voice& voice : voicesM)
+        if (voice.started != 0 && (is_pending(voice) || ma_sound_is_playing(&voice.sound)))
+            return;
+
+    if (ma_engine_stop(&engine) == MA_SUCCESS)
+        device_suspendedM = true;
+}
+
+AudioPlayer::Voice* AudioPlayer::find_voice(Uint64 owner) {
+    for (Voice& voice : voicesM)
+        if (voice.started != 0 && voice.owner == owner)
+            return &voice;
+    return nullptr;
+}
+
+const AudioPlayer::Voice* AudioPlayer::find_voice(Uint64 owner) const {
+    for (const Voice& voice : voicesM)
+        if (voice.started != 0 && voice.owner == owner)
+            return &voice;
+    return nullptr;
+}
+
+bool AudioPlayer::is_pending(const Voice& voice) const {
+    return ma_engine_get_time_in_pcm_frames(&engine) < voice.start_frame;
+}
+
+// Keeps the voice playing at full volume when its fade out hasn't begun
+// yet, one that's already under way is left to finish
+void AudioPlayer::cancel_fade_out(Voice& voice) {
+    if (voice.fade_out_frame == 0 || ma_engine_get_time_in_pcm_frames(&engine) >= voice.fade_out_frame)
+        return;
+
+    ma_sound_set_stop_time_in_pcm_frames(&voice.sound, ~(ma_uint64)0);
+    ma_sound_set_fade_in_pcm_frames(&voice.sound, 1, 1, 0);
+    voice.fade_out_frame = 0;
+}
+
+// A voice whose sound ran to the end is free again. With none free the
+// voice started the longest ago is stolen, its alarm has been heard the
+// longest and the newest alarm is the one that needs attention.
+AudioPlayer::Voice& AudioPlayer::pick_voice() {
+    Voice* oldest = &voicesM[0];
+    for (Voice& voice : voicesM) {
+        if (voice.started == 0 || (!is_pending(voice) && !ma_sound_is_playing(&voice.sound)))
+            return voice;
+        if (voice.started < oldest->started)
+            oldest = &voice;
+    }
+
+    voices_stolenM++;
+    ma_sound_stop(&oldest->sound);
+    return *oldest;
+}
+
+// Sets up a released voice to play `source`. Decoded sounds are read in
+// place, streamed ones are opened through the resource manager without
+// waiting for the file.
+bool AudioPlayer::bind_voice(Voice& voice, std::shared_ptr<const Sound> source) {
+    ma_result result;
+    if (source->streamed) {
+        result = ma_sound_init_from_file(&engine, source->path.c_str(),
+                                         MA_SOUND_FLAG_STREAM | MA_SOUND_FLAG_ASYNC | MA_SOUND_FLAG_NO_SPATIALIZATION,
+                                         NULL, NULL, &voice.sound);
+    } else {
+        ma_audio_buffer_ref_init(ma_format_f32, ma_engine_get_channels(&engine), source->pcm.data(), source->length_in_frames, &voice.buffer);
+        // the rates already match, so the pitch/resampling stage can be skipped
+        result = ma_sound_init_from_data_source(&engine, &voice.buffer, MA_SOUND_FLAG_NO_PITCH | MA_SOUND_FLAG_NO_SPATIALIZATION,
+                                                NULL, &voice.sound);
+        if (result != MA_SUCCESS)
+            ma_audio_buffer_ref_uninit(&voice.buffer);
+    }
+
+    if (result != MA_SUCCESS)
+        return false;
+    voice.source = std::move(source);
+    return true;
+}
+
+void AudioPlayer::release_voice(Voice& voice) {
+    if (voice.source == nullptr)
+        return;
+
+    ma_sound_uninit(&voice.sound);
+    if (!voice.source->streamed)
+        ma_audio_buffer_ref_uninit(&voice.buffer);
+    voice.source.reset();
+}
@@ -2,71 +2,154 @@
 #pragma once
 
 #include "miniaudio.h"
-#include <stdexcept>
+#include "sound_cache.hpp"
+#include <SDL3/SDL_stdinc.h>
+#include <array>
+#include <memory>
+#include <string>
 
+// Alarm voices are scheduled on the audio engine this long before they
+// start, soon enough to land on the exact sample without tying up a voice
+// for every running timer
+constexpr Uint64 alarm_arm_ahead_ms = 1000;
+// alarms come in from silence over this long instead of starting at full volume
+constexpr Uint64 alarm_fade_in_ms = 2000;
+// how long the end of one pomodoro phase and the start of the next overlap
+constexpr Uint64 phase_crossfade_ms = 3000;
+
+struct AudioOptions {
+    // mix through render() instead of a playback device, for running
+    // without a sound card
+    bool no_device = false;
+    // 0 uses the device's
+    ma_uint32 channels = 0;
+    ma_uint32 sample_rate = 0;
+    // length of one device period, 0 leaves it to the backend
+    ma_uint32 period_ms = 0;
+    // conservative trades latency for fewer glitches on busy machines
+    ma_performance_profile profile = ma_performance_profile_low_latency;
+    // run the audio thread with real-time scheduling, needs the right
+    // privileges (rtkit, RLIMIT_RTPRIO) or it falls back to the default
+    bool realtime_priority = false;
+};
+
+// What the backend actually gave us, which may differ from what was asked for
+struct AudioLatency {
+    ma_uint32 period_frames = 0;
+    ma_uint32 periods = 0;
+    ma_uint32 sample_rate = 0;
+    // time from a frame being mixed to it reaching the device
+    double ms = 0;
+};
+
+// Plays alarm sounds for any number of timers at once. Each playback
+// gets a voice of its own, tagged with the id of the timer it's for, so
+// stopping one timer's alarm leaves the others ringing. The default sound
+// is decoded once, up front, to PCM in the engine's own format and sample
+// rate, sounds the user picked come from a SoundCache. Voices playing
+// decoded sounds read the shared buffer through a cursor of their own, so
+// playing is a plain mix with nothing to decode or resample on the audio
+// thread, and seeking only moves the cursor. Fades are handed to
+// miniaudio's per-sound fader with the engine time they start at, so the
+// ramps run on the audio thread sample by sample however often the UI
+// gets to run.
 class AudioPlayer {
 public:
-    AudioPlayer(const char *filePath) : length_in_frames {0}, sample_rate {0} {
-        ma_result result = ma_engine_init(NULL, &engine);
-        if (result != MA_SUCCESS) {
-            throw std::runtime_error("Failed to initialize audio engine.");
-        }
-
-        result = ma_sound_init_from_file(&engine, filePath, 0, NULL, NULL, &sound);
-        if (result != MA_SUCCESS) {
-            ma_engine_uninit(&engine);
-            throw std::runtime_error("Failed to load sound file.");
-        }
-
-        result = ma_data_source_get_length_in_pcm_frames(&sound, &length_in_frames);
-        if (result != MA_SUCCESS) {
-            ma_sound_uninit(&sound);
-            ma_engine_uninit(&engine);
-            throw std::runtime_error("Failed to get sound length.");
-        }
-
-        ma_data_source* pDataSource = ma_sound_get_data_source(&sound);
-
-        result = ma_data_source_get_data_format(pDataSource, NULL, NULL, &sample_rate, NULL, 0);
-        if (result != MA_SUCCESS) {
-            ma_sound_uninit(&sound);
-            ma_engine_uninit(&engine);
-            throw std::runtime_error("Failed to get sample rate.");
-        }
-
-        float length_in_seconds = static_cast<float>(length_in_frames) / sample_rate;
-    }
+    // voices beyond this steal from the one that has been playing longest
+    static constexpr size_t max_voices = 16;
+    static constexpr size_t default_cache_budget_bytes = 64 * 1024 * 1024;
 
-    ~AudioPlayer() {
-        ma_sound_uninit(&sound);
-        ma_engine_uninit(&engine);
-    }
+    AudioPlayer(const char *filePath, const AudioOptions& options = {});
+    ~AudioPlayer();
 
-    void play() {
-        ma_sound_start(&sound);
-    }
+    AudioPlayer(const AudioPlayer&) = delete;
+    AudioPlayer& operator=(const AudioPlayer&) = delete;
 
-    void pause() {
-        ma_sound_stop(&sound);
-    }
+    // Starts the sound at `path`, or the default sound if it's empty,
+    // `seconds` in for `owner`. With a delay the start is scheduled on the
+    // engine's own clock, so it lands on the exact sample no matter when
+    // the UI gets to run. The owner's voice is restarted if it already has
+    // one. A sound that hasn't finished loading yet is replaced by the
+    // default sound. With `fade_in_ms` the volume ramps up from silence
+    // starting with the sound's first frame.
+    void play(Uint64 owner, const std::string& path, double seconds = 0, Uint64 delay_ms = 0, Uint64 fade_in_ms = 0);
+    // Plays an alarm whose sound builds up for `lead_ms` before the deadline
+    // `remaining_ms` away. The start is scheduled when there is time left
+    // for the whole lead in, otherwise it starts now, partway into the sound.
+    void play_alarm(Uint64 owner, const std::string& path, Uint64 lead_ms, Uint64 remaining_ms, Uint64 fade_in_ms = 0);
+    // `delay_ms` from now, fades `from`'s sound out over `fade_ms` while
+    // `to` plays the sound at `path`, fading in over the same time
+    void crossfade(Uint64 from, Uint64 to, const std::string& path, Uint64 delay_ms, Uint64 fade_ms);
+    // Stops `owner`'s sound, if it's playing or scheduled to
+    void stop(Uint64 owner);
+    // Stops `owner`'s sound only if it hasn't started yet, and drops a fade
+    // out that hasn't begun
+    void cancel_pending(Uint64 owner);
+    // Cancels every scheduled start and fade out, after a suspend they're
+    // all off by however long the engine's clock was stopped
+    void cancel_all_pending();
+    void stop_all();
 
-    bool is_playing_or_not() {
-        return ma_sound_is_playing(&sound);
-    }
+    // True once the owner's sound is audible, not while it's still scheduled
+    bool is_playing(Uint64 owner) const;
+
+    // Starts loading the sound at `path` in the background
+    void preload(const std::string& path) { cacheM.prefetch(path); }
+    void set_cache_budget(size_t bytes) { cacheM.set_budget(bytes); }
+    SoundCacheStats get_cache_stats() const { return cacheM.get_stats(); }
+
+    // Mixes the next `frames` frames into `out`, only with AudioOptions::no_device
+    void render(float* out, ma_uint64 frames);
+    ma_uint32 get_channels() const { return ma_engine_get_channels(&engine); }
 
     inline ma_uint32 get_sample_rate() const {
         return sample_rate;
     }
 
-    void seek_to(double seconds) {
-        ma_uint64 newFrame = seconds * static_cast<ma_uint64>(sample_rate);
-        ma_sound_seek_to_pcm_frame(&sound, newFrame);
-    }
+    size_t get_voices_stolen() const { return voices_stolenM; }
+
+    // Stops the playback device while no sound is playing or scheduled, so
+    // an idle process doesn't wake up for every period. The next play()
+    // starts it again.
+    void suspend_if_idle();
+    // All zero with AudioOptions::no_device
+    AudioLatency get_latency() const;
 
 private:
+    struct Voice {
+        ma_audio_buffer_ref buffer;
+        ma_sound sound;
+        // what the voice is set up to play, nullptr until first used
+        std::shared_ptr<const Sound> source;
+        Uint64 owner;
+        // order the voice was started in, the lowest is stolen first
+        Uint64 started;
+        // engine time the voice starts playing at
+        ma_uint64 start_frame;
+        // engine time a scheduled fade out begins at, 0 without one
+        ma_uint64 fade_out_frame;
+    };
+
+    ma_context contextM;
+    ma_device deviceM;
+    bool has_deviceM;
+    bool device_suspendedM;
     ma_engine engine;
-    ma_sound sound;
+    std::shared_ptr<const Sound> default_soundM;
+    SoundCache cacheM;
+    std::array<Voice, max_voices> voicesM;
+    Uint64 next_startM;
+    size_t voices_stolenM;
 
-    ma_uint64 length_in_frames;
     ma_uint32 sample_rate;
+
+    Voice* find_voice(Uint64 owner);
+    const Voice* find_voice(Uint64 owner) const;
+    Voice& pick_voice();
+    bool is_pending(const Voice& voice) const;
+    void cancel_fade_out(Voice& voice);
+    bool bind_voice(Voice& voice, std::shared_ptr<const Sound> source);
+    void release_voice(Voice& voice);
+    void init_device(const AudioOptions& options);
+    void uninit_device();
 };
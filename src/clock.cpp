@@ -0,0 +1,118 @@
+#include "clock.hpp"
+#include <SDL3/SDL_timer.h>
+#include <chrono>
+
+#ifdef __linux__
+#include <time.h>
+#endif
+
+namespace {
+
+#ifdef __linux__
+constexpr ClockMode default_clock_mode = ClockMode::Boottime;
+#else
+constexpr ClockMode default_clock_mode = ClockMode::Monotonic;
+#endif
+
+ClockMode clock_mode = default_clock_mode;
+
+// readings of the clocks counting from process start or boot begin this far
+// in, so a timer restored from the journal can be backdated further than
+// that without going below 0
+constexpr Uint64 uptime_base_ms = Uint64 {1} << 40;
+
+// added to every reading, only moved by clock_simulate_suspend
+Uint64 simulated_offset_ms = 0;
+Uint64 simulated_pending_ms = 0;
+
+// last readings used to detect suspends
+Uint64 last_monotonic_ms = 0;
+Uint64 last_selected_ms = 0;
+
+Uint64 read_raw_clock_ns(ClockMode mode) {
+    constexpr Uint64 uptime_base_ns = uptime_base_ms * 1'000'000;
+    switch (mode) {
+        case ClockMode::Monotonic:
+            return uptime_base_ns + SDL_GetTicksNS();
+
+        case ClockMode::Boottime: {
+#ifdef __linux__
+            timespec ts;
+            if (clock_gettime(CLOCK_BOOTTIME, &ts) == 0)
+                return uptime_base_ns + static_cast<Uint64>(ts.tv_sec) * 1'000'000'000 + ts.tv_nsec;
+#endif
+            // no boot clock on this platform, SDL's clock is the best we have
+            return uptime_base_ns + SDL_GetTicksNS();
+        }
+
+        case ClockMode::WallClock: {
+            auto since_epoch = std::chrono::system_clock::now().time_since_epoch();
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(since_epoch).count();
+        }
+    }
+    return SDL_GetTicksNS();
+}
+
+Uint64 read_raw_clock_ms(ClockMode mode) {
+    return read_raw_clock_ns(mode) / 1'000'000;
+}
+
+}
+
+std::optional<ClockMode> parse_clock_mode(std::string_view name) {
+    if (name == "monotonic")
+        return ClockMode::Monotonic;
+    else if (name == "boottime")
+        return ClockMode::Boottime;
+    else if (name == "wall")
+        return ClockMode::WallClock;
+    return std::nullopt;
+}
+
+void set_clock_mode(ClockMode mode) {
+    clock_mode = mode;
+    last_monotonic_ms = 0;
+    last_selected_ms = 0;
+}
+
+ClockMode get_clock_mode() {
+    return clock_mode;
+}
+
+Uint64 clock_now_ms() {
+    Uint64 now = read_raw_clock_ms(clock_mode) + simulated_offset_ms;
+    // 0 means "not started" everywhere in the timers
+    return now != 0 ? now : 1;
+}
+
+Uint64 clock_now_ns() {
+    Uint64 now = read_raw_clock_ns(clock_mode) + simulated_offset_ms * 1'000'000;
+    return now != 0 ? now : 1;
+}
+
+Uint64 clock_take_suspended_ms() {
+    constexpr Uint64 min_suspend_ms = 1000;
+
+    Uint64 monotonic = SDL_GetTicks();
+    Uint64 selected = clock_now_ms();
+    Uint64 suspended = simulated_pending_ms;
+    simulated_pending_ms = 0;
+
+    if (last_selected_ms != 0 && clock_mode != ClockMode::Monotonic) {
+        Uint64 monotonic_delta = monotonic - last_monotonic_ms;
+        // the simulated part was already counted above
+        Uint64 selected_delta = selected - last_selected_ms - suspended;
+        if (selected > last_selected_ms + suspended && selected_delta > monotonic_delta + min_suspend_ms)
+            suspended += selected_delta - monotonic_delta;
+    }
+
+    last_monotonic_ms = monotonic;
+    last_selected_ms = selected;
+
+    return suspended;
+}
+
+void clock_simulate_suspend(Uint64 ms) {
+    simulated_offset_ms += ms;
+    simulated_pending_ms += ms;
+}
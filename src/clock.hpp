@@ -0,0 +1,35 @@
+#pragma once
+
+#include <SDL3/SDL_stdinc.h>
+#include <optional>
+#include <string_view>
+
+enum class ClockMode {
+    // SDL_GetTicks, stops counting while the system is suspended
+    Monotonic,
+    // CLOCK_BOOTTIME, keeps counting while the system is suspended
+    Boottime,
+    // system wall clock, deadlines are absolute times of day
+    WallClock
+};
+
+// Parses "monotonic", "boottime" or "wall"
+std::optional<ClockMode> parse_clock_mode(std::string_view name);
+
+// Must be called before any timer is started, timestamps taken on one
+// clock mean nothing on another
+void set_clock_mode(ClockMode mode);
+ClockMode get_clock_mode();
+
+// Current time in milliseconds on the selected clock, never 0
+Uint64 clock_now_ms();
+// The same clock in nanoseconds, for stopwatch laps
+Uint64 clock_now_ns();
+
+// Milliseconds the selected clock jumped ahead of the monotonic clock since
+// the last call, i.e. how long the system was suspended. Jumps shorter than
+// a second are ignored so scheduling jitter doesn't count as a suspend.
+Uint64 clock_take_suspended_ms();
+
+// Moves the clock forward as if the system had been suspended for `ms`
+void clock_simulate_suspend(Uint64 ms);
@@ -0,0 +1,253 @@
+#include "control_client.hpp"
+#include "control_server.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <format>
+#include <memory>
+#include <optional>
+#include <print>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+// Blocking connection to a control socket, read a line at a time
+class Connection {
+public:
+    ~Connection() {
+        if (fdM != -1)
+            close(fdM);
+    }
+
+    // Gives up on reads that take longer than `ms`
+    void set_timeout(int ms) {
+        timeval tv {ms / 1000, (ms % 1000) * 1000};
+        setsockopt(fdM, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    }
+
+    bool connect(const std::string& path) {
+        sockaddr_un addr {};
+        addr.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(addr.sun_path))
+            return false;
+        path.copy(addr.sun_path, path.size());
+
+        fdM = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        return fdM != -1 && ::connect(fdM, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+    }
+
+    bool send_all(std::string_view data) {
+        while (!data.empty()) {
+            ssize_t sent = send(fdM, data.data(), data.size(), MSG_NOSIGNAL);
+            if (sent <= 0)
+                return false;
+            data.remove_prefix(sent);
+        }
+        return true;
+    }
+
+    // The next line without its newline, nullopt once the server hung up
+    std::optional<std::string> read_line() {
+        size_t end;
+        while ((end = bufferM.find('\n', startM)) == std::string::npos) {
+            bufferM.erase(0, startM);
+            startM = 0;
+            char chunk[4096];
+            ssize_t read = recv(fdM, chunk, sizeof(chunk), 0);
+            if (read <= 0)
+                return std::nullopt;
+            bufferM.append(chunk, read);
+        }
+        std::string line = bufferM.substr(startM, end - startM);
+        startM = end + 1;
+        return line;
+    }
+
+private:
+    int fdM = -1;
+    std::string bufferM;
+    size_t startM = 0;
+};
+
+// Number of answers `commands` gets, one per command
+size_t count_commands(std::string_view commands, bool& subscribes) {
+    size_t count = 0;
+    while (!commands.empty()) {
+        size_t end = commands.find_first_of(";\n");
+        std::string_view command = commands.substr(0, end);
+        size_t first = command.find_first_not_of(' ');
+        if (first != std::string_view::npos) {
+            count++;
+            if (command.substr(first).starts_with("subscribe"))
+                subscribes = true;
+        }
+        commands.remove_prefix(end == std::string_view::npos ? commands.size() : end + 1);
+    }
+    return count;
+}
+
+bool is_answer(std::string_view line) {
+    return line.starts_with("ok") || line.starts_with("error");
+}
+
+// Sends `batch` and waits for its `answers`, false if the connection broke
+bool round_trip(Connection& connection, const std::string& batch, size_t answers) {
+    if (!connection.send_all(batch))
+        return false;
+    while (answers > 0) {
+        auto line = connection.read_line();
+        if (!line.has_value())
+            return false;
+        if (is_answer(*line))
+            answers--;
+    }
+    return true;
+}
+
+}
+
+bool run_control_client(const std::string& commands) {
+    std::string path = control_socket_path();
+    Connection connection;
+    if (!connection.connect(path)) {
+        std::println(stderr, "No Timepad instance is listening on {}", path);
+        return false;
+    }
+
+    bool subscribes = false;
+    size_t answers = count_commands(commands, subscribes);
+    if (!connection.send_all(commands + "\n"))
+        return false;
+
+    bool ok = true;
+    while (answers > 0 || subscribes) {
+        auto line = connection.read_line();
+        if (!line.has_value())
+            break;
+        if (is_answer(*line)) {
+            answers--;
+            ok = ok && line->starts_with("ok");
+        }
+        std::println("{}", *line);
+        std::fflush(stdout);
+    }
+    return ok && answers == 0;
+}
+
+LaunchForward forward_launch(int argc, char* argv[]) {
+    Connection connection;
+    if (!connection.connect(control_socket_path()))
+        return LaunchForward::NotRunning;
+
+    std::string command = "launch";
+    for (int i = 1; i < argc; i++)
+        command += std::format(" {}", escape_argument(argv[i]));
+
+    // the running instance answers on its next frame, unless it's stuck
+    connection.set_timeout(2000);
+    if (!connection.send_all(command + "\n"))
+        return LaunchForward::NotRunning;
+    auto answer = connection.read_line();
+    if (!answer.has_value() || *answer == "error headless")
+        return LaunchForward::NotRunning;
+    if (!answer->starts_with("ok")) {
+        std::println(stderr, "The running instance didn't take the arguments: {}", *answer);
+        return LaunchForward::Refused;
+    }
+    return LaunchForward::Forwarded;
+}
+
+bool run_control_benchmark(const char* sound_path, int commands) {
+    std::unique_ptr<TimerService> service;
+    try {
+        service.reset(new TimerService {.audio_player = {sound_path, AudioOptions {.no_device = true}}});
+    } catch (const std::runtime_error& e) {
+        std::println(stderr, "Control benchmark failed: {}", e.what());
+        return false;
+    }
+
+    std::string path = std::format("/tmp/timepad-bench-{}.sock", getpid());
+    ControlServer server;
+    if (!server.listen(path)) {
+        std::println(stderr, "Control benchmark failed: couldn't listen on {}", path);
+        return false;
+    }
+
+    std::atomic<bool> done = false;
+    std::thread server_thread([&] {
+        while (!done)
+            server.poll(*service, 10);
+    });
+
+    constexpr int timers = 100;
+    constexpr size_t batch_size = 64;
+    bool ok = false;
+    Connection connection;
+    if (connection.connect(path)) {
+        std::string create;
+        for (int i = 0; i < timers; i++)
+            create += std::format("create {}s bench {};", i + 1, i);
+        ok = connection.send_all(create + "\n");
+        std::vector<std::string> ids;
+        while (ok && ids.size() < timers) {
+            auto line = connection.read_line();
+            ok = line.has_value() && line->starts_with("ok ");
+            if (ok)
+                ids.push_back(line->substr(3));
+        }
+
+        auto query = [&](int i) {
+            return "query " + ids[i % timers];
+        };
+        auto measure = [&](size_t per_round_trip) {
+            auto start = std::chrono::steady_clock::now();
+            for (int sent = 0; ok && sent < commands; sent += per_round_trip) {
+                std::string batch;
+                for (size_t i = 0; i < per_round_trip; i++)
+                    batch += query(sent + i) + (i + 1 < per_round_trip ? ";" : "\n");
+                ok = round_trip(connection, batch, per_round_trip);
+            }
+            std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+            return commands / seconds.count();
+        };
+
+        double single = measure(1);
+        double batched = measure(batch_size);
+        if (ok)
+            std::println("Control socket over loopback: {:.0f} commands/s one per round trip, {:.0f} commands/s in batches of {}",
+                         single, batched, batch_size);
+    }
+
+    done = true;
+    server_thread.join();
+    if (!ok)
+        std::println(stderr, "Control benchmark failed: lost the connection to the server");
+    return ok;
+}
+
+#else
+
+bool run_control_client(const std::string&) {
+    std::println(stderr, "The control socket is only available on Linux");
+    return false;
+}
+
+bool run_control_benchmark(const char*, int) {
+    std::println(stderr, "The control socket is only available on Linux");
+    return false;
+}
+
+LaunchForward forward_launch(int, char*[]) {
+    return LaunchForward::NotRunning;
+}
+
+#endif
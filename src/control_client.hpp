@@ -0,0 +1,30 @@
+#pragma once
+
+#include <string>
+
+// Sends `commands` to the control socket of the running instance and prints
+// every answer. After a subscribe it keeps printing events until the
+// instance goes away. Returns false if nothing is listening or a command
+// failed.
+bool run_control_client(const std::string& commands);
+
+// Measures how many commands per second the control socket gets through
+// over loopback, one command per round trip and in batches. The server runs
+// on a thread of this process against a TimerService with the audio engine
+// off the device, so it needs neither a sound card nor a running instance.
+// Prints the results and returns false if the socket couldn't be set up.
+bool run_control_benchmark(const char* sound_path, int commands);
+
+enum class LaunchForward {
+    // nothing is running, or only the daemon, which has no window to show
+    NotRunning,
+    Forwarded,
+    // the running instance answered with an error
+    Refused
+};
+
+// Hands the command line over to an instance that's already running, which
+// starts any --timer it names and raises its window, so launching the app
+// twice doesn't give two of everything. NotRunning if this process should
+// start up itself.
+LaunchForward forward_launch(int argc, char* argv[]);
@@ -0,0 +1,459 @@
+#include "control_server.hpp"
+#include "clock.hpp"
+#include <charconv>
+#include <cstdio>
+#include <cstdlib>
+#include <format>
+
+#ifdef __linux__
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// a client that sends this much without a newline is dropped
+constexpr size_t max_line_bytes = 64 * 1024;
+// and so is one that leaves this much of its answers and events unread
+constexpr size_t max_backlog_bytes = 1024 * 1024;
+
+std::string_view next_word(std::string_view& line) {
+    size_t start = line.find_first_not_of(' ');
+    if (start == std::string_view::npos) {
+        line = {};
+        return {};
+    }
+    line.remove_prefix(start);
+    size_t end = line.find(' ');
+    std::string_view word = line.substr(0, end);
+    line.remove_prefix(end == std::string_view::npos ? line.size() : end);
+    return word;
+}
+
+template <typename T>
+std::optional<T> parse_number(std::string_view text) {
+    T value {};
+    auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (ec != std::errc() || end != text.data() + text.size())
+        return std::nullopt;
+    return value;
+}
+
+std::optional<SlotHandle> parse_id(std::string_view text) {
+    if (text == "pomodoro")
+        return pomodoro_timer_handle;
+    auto key = parse_number<Uint64>(text);
+    if (!key.has_value())
+        return std::nullopt;
+    return SlotHandle::from_key(*key);
+}
+
+std::string format_id(SlotHandle handle) {
+    return handle == pomodoro_timer_handle ? "pomodoro" : std::to_string(handle.to_key());
+}
+
+const char* timer_state(const TimerDisplay& timer, const TimerFrame& frame) {
+    if (!timer.is_started())
+        return "stopped";
+    if (frame.done)
+        return "done";
+    return timer.is_paused() ? "paused" : "running";
+}
+
+void append_timer(std::string& out, SlotHandle handle, const TimerDisplay& timer, Uint64 now) {
+    TimerFrame frame = compute_timer_frame(timer.get_timing(), now);
+    out += std::format("timer {} {} {} {}\n", format_id(handle), timer_state(timer, frame), frame.remaining_ms, timer.get_label());
+}
+
+// Every timer named by the remaining words, "all" for every timer and the
+// pomodoro. False if one of them doesn't exist.
+bool collect_ids(TimerService& service, std::string_view line, std::vector<SlotHandle>& out) {
+    for (std::string_view word = next_word(line); !word.empty(); word = next_word(line)) {
+        if (word == "all") {
+            for (size_t i = 0; i < service.timers.size(); i++)
+                out.push_back(service.timers.handle_at(i));
+            if (service.pomodoro_timer.has_value())
+                out.push_back(pomodoro_timer_handle);
+            continue;
+        }
+
+        auto handle = parse_id(word);
+        if (!handle.has_value() || get_timer(service, *handle) == nullptr)
+            return false;
+        out.push_back(*handle);
+    }
+    return true;
+}
+
+// resident set size from /proc, 0 where there's no such thing
+size_t read_rss_kb() {
+#ifdef __linux__
+    FILE* statm = std::fopen("/proc/self/statm", "r");
+    if (statm == nullptr)
+        return 0;
+    unsigned long size = 0, resident = 0;
+    int read = std::fscanf(statm, "%lu %lu", &size, &resident);
+    std::fclose(statm);
+    return read == 2 ? resident * (sysconf(_SC_PAGESIZE) / 1024) : 0;
+#else
+    return 0;
+#endif
+}
+
+}
+
+std::string control_socket_path() {
+    const char* runtime_dir = std::getenv("XDG_RUNTIME_DIR");
+    if (runtime_dir != nullptr && *runtime_dir != '\0')
+        return std::string(runtime_dir) + "/timepad.sock";
+#ifdef __linux__
+    // no runtime dir outside of a login session, fall back to one per user
+    return std::format("/tmp/timepad-{}.sock", getuid());
+#else
+    return "timepad.sock";
+#endif
+}
+
+std::string escape_argument(std::string_view arg) {
+    std::string word;
+    for (char c : arg) {
+        if (c == '%' || c == ' ' || c == ';' || c == '\n' || c == '\r') {
+            word += '%';
+            word += "0123456789ABCDEF"[c >> 4];
+            word += "0123456789ABCDEF"[c & 0xF];
+        } else
+            word += c;
+    }
+    return word;
+}
+
+std::string unescape_argument(std::string_view word) {
+    std::string arg;
+    for (size_t i = 0; i < word.size(); i++) {
+        unsigned char c = 0;
+        if (word[i] == '%' && i + 2 < word.size() &&
+            std::from_chars(word.data() + i + 1, word.data() + i + 3, c, 16).ptr == word.data() + i + 3) {
+            arg += static_cast<char>(c);
+            i += 2;
+        } else
+            arg += word[i];
+    }
+    return arg;
+}
+
+bool ControlServer::take_raise_request() {
+    bool requested = raise_requestedM;
+    raise_requestedM = false;
+    return requested;
+}
+
+void ControlServer::run_line(TimerService& service, Client& client, std::string_view line) {
+    while (!line.empty()) {
+        size_t end = line.find(';');
+        std::string_view command = line.substr(0, end);
+        if (command.find_first_not_of(' ') != std::string_view::npos)
+            run_command(service, client, command);
+        line.remove_prefix(end == std::string_view::npos ? line.size() : end + 1);
+    }
+}
+
+void ControlServer::run_command(TimerService& service, Client& client, std::string_view line) {
+    std::string& out = client.out;
+    std::string_view command = next_word(line);
+    Uint64 now = clock_now_ms();
+
+    if (command == "create") {
+        auto seconds = parse_duration_s(next_word(line));
+        if (!seconds.has_value() || *seconds <= 0) {
+            out += "error expected a duration like 25m or 90s\n";
+            return;
+        }
+        TimerDisplay timer {*seconds};
+        size_t label = line.find_first_not_of(' ');
+        if (label != std::string_view::npos)
+            timer.set_label(std::string(line.substr(label)));
+        out += std::format("ok {}\n", format_id(add_timer(service, timer)));
+    } else if (command == "start" || command == "pause" || command == "reset") {
+        idsM.clear();
+        if (!collect_ids(service, line, idsM) || idsM.empty()) {
+            out += "error no such timer\n";
+            return;
+        }
+        for (SlotHandle handle : idsM) {
+            TimerDisplay* timer = get_timer(service, handle);
+            if (command == "start" && timer->is_started() && timer->is_done()) {
+                // a timer that rang runs again from the top
+                timer->reset(service.audio_player);
+                timer->start();
+            } else if (command == "start" && !timer->is_started())
+                timer->start();
+            else if (command == "start")
+                timer->resume();
+            else if (command == "pause")
+                timer->pause();
+            else
+                timer->reset(service.audio_player);
+            sync_timer_events(service, handle);
+        }
+        out += std::format("ok {}\n", idsM.size());
+    } else if (command == "query") {
+        idsM.clear();
+        if (line.find_first_not_of(' ') == std::string_view::npos)
+            collect_ids(service, "all", idsM);
+        else if (!collect_ids(service, line, idsM)) {
+            out += "error no such timer\n";
+            return;
+        }
+        for (SlotHandle handle : idsM)
+            append_timer(out, handle, *get_timer(service, handle), now);
+        out += std::format("ok {}\n", idsM.size());
+    } else if (command == "pomodoro") {
+        auto work = parse_duration_s(next_word(line));
+        auto rest = parse_duration_s(next_word(line));
+        auto repeat = parse_number<int>(next_word(line));
+        if (!work.has_value() || !rest.has_value() || !repeat.has_value() || *work <= 0 || *rest <= 0 ||
+            *repeat <= 0) {
+            out += "error expected pomodoro <work> <break> <repeat>\n";
+            return;
+        }
+        service.pomodoro_timer.emplace(*work, *rest, *repeat);
+        service.pomodoro_timer->get_timer().start();
+        sync_timer_events(service, pomodoro_timer_handle);
+        out += "ok pomodoro\n";
+    } else if (command == "intervals") {
+        std::string error;
+        auto steps = parse_interval_sequence(line, error);
+        if (!steps.has_value()) {
+            out += std::format("error {}\n", error);
+            return;
+        }
+        size_t first = line.find_first_not_of(' ');
+        service.pomodoro_timer.emplace(std::string(line.substr(first)), PomodoroSchedule {*steps});
+        service.pomodoro_timer->get_timer().start();
+        sync_timer_events(service, pomodoro_timer_handle);
+        out += "ok pomodoro\n";
+    } else if (command == "launch") {
+        // the window the new launch is after isn't here
+        if (headlessM) {
+            out += "error headless\n";
+            return;
+        }
+        // only --timer means anything to an instance that's already running
+        std::vector<int> durations;
+        for (std::string_view arg = next_word(line); !arg.empty(); arg = next_word(line)) {
+            if (unescape_argument(arg) != "--timer")
+                continue;
+            auto seconds = parse_duration_s(unescape_argument(next_word(line)));
+            if (!seconds.has_value() || *seconds <= 0) {
+                out += "error expected a duration like 25m or 90s after --timer\n";
+                return;
+            }
+            durations.push_back(*seconds);
+        }
+        for (int seconds : durations)
+            start_new_timer(service, seconds);
+        raise_requestedM = true;
+        out += "ok\n";
+    } else if (command == "subscribe") {
+        client.subscribed = true;
+        out += "ok\n";
+    } else if (command == "stats") {
+        Uint64 elapsed_ms = now - started_msM;
+        Uint64 per_minute = elapsed_ms != 0 ? wakeupsM * 60'000 / elapsed_ms : 0;
+        out += std::format("ok rss_kb={} wakeups_per_min={}\n", read_rss_kb(), per_minute);
+    } else {
+        out += std::format("error unknown command \"{}\"\n", command);
+    }
+}
+
+#ifdef __linux__
+
+ControlServer::~ControlServer() {
+    for (auto& [fd, client] : clientsM)
+        ::close(fd);
+    if (listen_fdM != -1) {
+        ::close(listen_fdM);
+        ::unlink(pathM.c_str());
+    }
+    if (epoll_fdM != -1)
+        ::close(epoll_fdM);
+}
+
+bool ControlServer::listen(const std::string& path) {
+    sockaddr_un addr {};
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path))
+        return false;
+    path.copy(addr.sun_path, path.size());
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd == -1)
+        return false;
+
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == -1) {
+        // a socket nobody answers on is left over from a crash
+        int probe = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        bool in_use = ::connect(probe, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+        ::close(probe);
+        if (in_use || ::unlink(path.c_str()) == -1 || ::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == -1) {
+            ::close(fd);
+            return false;
+        }
+    }
+
+    if (::listen(fd, SOMAXCONN) == -1) {
+        ::close(fd);
+        ::unlink(path.c_str());
+        return false;
+    }
+
+    epoll_fdM = ::epoll_create1(EPOLL_CLOEXEC);
+    epoll_event ev {};
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    ::epoll_ctl(epoll_fdM, EPOLL_CTL_ADD, fd, &ev);
+
+    listen_fdM = fd;
+    pathM = path;
+    started_msM = clock_now_ms();
+    return true;
+}
+
+void ControlServer::poll(TimerService& service, int timeout_ms) {
+    if (epoll_fdM == -1)
+        return;
+
+    epoll_event events[32];
+    int count = ::epoll_wait(epoll_fdM, events, 32, timeout_ms);
+    for (int i = 0; i < count; i++) {
+        int fd = events[i].data.fd;
+        if (fd == listen_fdM) {
+            accept_clients();
+            continue;
+        }
+
+        auto it = clientsM.find(fd);
+        if (it == clientsM.end())
+            continue;
+        if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+            close_client(fd);
+            continue;
+        }
+        if (events[i].events & EPOLLOUT)
+            flush_client(it->second);
+        if (events[i].events & EPOLLIN)
+            read_client(service, it->second);
+    }
+}
+
+void ControlServer::accept_clients() {
+    while (true) {
+        int fd = ::accept4(listen_fdM, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd == -1)
+            return;
+
+        epoll_event ev {};
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        ev.data.fd = fd;
+        ::epoll_ctl(epoll_fdM, EPOLL_CTL_ADD, fd, &ev);
+        clientsM.emplace(fd, Client {fd, {}, {}, false});
+    }
+}
+
+void ControlServer::read_client(TimerService& service, Client& client) {
+    char buffer[4096];
+    bool closed = false;
+    while (true) {
+        ssize_t read = ::recv(client.fd, buffer, sizeof(buffer), 0);
+        if (read > 0) {
+            client.in.append(buffer, read);
+            continue;
+        }
+        closed = read == 0 || (errno != EAGAIN && errno != EWOULDBLOCK);
+        break;
+    }
+
+    size_t start = 0;
+    for (size_t end; (end = client.in.find('\n', start)) != std::string::npos; start = end + 1) {
+        std::string_view line(client.in.data() + start, end - start);
+        if (!line.empty() && line.back() == '\r')
+            line.remove_suffix(1);
+        if (!line.empty())
+            run_line(service, client, line);
+    }
+    client.in.erase(0, start);
+
+    if (client.in.size() > max_line_bytes)
+        closed = true;
+
+    flush_client(client);
+    if (client.out.size() > max_backlog_bytes)
+        closed = true;
+    // answers to a client that hung up after sending are still delivered
+    // as far as the socket takes them, there's nobody left to wait for
+    if (closed)
+        close_client(client.fd);
+}
+
+void ControlServer::flush_client(Client& client) {
+    size_t sent = 0;
+    while (sent < client.out.size()) {
+        ssize_t n = ::send(client.fd, client.out.data() + sent, client.out.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0)
+            break;
+        sent += n;
+    }
+    client.out.erase(0, sent);
+
+    // only ask to hear about the socket draining while there's a backlog
+    epoll_event ev {};
+    ev.events = EPOLLIN | EPOLLRDHUP | (client.out.empty() ? 0 : EPOLLOUT);
+    ev.data.fd = client.fd;
+    ::epoll_ctl(epoll_fdM, EPOLL_CTL_MOD, client.fd, &ev);
+}
+
+void ControlServer::publish_expired(TimerService& service) {
+    if (service.expired.empty())
+        return;
+
+    std::string events;
+    for (const DueEvent& ev : service.expired)
+        events += std::format("event expired {} {}\n", format_id(SlotHandle::from_key(ev.id)), ev.deadline_ms);
+    service.expired.clear();
+
+    for (auto it = clientsM.begin(); it != clientsM.end();) {
+        Client& client = (it++)->second;
+        if (!client.subscribed)
+            continue;
+        client.out += events;
+        flush_client(client);
+        if (client.out.size() > max_backlog_bytes)
+            close_client(client.fd);
+    }
+}
+
+void ControlServer::close_client(int fd) {
+    ::epoll_ctl(epoll_fdM, EPOLL_CTL_DEL, fd, nullptr);
+    ::close(fd);
+    clientsM.erase(fd);
+}
+
+#else
+
+ControlServer::~ControlServer() {}
+
+bool ControlServer::listen(const std::string&) {
+    return false;
+}
+
+void ControlServer::poll(TimerService&, int) {}
+
+void ControlServer::publish_expired(TimerService& service) {
+    service.expired.clear();
+}
+
+#endif
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "timer_service.hpp"
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Where the control socket lives, $XDG_RUNTIME_DIR/timepad.sock
+std::string control_socket_path();
+
+// Command line arguments as one word of a command, with '%', spaces, ';'
+// and line breaks written as %XX so "1h 30m" stays one argument
+std::string escape_argument(std::string_view arg);
+// The argument escape_argument() made `word` from
+std::string unescape_argument(std::string_view word);
+
+// Serves the control socket scripts use to drive the timers. Commands are
+// lines of text and every one is answered with a line starting with "ok"
+// or "error":
+//
+//   create <duration> [label]   ok <id>
+//   start <id>...               starts or resumes the timers, timers that
+//                               rang start again, ok <count>
+//   pause <id>...
+//   reset <id>...
+//   query [<id>...]             one "timer <id> <state> <remaining ms> <label>"
+//                               line per timer, then ok <count>
+//   pomodoro <work> <break> <repeat>
+//   intervals <sequence>        starts an interval session like
+//                               "warm-up 5m, 4x(work 25m, rest 5m), cool-down 5m"
+//   subscribe                   "event expired <id> <deadline ms>" lines follow
+//                               whenever a timer runs out
+//   stats                       ok rss_kb=<n> wakeups_per_min=<n>
+//   launch <arg>...             the command line of a second start of the
+//                               app, escaped, see forward_launch. A server
+//                               without a window answers "error headless".
+//
+// The pomodoro's id is "pomodoro" and "all" stands for every timer. A line
+// can hold several commands separated by ';', and everything a client sent
+// is answered in one go, so a batch of commands costs one round trip.
+// Clients are non-blocking and served from an epoll instance of the
+// server's own, its fd can be waited on by whatever loop the server runs
+// under, and a client that doesn't read its answers never holds it up.
+// Only available on Linux.
+class ControlServer {
+public:
+    ControlServer() = default;
+    ~ControlServer();
+
+    ControlServer(const ControlServer&) = delete;
+    ControlServer& operator=(const ControlServer&) = delete;
+
+    // Listens on `path`, false if another instance is already serving it
+    // or it can't be bound
+    bool listen(const std::string& path);
+
+    // Readable whenever poll() has something to do
+    int get_fd() const { return epoll_fdM; }
+
+    // Accepts clients and answers their commands, waiting up to
+    // `timeout_ms` for them, 0 doesn't wait at all
+    void poll(TimerService& service, int timeout_ms);
+
+    // Sends the timers that ran out to the subscribed clients, and takes
+    // them out of the service either way
+    void publish_expired(TimerService& service);
+
+    // Counts one pass of the loop the server runs under, reported by "stats"
+    void count_wakeup() { wakeupsM++; }
+
+    // True once after a second start of the app asked for the window
+    bool take_raise_request();
+    // Set for a server with no window to raise, which leaves second
+    // starts of the app to open their own
+    void set_headless(bool headless) { headlessM = headless; }
+
+private:
+    struct Client {
+        int fd;
+        std::string in;
+        std::string out;
+        bool subscribed;
+    };
+
+    int listen_fdM = -1;
+    int epoll_fdM = -1;
+    std::string pathM;
+    std::unordered_map<int, Client> clientsM;
+    Uint64 wakeupsM = 0;
+    Uint64 started_msM = 0;
+    bool raise_requestedM = false;
+    bool headlessM = false;
+    // scratch space for the ids a command names
+    std::vector<SlotHandle> idsM;
+
+    void accept_clients();
+    void read_client(TimerService& service, Client& client);
+    void flush_client(Client& client);
+    void close_client(int fd);
+    void run_line(TimerService& service, Client& client, std::string_view line);
+    void run_command(TimerService& service, Client& client, std::string_view command_line);
+};
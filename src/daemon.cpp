@@ -0,0 +1,136 @@
+#include "daemon.hpp"
+#include "clock.hpp"
+#include "control_server.hpp"
+#include <algorithm>
+#include <print>
+
+#ifdef __linux__
+#include <csignal>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+namespace {
+
+// the wall clock can be changed under a sleeping timerfd, so in that mode
+// the daemon looks at it at least this often
+constexpr Uint64 wall_clock_recheck_ms = 60 * 1000;
+
+// Arms `timer_fd` to go off once `next_ms` comes up, or disarms it
+void arm_wakeup(int timer_fd, std::optional<Uint64> next_ms, Uint64 now) {
+    std::optional<Uint64> wait_ms;
+    if (next_ms.has_value())
+        wait_ms = *next_ms > now ? *next_ms - now : 0;
+    if (get_clock_mode() == ClockMode::WallClock)
+        wait_ms = std::min(wait_ms.value_or(wall_clock_recheck_ms), wall_clock_recheck_ms);
+
+    itimerspec spec {};
+    if (wait_ms.has_value()) {
+        // a zero it_value would disarm the timer instead
+        Uint64 ns = std::max<Uint64>(*wait_ms * 1'000'000, 1);
+        spec.it_value.tv_sec = ns / 1'000'000'000;
+        spec.it_value.tv_nsec = ns % 1'000'000'000;
+    }
+    timerfd_settime(timer_fd, 0, &spec, nullptr);
+}
+
+// Arms `alarm_fd` for the wall time the soonest alarm goes off at, or
+// disarms it. It also goes off when the system time is set, so alarms
+// don't ring late or early after the clock was changed.
+void arm_alarm_wakeup(int alarm_fd, std::optional<Sint64> next_ms) {
+    itimerspec spec {};
+    if (next_ms.has_value()) {
+        // a zero it_value would disarm the timer instead
+        Sint64 ms = std::max<Sint64>(*next_ms, 1);
+        spec.it_value.tv_sec = ms / 1000;
+        spec.it_value.tv_nsec = ms % 1000 * 1'000'000;
+    }
+    timerfd_settime(alarm_fd, TFD_TIMER_ABSTIME | TFD_TIMER_CANCEL_ON_SET, &spec, nullptr);
+}
+
+}
+
+bool run_daemon(TimerService& service) {
+    ControlServer server;
+    std::string path = control_socket_path();
+    if (!server.listen(path)) {
+        std::println(stderr, "Couldn't listen on {}, is another instance running?", path);
+        return false;
+    }
+    // a second launch opens a window of its own rather than coming here
+    server.set_headless(true);
+
+    // CLOCK_BOOTTIME keeps counting through a suspend, so deadlines that
+    // passed while the system slept are handled as soon as it wakes up
+    int timer_fd = timerfd_create(get_clock_mode() == ClockMode::Monotonic ? CLOCK_MONOTONIC : CLOCK_BOOTTIME,
+                                  TFD_NONBLOCK | TFD_CLOEXEC);
+    // alarms are wall clock times, however many there are only the
+    // soonest one is armed
+    int alarm_fd = timerfd_create(CLOCK_REALTIME, TFD_NONBLOCK | TFD_CLOEXEC);
+
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    sigprocmask(SIG_BLOCK, &signals, nullptr);
+    int signal_fd = signalfd(-1, &signals, SFD_NONBLOCK | SFD_CLOEXEC);
+
+    // the alarms move with the time zone as soon as it changes
+    int zone_fd = service.alarms.get_time_zone().get_change_fd();
+
+    int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    for (int fd : {server.get_fd(), timer_fd, alarm_fd, signal_fd, zone_fd}) {
+        if (fd < 0)
+            continue;
+        epoll_event ev {};
+        ev.events = EPOLLIN;
+        ev.data.fd = fd;
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+    }
+
+    std::println("Timepad daemon listening on {}", path);
+
+    bool running = true;
+    while (running) {
+        Uint64 now = clock_now_ms();
+        tick_timers(service, now);
+        server.publish_expired(service);
+        service.audio_player.suspend_if_idle();
+        arm_wakeup(timer_fd, next_timer_event_ms(service), now);
+        arm_alarm_wakeup(alarm_fd, next_alarm_ms(service));
+
+        epoll_event events[5];
+        int count = epoll_wait(epoll_fd, events, 5, -1);
+        server.count_wakeup();
+        for (int i = 0; i < count; i++) {
+            int fd = events[i].data.fd;
+            if (fd == signal_fd) {
+                running = false;
+            } else if (fd == timer_fd || fd == alarm_fd || fd == zone_fd) {
+                // fails with ECANCELED after the time was set, which only
+                // needs the alarms looked at again
+                uint64_t expirations;
+                [[maybe_unused]] auto read_bytes = read(fd, &expirations, sizeof(expirations));
+            } else {
+                server.poll(service, 0);
+            }
+        }
+    }
+
+    close(epoll_fd);
+    close(signal_fd);
+    close(timer_fd);
+    close(alarm_fd);
+    sigprocmask(SIG_UNBLOCK, &signals, nullptr);
+    return true;
+}
+
+#else
+
+bool run_daemon(TimerService&) {
+    std::println(stderr, "Daemon mode is only available on Linux");
+    return false;
+}
+
+#endif
@@ -0,0 +1,11 @@
+#pragma once
+
+#include "timer_service.hpp"
+
+// Runs the timers without any window, renderer or ImGui context until
+// SIGINT or SIGTERM, driven through the control socket (see
+// ControlServer). The process sleeps in epoll_wait until either the next
+// deadline in the service's queues or a command comes in, so an idle
+// daemon doesn't wake up at all. Returns false if the control socket
+// couldn't be set up, for example because another instance has it.
+bool run_daemon(TimerService& service);
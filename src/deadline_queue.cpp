@@ -0,0 +1,70 @@
+#include "deadline_queue.hpp"
+#include <algorithm>
+
+namespace {
+
+// std heap functions build a max-heap, so order by later deadline
+bool later(const DueEvent& a, const DueEvent& b) {
+    return a.deadline_ms > b.deadline_ms;
+}
+
+}
+
+void DeadlineQueue::schedule(Uint64 id, Uint64 deadline_ms) {
+    liveM[id] = deadline_ms;
+    heapM.push_back({deadline_ms, id});
+    std::push_heap(heapM.begin(), heapM.end(), later);
+
+    if (heapM.size() > 2 * liveM.size() + 64)
+        compact();
+}
+
+void DeadlineQueue::reserve(size_t count) {
+    heapM.reserve(count);
+    liveM.reserve(count);
+}
+
+void DeadlineQueue::cancel(Uint64 id) {
+    liveM.erase(id);
+}
+
+size_t DeadlineQueue::pop_due(Uint64 now_ms, std::vector<DueEvent>& out) {
+    size_t popped = 0;
+    while (!heapM.empty() && heapM.front().deadline_ms <= now_ms) {
+        std::pop_heap(heapM.begin(), heapM.end(), later);
+        DueEvent ev = heapM.back();
+        heapM.pop_back();
+
+        if (is_stale(ev))
+            continue;
+
+        liveM.erase(ev.id);
+        out.push_back(ev);
+        popped++;
+    }
+    return popped;
+}
+
+std::optional<Uint64> DeadlineQueue::next_deadline() {
+    drop_stale_top();
+    if (heapM.empty())
+        return std::nullopt;
+    return heapM.front().deadline_ms;
+}
+
+bool DeadlineQueue::is_stale(const DueEvent& ev) const {
+    auto it = liveM.find(ev.id);
+    return it == liveM.end() || it->second != ev.deadline_ms;
+}
+
+void DeadlineQueue::drop_stale_top() {
+    while (!heapM.empty() && is_stale(heapM.front())) {
+        std::pop_heap(heapM.begin(), heapM.end(), later);
+        heapM.pop_back();
+    }
+}
+
+void DeadlineQueue::compact() {
+    std::erase_if(heapM, [this](const DueEvent& ev) { return is_stale(ev); });
+    std::make_heap(heapM.begin(), heapM.end(), later);
+}
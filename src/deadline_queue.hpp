@@ -0,0 +1,38 @@
+#pragma once
+
+#include <SDL3/SDL_stdinc.h>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+struct DueEvent {
+    Uint64 deadline_ms;
+    Uint64 id;
+};
+
+// Min-heap of deadlines keyed by timer id. Rescheduling or cancelling an id
+// leaves its old entry in the heap, stale entries are skipped when popped,
+// so every operation is O(log n) no matter how many timers exist.
+class DeadlineQueue {
+public:
+    // Sets the deadline of `id`, replacing any earlier one
+    void schedule(Uint64 id, Uint64 deadline_ms);
+    void cancel(Uint64 id);
+    // Makes room for `count` ids, so scheduling them moves nothing
+    void reserve(size_t count);
+
+    // Moves every event due at `now_ms` into `out`, earliest first.
+    // Returns the number of events moved.
+    size_t pop_due(Uint64 now_ms, std::vector<DueEvent>& out);
+
+    std::optional<Uint64> next_deadline();
+    size_t size() const { return liveM.size(); }
+
+private:
+    std::vector<DueEvent> heapM;
+    std::unordered_map<Uint64, Uint64> liveM;
+
+    bool is_stale(const DueEvent& ev) const;
+    void drop_stale_top();
+    void compact();
+};
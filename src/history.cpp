@@ -0,0 +1,384 @@
+#include "history.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <print>
+#include <random>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr Sint64 ms_per_hour = 60 * 60 * 1000;
+
+struct LogHeader {
+    char magic[4];
+    Uint32 record_bytes;
+    // records past this were never finished
+    Uint64 count;
+    char reserved[48];
+};
+static_assert(sizeof(LogHeader) == sizeof(HistoryRecord));
+
+struct IndexHeader {
+    char magic[4];
+    Uint32 reserved0;
+    Sint64 first_hour;
+    Uint64 hours;
+    // records that are in the index, the ones after it get added on open
+    Uint64 indexed;
+    char reserved[32];
+};
+static_assert(sizeof(IndexHeader) == 64);
+
+LogHeader& get_log_header(MappedFile& file) {
+    return *reinterpret_cast<LogHeader*>(file.data());
+}
+
+const LogHeader& get_log_header(const MappedFile& file) {
+    return *reinterpret_cast<const LogHeader*>(file.data());
+}
+
+IndexHeader& get_index_header(MappedFile& file) {
+    return *reinterpret_cast<IndexHeader*>(file.data());
+}
+
+const IndexHeader& get_index_header(const MappedFile& file) {
+    return *reinterpret_cast<const IndexHeader*>(file.data());
+}
+
+Uint64* get_index_buckets(MappedFile& file) {
+    return reinterpret_cast<Uint64*>(file.data() + sizeof(IndexHeader));
+}
+
+const Uint64* get_index_buckets(const MappedFile& file) {
+    return reinterpret_cast<const Uint64*>(file.data() + sizeof(IndexHeader));
+}
+
+// Rounds towards negative infinity, unlike /
+Sint64 get_hour(Sint64 ms) {
+    return ms >= 0 ? ms / ms_per_hour : -((-ms + ms_per_hour - 1) / ms_per_hour);
+}
+
+}
+
+bool HistoryStore::open(const std::string& directory) {
+    directoryM = directory;
+    if (!logM.open(directory + "/history", sizeof(LogHeader)))
+        return false;
+
+    LogHeader& log = get_log_header(logM);
+    if (log.magic[0] == '\0') {
+        std::memcpy(log.magic, "TPH2", 4);
+        log.record_bytes = sizeof(HistoryRecord);
+        log.count = 0;
+    } else if ((std::memcmp(log.magic, "TPH2", 4) != 0 && std::memcmp(log.magic, "TPH1", 4) != 0) ||
+               log.record_bytes != sizeof(HistoryRecord)) {
+        return false;
+    }
+    log.count = std::min<Uint64>(log.count, (logM.size() - sizeof(LogHeader)) / sizeof(HistoryRecord));
+    if (std::memcmp(log.magic, "TPH1", 4) == 0) {
+        // the first version had 4 more bytes of label where the extra
+        // nanoseconds are now, doing this twice after a crash is harmless
+        for (size_t i = 0; i < log.count; i++) {
+            auto* record = reinterpret_cast<HistoryRecord*>(logM.data() + sizeof(LogHeader) + i * sizeof(HistoryRecord));
+            record->label[sizeof(record->label) - 1] = '\0';
+            record->duration_extra_ns = 0;
+        }
+        std::memcpy(log.magic, "TPH2", 4);
+    }
+
+    if (!indexM.open(directory + "/history.idx", sizeof(IndexHeader)))
+        return false;
+
+    IndexHeader& index = get_index_header(indexM);
+    bool index_valid = std::memcmp(index.magic, "TPI1", 4) == 0 && index.indexed <= log.count &&
+                       sizeof(IndexHeader) + index.hours * sizeof(Uint64) <= indexM.size();
+    if (!index_valid) {
+        std::memcpy(index.magic, "TPI1", 4);
+        index.first_hour = 0;
+        index.hours = 0;
+        index.indexed = 0;
+    }
+    for (size_t i = get_index_header(indexM).indexed; i < get_log_header(logM).count; i++)
+        index_record(i);
+
+    if (!statsM.open(directory + "/history.stats"))
+        return false;
+    if (statsM.get_record_count() > size())
+        statsM.clear();
+    for (size_t i = statsM.get_record_count(); i < size(); i++)
+        statsM.add((*this)[i]);
+    return true;
+}
+
+void HistoryStore::append(HistoryKind kind, bool completed, Sint64 end_ms, Uint64 duration_ms, std::string_view label,
+                          Uint32 duration_extra_ns) {
+    if (!is_open())
+        return;
+
+    size_t count = get_log_header(logM).count;
+    if (!logM.reserve(sizeof(LogHeader) + (count + 1) * sizeof(HistoryRecord)))
+        return;
+    if (count > 0)
+        end_ms = std::max(end_ms, (*this)[count - 1].end_ms);
+
+    HistoryRecord record{};
+    record.start_ms = end_ms - static_cast<Sint64>(duration_ms);
+    record.end_ms = end_ms;
+    record.duration_ms = duration_ms;
+    record.kind = kind;
+    record.completed = completed;
+    record.duration_extra_ns = duration_extra_ns;
+    label = label.substr(0, sizeof(record.label) - 1);
+    std::memcpy(record.label, label.data(), label.size());
+    std::memcpy(logM.data() + sizeof(LogHeader) + count * sizeof(HistoryRecord), &record, sizeof(record));
+
+    // the record has to be in place before the count says it's there
+    std::atomic_signal_fence(std::memory_order_release);
+    get_log_header(logM).count = count + 1;
+    index_record(count);
+    statsM.add(record);
+}
+
+size_t HistoryStore::size() const {
+    return logM.is_open() ? get_log_header(logM).count : 0;
+}
+
+const HistoryRecord& HistoryStore::operator[](size_t index) const {
+    return *reinterpret_cast<const HistoryRecord*>(logM.data() + sizeof(LogHeader) + index * sizeof(HistoryRecord));
+}
+
+void HistoryStore::index_record(size_t index) {
+    Sint64 hour = get_hour((*this)[index].end_ms);
+    IndexHeader* header = &get_index_header(indexM);
+    if (header->hours == 0)
+        header->first_hour = hour;
+
+    // hours without records point at the next record there is, which makes
+    // every hour's records the range up to where the next hour starts
+    while (header->first_hour + static_cast<Sint64>(header->hours) <= hour) {
+        if (!indexM.reserve(sizeof(IndexHeader) + (header->hours + 1) * sizeof(Uint64)))
+            return;
+        header = &get_index_header(indexM);
+        get_index_buckets(indexM)[header->hours] = index;
+        header->hours++;
+    }
+    header->indexed = index + 1;
+}
+
+std::pair<size_t, size_t> HistoryStore::find_range(Sint64 from_ms, Sint64 to_ms) const {
+    if (!is_open() || to_ms <= from_ms)
+        return {0, 0};
+
+    const IndexHeader& header = get_index_header(indexM);
+    const Uint64* buckets = get_index_buckets(indexM);
+    auto get_bucket_start = [&](Sint64 hour) -> size_t {
+        if (hour < header.first_hour)
+            return 0;
+        if (hour - header.first_hour >= static_cast<Sint64>(header.hours))
+            return header.indexed;
+        return buckets[hour - header.first_hour];
+    };
+
+    // only the records of the hour `ms` falls into need to be looked at
+    auto get_first_ending_at = [&](Sint64 ms) -> size_t {
+        Sint64 hour = get_hour(ms);
+        size_t position = get_bucket_start(hour);
+        size_t end = get_bucket_start(hour + 1);
+        while (position < end && (*this)[position].end_ms < ms)
+            position++;
+        return position;
+    };
+    return {get_first_ending_at(from_ms), get_first_ending_at(to_ms)};
+}
+
+#ifdef __linux__
+
+HistoryReader::~HistoryReader() {
+    if (fdM >= 0)
+        close(fdM);
+}
+
+bool HistoryReader::open(const std::string& directory) {
+    fdM = ::open((directory + "/history").c_str(), O_RDONLY | O_CLOEXEC);
+    LogHeader header;
+    struct stat st;
+    if (fdM < 0 || fstat(fdM, &st) != 0 || pread(fdM, &header, sizeof(header), 0) != sizeof(header))
+        return false;
+    if (std::memcmp(header.magic, "TPH2", 4) != 0 || header.record_bytes != sizeof(HistoryRecord))
+        return false;
+    countM = std::min<Uint64>(header.count, (st.st_size - sizeof(LogHeader)) / sizeof(HistoryRecord));
+    return true;
+}
+
+bool HistoryReader::read(size_t first, size_t count, HistoryRecord* records) const {
+    if (first + count > countM)
+        return false;
+    size_t bytes = count * sizeof(HistoryRecord);
+    off_t offset = sizeof(LogHeader) + first * sizeof(HistoryRecord);
+    for (size_t done = 0; done < bytes;) {
+        ssize_t got = pread(fdM, reinterpret_cast<char*>(records) + done, bytes - done, offset + done);
+        if (got <= 0)
+            return false;
+        done += got;
+    }
+    return true;
+}
+
+#else
+
+HistoryReader::~HistoryReader() = default;
+
+bool HistoryReader::open(const std::string&) {
+    return false;
+}
+
+bool HistoryReader::read(size_t, size_t, HistoryRecord*) const {
+    return false;
+}
+
+#endif
+
+size_t HistoryReader::find_first_ending_at(Sint64 ms) const {
+    size_t first = 0;
+    size_t last = countM;
+    HistoryRecord record;
+    while (first < last) {
+        size_t middle = first + (last - first) / 2;
+        if (read(middle, 1, &record) && record.end_ms < ms)
+            first = middle + 1;
+        else
+            last = middle;
+    }
+    return first;
+}
+
+std::vector<float> get_daily_work_minutes(const HistoryStore& history, int days) {
+    std::vector<float> minutes(std::max(days, 0), 0.0f);
+    Sint64 today = get_local_today();
+    for (int i = 0; i < days; i++) {
+        Sint64 day = today - (days - 1 - i);
+        minutes[i] = static_cast<float>(history.get_stats().get_totals(day, day).work_ms) / 60000.0f;
+    }
+    return minutes;
+}
+
+bool run_history_benchmark() {
+    namespace fs = std::filesystem;
+    using clock = std::chrono::steady_clock;
+    auto get_us = [](clock::time_point start) {
+        return std::chrono::duration<double, std::micro>(clock::now() - start).count();
+    };
+
+    fs::path directory = fs::temp_directory_path() / std::format("timepad-history-bench-{}", clock::now().time_since_epoch().count());
+    std::error_code error;
+    fs::create_directories(directory, error);
+
+    constexpr Sint64 minute_ms = 60 * 1000;
+    constexpr Sint64 day_ms = 24 * 60 * minute_ms;
+    Sint64 today = get_local_today();
+    Sint64 first_day = today - 5 * 365;
+    std::mt19937 rng {42};
+    size_t records = 0;
+    double append_us = 0;
+    {
+        HistoryStore history;
+        if (!history.open(directory.string())) {
+            std::println(stderr, "History benchmark failed: couldn't open a history in {}", directory.string());
+            fs::remove_all(directory, error);
+            return false;
+        }
+
+        // a few pomodoro sessions most weekdays, some timers and the odd stopwatch
+        auto start = clock::now();
+        for (Sint64 day = first_day; day <= today; day++) {
+            bool weekend = (day + 4) % 7 == 0 || (day + 4) % 7 == 6;
+            if (weekend && rng() % 4 != 0)
+                continue;
+
+            Sint64 t = day * day_ms + 8 * 60 * minute_ms + rng() % (60 * minute_ms);
+            int repeat = 4 + rng() % 9;
+            for (int round = 1; round <= repeat; round++) {
+                bool stopped = rng() % 10 == 0;
+                Sint64 work_ms = stopped ? (5 + rng() % 15) * minute_ms : 25 * minute_ms;
+                t += work_ms;
+                history.append(HistoryKind::Work, !stopped, t, work_ms, std::format("Work {}/{}", round, repeat));
+                if (round < repeat) {
+                    t += 5 * minute_ms;
+                    history.append(HistoryKind::Break, true, t, 5 * minute_ms, std::format("Break {}/{}", round, repeat - 1));
+                }
+            }
+            for (unsigned timers = rng() % 3; timers > 0; timers--) {
+                t += 10 * minute_ms + rng() % (60 * minute_ms);
+                history.append(HistoryKind::Timer, true, t, 10 * minute_ms, "Tea");
+            }
+            if (rng() % 3 == 0)
+                history.append(HistoryKind::Stopwatch, true, t + 40 * minute_ms, 40 * minute_ms, "Stopwatch");
+        }
+        append_us = get_us(start);
+        records = history.size();
+    }
+
+    auto start = clock::now();
+    HistoryStore history;
+    bool ok = history.open(directory.string());
+    double open_us = get_us(start);
+
+    // what the stats tab shows, a handful of range sums and the streak
+    constexpr int rounds = 10'000;
+    const HistoryStats& stats = history.get_stats();
+    start = clock::now();
+    for (int i = 0; i < rounds; i++) {
+        stats.get_totals(today, today);
+        stats.get_totals(today - 6, today);
+        stats.get_totals(first_day, today);
+        stats.get_current_streak(today);
+        stats.get_longest_streak();
+    }
+    double query_ns = get_us(start) * 1000 / rounds;
+    start = clock::now();
+    get_daily_work_minutes(history, 90);
+    double chart_us = get_us(start);
+
+    // the totals have to agree with a pass over every record
+    HistoryTotals all = stats.get_totals(SDL_MIN_SINT64, SDL_MAX_SINT64);
+    Uint64 work_ms = 0;
+    Uint32 stopped = 0;
+    for (size_t i = 0; i < history.size(); i++) {
+        if (history[i].kind != HistoryKind::Work)
+            continue;
+        if (history[i].completed)
+            work_ms += history[i].duration_ms;
+        else
+            stopped++;
+    }
+    ok = ok && all.work_ms == work_ms && all.stopped_count == stopped;
+
+    // without the stats file they're rebuilt from the log, which is what
+    // every open would cost without them
+    fs::remove(directory / "history.stats", error);
+    start = clock::now();
+    HistoryStore rebuilt;
+    ok = ok && rebuilt.open(directory.string());
+    double rebuild_us = get_us(start);
+    ok = ok && rebuilt.get_stats().get_totals(SDL_MIN_SINT64, SDL_MAX_SINT64).work_ms == work_ms;
+
+    if (ok) {
+        std::println("History of {} records over 5 years: {:.2f} us per append, opened in {:.0f} us with its stats "
+                     "and {:.0f} us rebuilding them", records, append_us / records, open_us, rebuild_us);
+        std::println("Stats queries: {:.0f} ns for the day, week and all time totals and the streaks, "
+                     "{:.0f} us for the 90 day chart", query_ns, chart_us);
+    } else {
+        std::println(stderr, "History benchmark failed: the stats don't match the records");
+    }
+    fs::remove_all(directory, error);
+    return ok;
+}
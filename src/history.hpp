@@ -0,0 +1,106 @@
+#pragma once
+
+#include "history_stats.hpp"
+#include "mapped_file.hpp"
+#include <SDL3/SDL_stdinc.h>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+enum class HistoryKind : Uint8 {
+    Work, Break, Timer, Stopwatch, Lap
+};
+
+// One pomodoro phase, timer, stopwatch run or lap of one that finished or
+// was stopped early. Records are a fixed size so the log can be used as an array
+// straight out of the mapping.
+struct HistoryRecord {
+    // milliseconds since the epoch. end_ms never goes backwards from one
+    // record to the next, even when the system clock does
+    Sint64 start_ms;
+    Sint64 end_ms;
+    // how long it ran, not counting pauses
+    Uint64 duration_ms;
+    HistoryKind kind;
+    // false for work phases and timers that were reset before they ran out
+    bool completed;
+    // NUL terminated, cut off when longer
+    char label[34];
+    // the nanoseconds past duration_ms, only laps are timed that finely
+    Uint32 duration_extra_ns;
+};
+static_assert(sizeof(HistoryRecord) == 64);
+
+// Everything finished so far, kept in `directory` as an append-only log of
+// HistoryRecords next to an index of the records by the hour they ended in:
+//
+//   history       header, records
+//   history.idx   header, per hour since the first record the position
+//                 of the first record that ended in or after it
+//
+// Both are memory-mapped, so opening reads nothing but the headers and a
+// query only loads the pages of the hours it asks about. A record is
+// written before the count that makes it visible, so a crash can lose the
+// last record but never leave a torn one. The index and the HistoryStats
+// are rebuilt from the log when they're missing or behind. Only available
+// on Linux.
+class HistoryStore {
+public:
+    bool open(const std::string& directory);
+    bool is_open() const { return logM.is_open() && indexM.is_open() && statsM.is_open(); }
+    const std::string& get_directory() const { return directoryM; }
+
+    void append(HistoryKind kind, bool completed, Sint64 end_ms, Uint64 duration_ms, std::string_view label,
+                Uint32 duration_extra_ns = 0);
+
+    size_t size() const;
+    const HistoryRecord& operator[](size_t index) const;
+
+    // The records that ended in [from_ms, to_ms), as positions [first, last)
+    std::pair<size_t, size_t> find_range(Sint64 from_ms, Sint64 to_ms) const;
+
+    const HistoryStats& get_stats() const { return statsM; }
+
+private:
+    std::string directoryM;
+    MappedFile logM;
+    MappedFile indexM;
+    HistoryStats statsM;
+
+    void index_record(size_t index);
+};
+
+// Reads a history log without mapping or changing it, so it can run on
+// another thread or in another process while the owner keeps appending.
+// Only the records there were when it was opened are seen.
+class HistoryReader {
+public:
+    HistoryReader() = default;
+    ~HistoryReader();
+
+    HistoryReader(const HistoryReader&) = delete;
+    HistoryReader& operator=(const HistoryReader&) = delete;
+
+    bool open(const std::string& directory);
+    size_t size() const { return countM; }
+
+    // Reads `count` records starting at `first`
+    bool read(size_t first, size_t count, HistoryRecord* records) const;
+    // Position of the first record that ended at or after `ms`, a binary
+    // search since end times never go backwards
+    size_t find_first_ending_at(Sint64 ms) const;
+
+private:
+    int fdM = -1;
+    size_t countM = 0;
+};
+
+// Total minutes of work phases per day for the `days` days up to and
+// including today, oldest first, with days starting at local midnight
+std::vector<float> get_daily_work_minutes(const HistoryStore& history, int days);
+
+// Fills a history in a directory of its own with 5 years of made up
+// sessions and prints how long appending, opening and the stats' queries
+// take, for --history-benchmark
+bool run_history_benchmark();
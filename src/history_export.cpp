@@ -0,0 +1,342 @@
+#include "history_export.hpp"
+#include "history.hpp"
+#include "local_time.hpp"
+#include <SDL3/SDL_time.h>
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <iterator>
+#include <utility>
+
+#ifdef TIMEPAD_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace {
+
+constexpr Sint64 ms_per_hour = 60 * 60 * 1000;
+constexpr size_t records_per_read = 1024;
+constexpr size_t flush_bytes = 64 * 1024;
+
+// Writes ISO 8601 local times with their UTC offset. Looking the offset up
+// is the slow part, so it's looked up at both ends of each UTC hour of
+// records rather than for every timestamp, and only the hour of a change
+// looks up every one.
+class TimeFormatter {
+public:
+    void append(std::string& out, Sint64 wall_ms) {
+        Sint64 hour = divide_down(wall_ms, ms_per_hour);
+        if (hour != hourM) {
+            hourM = hour;
+            // zones change their offset at most once an hour, but not always
+            // on the hour in UTC, St. John's does at half past
+            offset_sM = get_utc_offset_s(hour * ms_per_hour);
+            steadyM = offset_sM == get_utc_offset_s((hour + 1) * ms_per_hour - 1);
+        }
+        int offset_s = steadyM ? offset_sM : get_utc_offset_s(wall_ms);
+
+        Sint64 local_ms = wall_ms + offset_s * 1000LL;
+        Sint64 days = divide_down(local_ms, ms_per_day);
+        Sint64 seconds = (local_ms - days * ms_per_day) / 1000;
+        CivilDate date = get_civil_from_days(days);
+        int offset_minutes = std::abs(offset_s) / 60;
+        std::format_to(std::back_inserter(out), "{:04}-{:02}-{:02}T{:02}:{:02}:{:02}{}{:02}:{:02}", date.year, date.month,
+                       date.day, seconds / 3600, seconds / 60 % 60, seconds % 60, offset_s < 0 ? '-' : '+',
+                       offset_minutes / 60, offset_minutes % 60);
+    }
+
+private:
+    Sint64 hourM = SDL_MIN_SINT64;
+    // the offset at the start of the hour, and whether it lasts all of it
+    int offset_sM = 0;
+    bool steadyM = true;
+};
+
+const char* get_kind_name(HistoryKind kind) {
+    switch (kind) {
+        case HistoryKind::Work: return "work";
+        case HistoryKind::Break: return "break";
+        case HistoryKind::Timer: return "timer";
+        case HistoryKind::Stopwatch: return "stopwatch";
+        case HistoryKind::Lap: return "lap";
+    }
+    return "unknown";
+}
+
+void append_csv_field(std::string& out, std::string_view text) {
+    out += '"';
+    for (char c : text) {
+        if (c == '"')
+            out += '"';
+        out += c;
+    }
+    out += '"';
+}
+
+void append_json_string(std::string& out, std::string_view text) {
+    out += '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            std::format_to(std::back_inserter(out), "\\u{:04x}", c);
+        } else {
+            out += c;
+        }
+    }
+    out += '"';
+}
+
+// Collects the formatted output and writes it out in big chunks, through
+// gzip when asked to. The file only gets its real name in finish(), one
+// that's never finished is removed.
+class ExportSink {
+public:
+    ~ExportSink() {
+        close();
+        if (!finishedM && !temporary_pathM.empty())
+            std::remove(temporary_pathM.c_str());
+    }
+
+    bool open(const std::string& path, bool gzip, std::string& error) {
+        pathM = path;
+        temporary_pathM = path + ".part";
+        bufferM.reserve(flush_bytes + 1024);
+        if (gzip) {
+#ifdef TIMEPAD_HAVE_ZLIB
+            gzM = gzopen(temporary_pathM.c_str(), "wb");
+#else
+            error = "gzip export isn't available, Timepad was built without zlib";
+            return false;
+#endif
+        } else {
+            fileM = std::fopen(temporary_pathM.c_str(), "wb");
+            if (fileM != nullptr)
+                std::setvbuf(fileM, nullptr, _IONBF, 0);
+        }
+        if (fileM == nullptr && !has_gzip()) {
+            error = std::format("Couldn't create {}", temporary_pathM);
+            return false;
+        }
+        return true;
+    }
+
+    std::string& get_buffer() { return bufferM; }
+
+    bool flush_if_full(std::string& error) {
+        return bufferM.size() < flush_bytes || flush(error);
+    }
+
+    bool finish(std::string& error) {
+        if (!flush(error) || !close()) {
+            if (error.empty())
+                error = std::format("Couldn't write {}", temporary_pathM);
+            return false;
+        }
+        std::error_code rename_error;
+        std::filesystem::rename(temporary_pathM, pathM, rename_error);
+        if (rename_error) {
+            error = std::format("Couldn't rename {} to {}: {}", temporary_pathM, pathM, rename_error.message());
+            return false;
+        }
+        finishedM = true;
+        return true;
+    }
+
+private:
+    std::string pathM;
+    std::string temporary_pathM;
+    std::string bufferM;
+    std::FILE* fileM = nullptr;
+#ifdef TIMEPAD_HAVE_ZLIB
+    gzFile gzM = nullptr;
+#endif
+    bool finishedM = false;
+
+    bool has_gzip() const {
+#ifdef TIMEPAD_HAVE_ZLIB
+        return gzM != nullptr;
+#else
+        return false;
+#endif
+    }
+
+    bool flush(std::string& error) {
+        bool ok = true;
+#ifdef TIMEPAD_HAVE_ZLIB
+        if (gzM != nullptr)
+            ok = bufferM.empty() || gzwrite(gzM, bufferM.data(), static_cast<unsigned>(bufferM.size())) > 0;
+#endif
+        if (fileM != nullptr)
+            ok = std::fwrite(bufferM.data(), 1, bufferM.size(), fileM) == bufferM.size();
+        if (!ok)
+            error = std::format("Couldn't write {}", temporary_pathM);
+        bufferM.clear();
+        return ok;
+    }
+
+    bool close() {
+        bool ok = true;
+#ifdef TIMEPAD_HAVE_ZLIB
+        if (gzM != nullptr)
+            ok = gzclose(gzM) == Z_OK;
+        gzM = nullptr;
+#endif
+        if (fileM != nullptr)
+            ok = std::fclose(fileM) == 0;
+        fileM = nullptr;
+        return ok;
+    }
+};
+
+}
+
+std::optional<Sint64> parse_export_time(std::string_view text, bool end_of_day) {
+    bool has_time = text.size() == 16;
+    if ((text.size() != 10 && !has_time) || text[4] != '-' || text[7] != '-')
+        return std::nullopt;
+    if (has_time && ((text[10] != 'T' && text[10] != ' ') || text[13] != ':'))
+        return std::nullopt;
+
+    auto parse = [&](size_t start, size_t length, int& value) {
+        auto [end, ec] = std::from_chars(text.data() + start, text.data() + start + length, value);
+        return ec == std::errc() && end == text.data() + start + length;
+    };
+    int year, month, day, hour = 0, minute = 0;
+    if (!parse(0, 4, year) || !parse(5, 2, month) || !parse(8, 2, day))
+        return std::nullopt;
+    if (has_time && (!parse(11, 2, hour) || !parse(14, 2, minute)))
+        return std::nullopt;
+    if (month < 1 || month > 12 || day < 1 || day > SDL_GetDaysInMonth(year, month) || hour > 23 || minute > 59)
+        return std::nullopt;
+
+    Sint64 days = get_days_from_civil(year, month, day) + (end_of_day && !has_time ? 1 : 0);
+    return get_wall_ms_from_local(days, (hour * 60 + minute) * 60);
+}
+
+std::optional<Uint64> export_history(const std::string& directory, Sint64 from_ms, Sint64 to_ms, const std::string& path,
+                                     ExportProgress& progress, std::string& error) {
+    std::string_view name = path;
+    bool gzip = name.ends_with(".gz");
+    if (gzip)
+        name.remove_suffix(3);
+    bool json = name.ends_with(".json");
+
+    HistoryReader reader;
+    if (!reader.open(directory)) {
+        error = std::format("Couldn't read the history in {}", directory);
+        return std::nullopt;
+    }
+    size_t first = reader.find_first_ending_at(from_ms);
+    size_t last = std::max(first, reader.find_first_ending_at(to_ms));
+    progress.total = last - first;
+    progress.written = 0;
+
+    ExportSink sink;
+    if (!sink.open(path, gzip, error))
+        return std::nullopt;
+
+    std::string& out = sink.get_buffer();
+    out += json ? "[\n" : "kind,completed,label,start,end,duration_s\n";
+    TimeFormatter time_formatter;
+    std::array<HistoryRecord, records_per_read> records;
+    for (size_t position = first; position < last; position += records_per_read) {
+        size_t count = std::min(records_per_read, last - position);
+        if (!reader.read(position, count, records.data())) {
+            error = std::format("Couldn't read the history in {}", directory);
+            return std::nullopt;
+        }
+        if (progress.cancelled) {
+            error = "The export was cancelled";
+            return std::nullopt;
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            const HistoryRecord& record = records[i];
+            std::string_view label(record.label, strnlen(record.label, sizeof(record.label)));
+            if (json) {
+                std::format_to(std::back_inserter(out), "{}{{\"kind\":\"{}\",\"completed\":{},\"label\":",
+                               position + i == first ? "" : ",\n", get_kind_name(record.kind), record.completed);
+                append_json_string(out, label);
+                out += ",\"start\":\"";
+                time_formatter.append(out, record.start_ms);
+                out += "\",\"end\":\"";
+                time_formatter.append(out, record.end_ms);
+                // laps keep their nanoseconds
+                if (record.kind == HistoryKind::Lap)
+                    std::format_to(std::back_inserter(out), "\",\"duration_ms\":{}.{:06}}}", record.duration_ms,
+                                   record.duration_extra_ns);
+                else
+                    std::format_to(std::back_inserter(out), "\",\"duration_ms\":{}}}", record.duration_ms);
+            } else {
+                std::format_to(std::back_inserter(out), "{},{},", get_kind_name(record.kind), record.completed);
+                append_csv_field(out, label);
+                out += ',';
+                time_formatter.append(out, record.start_ms);
+                out += ',';
+                time_formatter.append(out, record.end_ms);
+                if (record.kind == HistoryKind::Lap)
+                    std::format_to(std::back_inserter(out), ",{}.{:03}{:06}\n", record.duration_ms / 1000,
+                                   record.duration_ms % 1000, record.duration_extra_ns);
+                else
+                    std::format_to(std::back_inserter(out), ",{}.{:03}\n", record.duration_ms / 1000,
+                                   record.duration_ms % 1000);
+            }
+            if (!sink.flush_if_full(error))
+                return std::nullopt;
+        }
+        progress.written = position + count - first;
+    }
+    if (json)
+        out += last > first ? "\n]\n" : "]\n";
+
+    if (!sink.finish(error))
+        return std::nullopt;
+    return last - first;
+}
+
+ExportJob::~ExportJob() {
+    progressM.cancelled = true;
+    if (threadM.joinable())
+        threadM.join();
+}
+
+bool ExportJob::start(std::string directory, Sint64 from_ms, Sint64 to_ms, std::string path) {
+    if (runningM)
+        return false;
+    if (threadM.joinable())
+        threadM.join();
+
+    resultM.reset();
+    progressM.total = 0;
+    progressM.written = 0;
+    progressM.cancelled = false;
+    runningM = true;
+    threadM = std::thread([this, directory = std::move(directory), from_ms, to_ms, path = std::move(path)] {
+        std::string error;
+        auto written = export_history(directory, from_ms, to_ms, path, progressM, error);
+        resultM = written.has_value() ? std::format("Exported {} records to {}", *written, path) : error;
+        runningM = false;
+    });
+    return true;
+}
+
+float ExportJob::get_progress() const {
+    Uint64 total = progressM.total;
+    if (total == 0)
+        return runningM ? 0.0f : 1.0f;
+    return static_cast<float>(progressM.written) / static_cast<float>(total);
+}
+
+std::optional<std::string> ExportJob::take_result() {
+    if (runningM || !threadM.joinable())
+        return std::nullopt;
+    threadM.join();
+    return std::exchange(resultM, std::nullopt);
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <SDL3/SDL_stdinc.h>
+#include <atomic>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+
+// Parses "2026-10-19" or "2026-10-19T14:30" in local time into
+// milliseconds since the epoch. A date alone means the start of the day,
+// or its end with `end_of_day`, so --from and --to can both take days.
+std::optional<Sint64> parse_export_time(std::string_view text, bool end_of_day);
+
+struct ExportProgress {
+    std::atomic<Uint64> total {0};
+    std::atomic<Uint64> written {0};
+    // checked between chunks, the unfinished file is removed
+    std::atomic<bool> cancelled {false};
+};
+
+// Streams the records of the history in `directory` that ended in
+// [from_ms, to_ms) to `path`, as CSV, or JSON when the path ends in .json,
+// gzip compressed when it ends in .gz. Records are read a chunk at a time
+// and formatted into a buffer of fixed size that's written out whenever
+// it fills up, so memory use is the same for ten records or ten million.
+// The history is only read, which is safe while the instance that owns it
+// keeps appending. The file is written next to `path` and renamed over it
+// once it's complete. Returns the number of records written, or nullopt
+// with `error` set.
+std::optional<Uint64> export_history(const std::string& directory, Sint64 from_ms, Sint64 to_ms, const std::string& path,
+                                     ExportProgress& progress, std::string& error);
+
+// Runs export_history on a thread of its own so the UI keeps drawing
+class ExportJob {
+public:
+    ExportJob() = default;
+    ~ExportJob();
+
+    ExportJob(const ExportJob&) = delete;
+    ExportJob& operator=(const ExportJob&) = delete;
+
+    // False while another export is running
+    bool start(std::string directory, Sint64 from_ms, Sint64 to_ms, std::string path);
+    bool is_running() const { return runningM; }
+    // Share of the records written so far, 0 to 1
+    float get_progress() const;
+    // What came of the last export once it finished, then nullopt until the next one
+    std::optional<std::string> take_result();
+
+private:
+    ExportProgress progressM;
+    std::thread threadM;
+    std::atomic<bool> runningM = false;
+    // written by the thread before it clears runningM
+    std::optional<std::string> resultM;
+};
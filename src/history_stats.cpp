@@ -0,0 +1,183 @@
+#include "history_stats.hpp"
+#include "history.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+struct StatsHeader {
+    char magic[4];
+    Uint32 entry_bytes;
+    Sint64 first_day;
+    Uint64 days;
+    Uint64 record_count;
+    Uint32 longest_streak;
+    char reserved[28];
+};
+static_assert(sizeof(StatsHeader) == 64);
+
+struct DayEntry {
+    // of this day and every one before it
+    HistoryTotals totals;
+    Uint32 streak;
+    Uint32 reserved;
+};
+static_assert(sizeof(DayEntry) == 64);
+
+StatsHeader& get_header(MappedFile& file) {
+    return *reinterpret_cast<StatsHeader*>(file.data());
+}
+
+const StatsHeader& get_header(const MappedFile& file) {
+    return *reinterpret_cast<const StatsHeader*>(file.data());
+}
+
+DayEntry* get_entries(MappedFile& file) {
+    return reinterpret_cast<DayEntry*>(file.data() + sizeof(StatsHeader));
+}
+
+const DayEntry* get_entries(const MappedFile& file) {
+    return reinterpret_cast<const DayEntry*>(file.data() + sizeof(StatsHeader));
+}
+
+void add_record(HistoryTotals& totals, const HistoryRecord& record) {
+    if (!record.completed) {
+        if (record.kind == HistoryKind::Work || record.kind == HistoryKind::Timer)
+            totals.stopped_count++;
+        return;
+    }
+    switch (record.kind) {
+        case HistoryKind::Work:
+            totals.work_ms += record.duration_ms;
+            totals.work_count++;
+            break;
+        case HistoryKind::Break:
+            totals.break_ms += record.duration_ms;
+            totals.break_count++;
+            break;
+        case HistoryKind::Timer:
+            totals.timer_ms += record.duration_ms;
+            totals.timer_count++;
+            break;
+        case HistoryKind::Stopwatch:
+            totals.stopwatch_ms += record.duration_ms;
+            totals.stopwatch_count++;
+            break;
+        case HistoryKind::Lap:
+            // already part of their stopwatch's run
+            break;
+    }
+}
+
+HistoryTotals subtract(HistoryTotals totals, const HistoryTotals& before) {
+    totals.work_ms -= before.work_ms;
+    totals.break_ms -= before.break_ms;
+    totals.timer_ms -= before.timer_ms;
+    totals.stopwatch_ms -= before.stopwatch_ms;
+    totals.work_count -= before.work_count;
+    totals.break_count -= before.break_count;
+    totals.timer_count -= before.timer_count;
+    totals.stopwatch_count -= before.stopwatch_count;
+    totals.stopped_count -= before.stopped_count;
+    return totals;
+}
+
+}
+
+bool HistoryStats::open(const std::string& path) {
+    if (!fileM.open(path, sizeof(StatsHeader)))
+        return false;
+
+    StatsHeader& header = get_header(fileM);
+    bool valid = std::memcmp(header.magic, "TPA1", 4) == 0 && header.entry_bytes == sizeof(DayEntry) &&
+                 sizeof(StatsHeader) + header.days * sizeof(DayEntry) <= fileM.size();
+    if (!valid)
+        clear();
+    return true;
+}
+
+Uint64 HistoryStats::get_record_count() const {
+    return is_open() ? get_header(fileM).record_count : 0;
+}
+
+void HistoryStats::clear() {
+    StatsHeader& header = get_header(fileM);
+    std::memcpy(header.magic, "TPA1", 4);
+    header.entry_bytes = sizeof(DayEntry);
+    header.first_day = 0;
+    header.days = 0;
+    header.record_count = 0;
+    header.longest_streak = 0;
+}
+
+void HistoryStats::add(const HistoryRecord& record) {
+    StatsHeader* header = &get_header(fileM);
+    Sint64 day = get_local_day(record.end_ms);
+    if (header->days == 0)
+        header->first_day = day;
+    // a time zone change can put a record on a day before the last one's
+    day = std::max(day, header->first_day + static_cast<Sint64>(header->days) - 1);
+
+    // days without records carry the totals of the day before them
+    while (header->first_day + static_cast<Sint64>(header->days) <= day) {
+        if (!fileM.reserve(sizeof(StatsHeader) + (header->days + 1) * sizeof(DayEntry)))
+            return;
+        header = &get_header(fileM);
+        DayEntry* entries = get_entries(fileM);
+        entries[header->days] = header->days > 0 ? entries[header->days - 1] : DayEntry {};
+        entries[header->days].streak = 0;
+        header->days++;
+    }
+
+    DayEntry* entries = get_entries(fileM);
+    DayEntry& entry = entries[header->days - 1];
+    const DayEntry* previous = header->days > 1 ? &entries[header->days - 2] : nullptr;
+    Uint32 work_before_today = previous != nullptr ? previous->totals.work_count : 0;
+    add_record(entry.totals, record);
+
+    // the first work of the day carries the streak on from the day before
+    if (entry.streak == 0 && entry.totals.work_count > work_before_today) {
+        entry.streak = (previous != nullptr ? previous->streak : 0) + 1;
+        header->longest_streak = std::max(header->longest_streak, entry.streak);
+    }
+    header->record_count++;
+}
+
+HistoryTotals HistoryStats::get_totals(Sint64 first_day, Sint64 last_day) const {
+    if (!is_open() || get_header(fileM).days == 0)
+        return {};
+
+    const StatsHeader& header = get_header(fileM);
+    const DayEntry* entries = get_entries(fileM);
+    first_day = std::max(first_day, header.first_day);
+    last_day = std::min(last_day, header.first_day + static_cast<Sint64>(header.days) - 1);
+    if (first_day > last_day)
+        return {};
+
+    const HistoryTotals& through_last = entries[last_day - header.first_day].totals;
+    if (first_day == header.first_day)
+        return through_last;
+    return subtract(through_last, entries[first_day - header.first_day - 1].totals);
+}
+
+Uint32 HistoryStats::get_current_streak(Sint64 today) const {
+    if (!is_open() || get_header(fileM).days == 0)
+        return 0;
+
+    const StatsHeader& header = get_header(fileM);
+    const DayEntry* entries = get_entries(fileM);
+    Sint64 last_day = header.first_day + static_cast<Sint64>(header.days) - 1;
+    if (today < header.first_day || today > last_day + 1)
+        return 0;
+    if (today == last_day + 1)
+        return entries[last_day - header.first_day].streak;
+
+    Uint32 streak = entries[today - header.first_day].streak;
+    if (streak == 0 && today > header.first_day)
+        streak = entries[today - header.first_day - 1].streak;
+    return streak;
+}
+
+Uint32 HistoryStats::get_longest_streak() const {
+    return is_open() ? get_header(fileM).longest_streak : 0;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "local_time.hpp"
+#include "mapped_file.hpp"
+#include <SDL3/SDL_stdinc.h>
+#include <string>
+
+struct HistoryRecord;
+
+// Sums over the finished records of a range of days
+struct HistoryTotals {
+    Uint64 work_ms;
+    Uint64 break_ms;
+    Uint64 timer_ms;
+    Uint64 stopwatch_ms;
+    Uint32 work_count;
+    Uint32 break_count;
+    Uint32 timer_count;
+    Uint32 stopwatch_count;
+    // work phases and timers that were reset before they ran out, their
+    // time isn't in the sums above
+    Uint32 stopped_count;
+    Uint32 reserved;
+};
+
+// Totals of the history per local day, kept up to date one record at a
+// time by the HistoryStore and persisted in a file of their own:
+//
+//   history.stats   header, per day since the first record the totals of
+//                   every day up to and including it, and the streak of
+//                   days with work that ends on it
+//
+// The totals of any range of days are the difference of two entries, so
+// nothing the stats show ever needs a pass over the history. Only available
+// on Linux.
+class HistoryStats {
+public:
+    bool open(const std::string& path);
+    bool is_open() const { return fileM.is_open(); }
+
+    // How many records of the history the totals cover, the HistoryStore
+    // adds the rest when it opens
+    Uint64 get_record_count() const;
+    void clear();
+    void add(const HistoryRecord& record);
+
+    HistoryTotals get_totals(Sint64 first_day, Sint64 last_day) const;
+    // Days in a row with work up to `today`, which doesn't break the
+    // streak before anything was worked on it
+    Uint32 get_current_streak(Sint64 today) const;
+    Uint32 get_longest_streak() const;
+
+private:
+    MappedFile fileM;
+};
@@ -0,0 +1,523 @@
+#include "journal.hpp"
+#include <SDL3/SDL_stdinc.h>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <print>
+#include <unordered_map>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr char journal_magic[4] = {'T', 'P', 'J', '1'};
+constexpr char snapshot_magic[4] = {'T', 'P', 'S', '1'};
+// payload size and CRC-32
+constexpr size_t record_header_bytes = 8;
+// no record comes close, anything bigger is garbage
+constexpr Uint32 max_record_bytes = 1 << 20;
+
+// SDL_crc32 goes bit by bit, slicing by 8 bytes with tables checks a big
+// snapshot on startup about 20 times faster
+constexpr auto crc32_tables = [] {
+    std::array<std::array<Uint32, 256>, 8> tables {};
+    for (Uint32 i = 0; i < 256; i++) {
+        Uint32 crc = i;
+        for (int bit = 0; bit < 8; bit++)
+            crc = (crc >> 1) ^ (crc & 1 ? 0xEDB88320u : 0);
+        tables[0][i] = crc;
+    }
+    for (Uint32 i = 0; i < 256; i++)
+        for (size_t t = 1; t < 8; t++)
+            tables[t][i] = (tables[t - 1][i] >> 8) ^ tables[0][tables[t - 1][i] & 0xFF];
+    return tables;
+}();
+
+Uint32 crc32(const char* data, size_t size) {
+    const auto& t = crc32_tables;
+    Uint32 crc = ~Uint32 {0};
+    for (; size >= 8; data += 8, size -= 8) {
+        Uint32 low, high;
+        std::memcpy(&low, data, 4);
+        std::memcpy(&high, data + 4, 4);
+        low ^= crc;
+        crc = t[7][low & 0xFF] ^ t[6][(low >> 8) & 0xFF] ^ t[5][(low >> 16) & 0xFF] ^ t[4][low >> 24] ^
+              t[3][high & 0xFF] ^ t[2][(high >> 8) & 0xFF] ^ t[1][(high >> 16) & 0xFF] ^ t[0][high >> 24];
+    }
+    for (; size > 0; data++, size--)
+        crc = t[0][(crc ^ static_cast<Uint8>(*data)) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+template <typename T>
+void put(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void encode_record(std::string& out, Uint64 sequence, const JournalRecord& record) {
+    size_t header = out.size();
+    out.resize(header + record_header_bytes);
+
+    put(out, sequence);
+    put(out, record.kind);
+    put(out, record.state);
+    put(out, record.id);
+    put(out, record.wall_ms);
+    put(out, record.elapsed_ms);
+    put(out, record.length_s);
+    put(out, record.break_s);
+    put(out, record.repeat);
+    for (const std::string* text : {&record.strings[0], &record.strings[1], &record.strings[2], &record.strings[3],
+                                    &record.sequence}) {
+        auto length = static_cast<Uint16>(std::min<size_t>(text->size(), SDL_MAX_UINT16));
+        put(out, length);
+        out.append(*text, 0, length);
+    }
+
+    auto size = static_cast<Uint32>(out.size() - header - record_header_bytes);
+    Uint32 crc = crc32(out.data() + header + record_header_bytes, size);
+    std::memcpy(out.data() + header, &size, sizeof(size));
+    std::memcpy(out.data() + header + sizeof(size), &crc, sizeof(crc));
+}
+
+// Bounds checked reads from a buffer, every read fails once one did
+class Reader {
+public:
+    Reader(const char* begin, const char* end) : posM {begin}, endM {end} {}
+
+    template <typename T>
+    bool get(T& value) {
+        if (!okM || static_cast<size_t>(endM - posM) < sizeof(T))
+            return okM = false;
+        std::memcpy(&value, posM, sizeof(T));
+        posM += sizeof(T);
+        return true;
+    }
+
+    bool get_string(std::string& text, size_t length) {
+        if (!okM || static_cast<size_t>(endM - posM) < length)
+            return okM = false;
+        text.assign(posM, length);
+        posM += length;
+        return true;
+    }
+
+    bool skip(size_t length) {
+        if (!okM || static_cast<size_t>(endM - posM) < length)
+            return okM = false;
+        posM += length;
+        return true;
+    }
+
+    bool ok() const { return okM; }
+    const char* pos() const { return posM; }
+    size_t left() const { return endM - posM; }
+
+private:
+    const char* posM;
+    const char* endM;
+    bool okM = true;
+};
+
+bool decode_payload(Reader& in, Uint64& sequence, JournalRecord& record) {
+    in.get(sequence);
+    in.get(record.kind);
+    in.get(record.state);
+    in.get(record.id);
+    in.get(record.wall_ms);
+    in.get(record.elapsed_ms);
+    in.get(record.length_s);
+    in.get(record.break_s);
+    in.get(record.repeat);
+    if (!in.ok() || record.kind > JournalKind::Alarm || record.state > JournalState::Removed)
+        return false;
+
+    for (std::string& text : record.strings) {
+        Uint16 length = 0;
+        in.get(length);
+        in.get_string(text, length);
+    }
+    // written since interval sequences, records from before end here
+    record.sequence.clear();
+    if (in.ok() && in.left() > 0) {
+        Uint16 length = 0;
+        in.get(length);
+        in.get_string(record.sequence, length);
+    }
+    return in.ok();
+}
+
+// What a record is about, the part of its payload that's read before
+// it's known whether the record is the object's latest
+struct RecordHeader {
+    Uint64 sequence;
+    JournalKind kind;
+    JournalState state;
+    Uint64 id;
+};
+
+// Checks the record at the reader's position and reads its header, false
+// if it's torn or corrupt. `payload` is left pointing at the whole payload.
+bool read_record(Reader& in, RecordHeader& header, Reader& payload) {
+    Uint32 size = 0, crc = 0;
+    if (!in.get(size) || !in.get(crc) || size > max_record_bytes || size > in.left())
+        return false;
+    if (crc32(in.pos(), size) != crc)
+        return false;
+
+    payload = Reader {in.pos(), in.pos() + size};
+    Reader fields = payload;
+    fields.get(header.sequence);
+    fields.get(header.kind);
+    fields.get(header.state);
+    fields.get(header.id);
+    if (!fields.ok() || header.kind > JournalKind::Alarm || header.state > JournalState::Removed)
+        return false;
+    return in.skip(size);
+}
+
+// Latest record of every object, kept in the order they first showed up.
+// Only where each record is gets kept, a record that's replaced later, as
+// most in the journal are, is never decoded any further than its header.
+class RecordSet {
+public:
+    void reserve(size_t count) {
+        entriesM.reserve(count);
+        indexM.reserve(count);
+    }
+
+    void apply(const RecordHeader& header, const Reader& payload) {
+        auto it = indexM.find({header.kind, header.id});
+        if (header.state == JournalState::Removed) {
+            // left in place and dropped by take()
+            if (it != indexM.end()) {
+                entriesM[it->second].removed = true;
+                indexM.erase(it);
+            }
+        } else if (it != indexM.end()) {
+            entriesM[it->second].payload = payload;
+        } else {
+            indexM.emplace(ObjectKey {header.kind, header.id}, entriesM.size());
+            entriesM.push_back({payload, false});
+        }
+    }
+
+    // Decodes the records that are left, the buffers their payloads are
+    // in have to still be around
+    std::vector<JournalRecord> take() {
+        std::vector<JournalRecord> records;
+        records.reserve(entriesM.size());
+        for (Entry& entry : entriesM) {
+            Uint64 sequence = 0;
+            if (!entry.removed && !decode_payload(entry.payload, sequence, records.emplace_back()))
+                records.pop_back();
+        }
+        return records;
+    }
+
+private:
+    struct ObjectKey {
+        JournalKind kind;
+        Uint64 id;
+        bool operator==(const ObjectKey&) const = default;
+    };
+    struct ObjectKeyHash {
+        size_t operator()(const ObjectKey& key) const {
+            return std::hash<Uint64> {}(key.id) ^ static_cast<size_t>(key.kind);
+        }
+    };
+    struct Entry {
+        Reader payload;
+        bool removed;
+    };
+
+    std::vector<Entry> entriesM;
+    std::unordered_map<ObjectKey, size_t, ObjectKeyHash> indexM;
+};
+
+#ifdef __linux__
+
+bool read_file(const std::string& path, std::string& out) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) == 0)
+        out.reserve(st.st_size);
+    char buffer[1 << 16];
+    ssize_t got;
+    while ((got = read(fd, buffer, sizeof(buffer))) > 0)
+        out.append(buffer, got);
+    close(fd);
+    return got == 0;
+}
+
+bool write_all(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = write(fd, data, size);
+        if (written < 0)
+            return false;
+        data += written;
+        size -= written;
+    }
+    return true;
+}
+
+#endif
+
+}
+
+std::optional<FsyncPolicy> parse_fsync_policy(std::string_view name) {
+    if (name == "always")
+        return FsyncPolicy::Always;
+    else if (name == "interval")
+        return FsyncPolicy::Interval;
+    else if (name == "never")
+        return FsyncPolicy::Never;
+    return std::nullopt;
+}
+
+Sint64 journal_wall_ms() {
+    auto since_epoch = std::chrono::system_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::milliseconds>(since_epoch).count();
+}
+
+std::string journal_directory() {
+    if (const char* state_home = std::getenv("XDG_STATE_HOME"); state_home != nullptr && *state_home != '\0')
+        return std::string(state_home) + "/timepad";
+    if (const char* home = std::getenv("HOME"); home != nullptr && *home != '\0')
+        return std::string(home) + "/.local/state/timepad";
+    return "timepad-state";
+}
+
+#ifdef __linux__
+
+Journal::~Journal() {
+    if (!is_open())
+        return;
+    {
+        std::lock_guard lock(mutexM);
+        stoppingM = true;
+    }
+    changedM.notify_one();
+    writerM.join();
+    close(fdM);
+    close(lock_fdM);
+}
+
+bool Journal::open(const std::string& directory, const JournalOptions& options) {
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+
+    lock_fdM = ::open((directory + "/lock").c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (lock_fdM < 0 || flock(lock_fdM, LOCK_EX | LOCK_NB) != 0) {
+        if (lock_fdM >= 0)
+            close(lock_fdM);
+        lock_fdM = -1;
+        return false;
+    }
+
+    int fd = ::open((directory + "/journal").c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0600);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0 ||
+        (st.st_size == 0 && !write_all(fd, journal_magic, sizeof(journal_magic)))) {
+        if (fd >= 0)
+            close(fd);
+        close(lock_fdM);
+        lock_fdM = -1;
+        return false;
+    }
+
+    fdM = fd;
+    directoryM = directory;
+    optionsM = options;
+    writerM = std::thread(&Journal::run_writer, this);
+    return true;
+}
+
+std::vector<JournalRecord> Journal::restore() {
+    if (!is_open())
+        return {};
+
+    // both are read up front, the records point into them until take()
+    std::string snapshot, journal;
+    bool has_snapshot = read_file(directoryM + "/snapshot", snapshot) &&
+                        snapshot.size() >= sizeof(snapshot_magic) + sizeof(Uint64) &&
+                        std::memcmp(snapshot.data(), snapshot_magic, sizeof(snapshot_magic)) == 0;
+    bool has_journal = read_file(directoryM + "/journal", journal) && journal.size() >= sizeof(journal_magic) &&
+                       std::memcmp(journal.data(), journal_magic, sizeof(journal_magic)) == 0;
+
+    RecordSet records;
+    // a timer's record takes up about 64 bytes, and most of the journal
+    // is the same timers again
+    records.reserve((has_snapshot ? snapshot.size() : 0) / 64 + (has_journal ? journal.size() : 0) / 128);
+    Uint64 snapshot_sequence = 0;
+    RecordHeader header;
+    Reader payload {nullptr, nullptr};
+
+    if (has_snapshot) {
+        Reader in {snapshot.data() + sizeof(snapshot_magic), snapshot.data() + snapshot.size()};
+        in.get(snapshot_sequence);
+        while (in.left() > 0 && read_record(in, header, payload))
+            records.apply(header, payload);
+    }
+    sequenceM = snapshot_sequence;
+
+    size_t good_bytes = sizeof(journal_magic);
+    if (has_journal) {
+        Reader in {journal.data() + sizeof(journal_magic), journal.data() + journal.size()};
+        while (in.left() > 0 && read_record(in, header, payload)) {
+            good_bytes = in.pos() - journal.data();
+            // left over from before the snapshot when a crash came between
+            // writing it and truncating the journal
+            if (header.sequence <= snapshot_sequence)
+                continue;
+            sequenceM = header.sequence;
+            records.apply(header, payload);
+        }
+    }
+
+    // whatever a crash tore off the end would hide every record after it
+    if (good_bytes < journal.size()) {
+        std::println(stderr, "Dropping {} bytes of torn or corrupt journal records", journal.size() - good_bytes);
+        if (ftruncate(fdM, good_bytes) != 0)
+            std::println(stderr, "Couldn't truncate the journal: {}", std::strerror(errno));
+    }
+    journal_bytesM = good_bytes;
+
+    return records.take();
+}
+
+void Journal::append(const JournalRecord& record) {
+    if (!is_open())
+        return;
+    {
+        std::lock_guard lock(mutexM);
+        size_t before = pendingM.size();
+        encode_record(pendingM, ++sequenceM, record);
+        journal_bytesM += pendingM.size() - before;
+    }
+    changedM.notify_one();
+}
+
+void Journal::compact(std::vector<JournalRecord> live) {
+    if (!is_open())
+        return;
+    {
+        std::lock_guard lock(mutexM);
+        snapshotM = std::move(live);
+        snapshot_sequenceM = sequenceM;
+        journal_bytesM = 0;
+    }
+    changedM.notify_one();
+}
+
+void Journal::write_snapshot(const std::vector<JournalRecord>& live, Uint64 sequence) {
+    std::string snapshot;
+    snapshot.reserve(sizeof(snapshot_magic) + sizeof(sequence) + live.size() * 96);
+    snapshot.append(snapshot_magic, sizeof(snapshot_magic));
+    put(snapshot, sequence);
+    for (const JournalRecord& record : live)
+        encode_record(snapshot, sequence, record);
+
+    bool sync = optionsM.fsync != FsyncPolicy::Never;
+    std::string path = directoryM + "/snapshot";
+    std::string temporary = path + ".tmp";
+
+    int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    bool written = fd >= 0 && write_all(fd, snapshot.data(), snapshot.size()) && (!sync || fsync(fd) == 0);
+    if (fd >= 0)
+        close(fd);
+    if (!written || rename(temporary.c_str(), path.c_str()) != 0) {
+        // the journal still has everything, so it's kept as it is
+        std::println(stderr, "Couldn't write the journal snapshot: {}", std::strerror(errno));
+        return;
+    }
+
+    // the rename has to be on disk before the journal it replaces is emptied
+    if (sync) {
+        int dir_fd = ::open(directoryM.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (dir_fd >= 0) {
+            fsync(dir_fd);
+            close(dir_fd);
+        }
+    }
+    if (ftruncate(fdM, sizeof(journal_magic)) != 0)
+        std::println(stderr, "Couldn't truncate the journal: {}", std::strerror(errno));
+}
+
+void Journal::run_writer() {
+    using namespace std::chrono;
+    auto interval = milliseconds(optionsM.fsync_interval_ms);
+    auto last_sync = steady_clock::time_point {};
+    bool unsynced = false;
+
+    std::unique_lock lock(mutexM);
+    while (true) {
+        auto has_work = [this] { return stoppingM || !pendingM.empty() || snapshotM.has_value(); };
+        // records written under the interval policy get synced once it's up
+        // even if nothing else comes in
+        if (unsynced && optionsM.fsync == FsyncPolicy::Interval)
+            changedM.wait_until(lock, last_sync + interval, has_work);
+        else
+            changedM.wait(lock, has_work);
+
+        std::string batch = std::move(pendingM);
+        pendingM.clear();
+        std::optional<std::vector<JournalRecord>> snapshot = std::move(snapshotM);
+        snapshotM.reset();
+        Uint64 snapshot_sequence = snapshot_sequenceM;
+        bool stopping = stoppingM;
+        lock.unlock();
+
+        if (snapshot.has_value())
+            write_snapshot(*snapshot, snapshot_sequence);
+        if (!batch.empty()) {
+            if (!write_all(fdM, batch.data(), batch.size()))
+                std::println(stderr, "Couldn't write to the journal: {}", std::strerror(errno));
+            unsynced = true;
+        }
+
+        auto now = steady_clock::now();
+        bool sync_due = optionsM.fsync == FsyncPolicy::Always ||
+                        (optionsM.fsync == FsyncPolicy::Interval && (stopping || now - last_sync >= interval));
+        if (unsynced && sync_due) {
+            fdatasync(fdM);
+            last_sync = now;
+            unsynced = false;
+        }
+
+        lock.lock();
+        if (stopping && pendingM.empty() && !snapshotM.has_value())
+            break;
+    }
+}
+
+#else
+
+Journal::~Journal() = default;
+
+bool Journal::open(const std::string&, const JournalOptions&) {
+    return false;
+}
+
+std::vector<JournalRecord> Journal::restore() {
+    return {};
+}
+
+void Journal::append(const JournalRecord&) {}
+
+void Journal::compact(std::vector<JournalRecord>) {}
+
+void Journal::run_writer() {}
+
+void Journal::write_snapshot(const std::vector<JournalRecord>&, Uint64) {}
+
+#endif
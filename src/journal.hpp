@@ -0,0 +1,140 @@
+#pragma once
+
+#include <SDL3/SDL_stdinc.h>
+#include <array>
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+enum class FsyncPolicy {
+    // every batch of records is on disk before the next one is written
+    Always,
+    // at most `fsync_interval_ms` of records are lost on a power cut
+    Interval,
+    // left to the OS, survives crashes of the app but not of the system
+    Never
+};
+
+// Parses "always", "interval" or "never"
+std::optional<FsyncPolicy> parse_fsync_policy(std::string_view name);
+
+struct JournalOptions {
+    FsyncPolicy fsync = FsyncPolicy::Interval;
+    Uint32 fsync_interval_ms = 1000;
+    // the journal is folded into a new snapshot once it grows past this
+    size_t compact_bytes = 1 << 20;
+};
+
+enum class JournalKind : Uint8 {
+    Timer, Stopwatch, Pomodoro, Alarm
+};
+
+enum class JournalState : Uint8 {
+    Idle, Running, Paused,
+    // a timer that ran out, it comes back reset
+    Expired,
+    // the object is gone
+    Removed
+};
+
+// What one timer, stopwatch or pomodoro looked like right after a state
+// transition. Progress is kept as the time run so far plus the system time
+// it was taken at, which unlike readings of the timers' clock still means
+// something after a reboot.
+struct JournalRecord {
+    JournalKind kind;
+    JournalState state;
+    // the object's SlotHandle key, the pomodoro's handle for the pomodoro
+    Uint64 id;
+    Sint64 wall_ms;
+    // alarms: the wall time they were going to go off at next, 0 for none
+    Uint64 elapsed_ms;
+    // timers: length, 0, 0. pomodoros: work, break and repeat, or 0 for a
+    // sequence. alarms:
+    // time of day, AlarmRepeat and the weekday mask or the interval in days
+    Sint32 length_s;
+    Sint32 break_s;
+    Sint32 repeat;
+    // timers: label and alarm sound. pomodoros: alarm sounds of work and
+    // break phases, then their start sounds. alarms: label, sound and the
+    // dates, or the first day for every n days
+    std::array<std::string, 4> strings;
+    // pomodoros: the interval sequence they were made from, empty for work,
+    // break and repeat. Older records end before it.
+    std::string sequence;
+};
+
+// Milliseconds since the epoch, for JournalRecord::wall_ms
+Sint64 journal_wall_ms();
+
+// Where the journal lives, $XDG_STATE_HOME/timepad or ~/.local/state/timepad
+std::string journal_directory();
+
+// Persists timers through crashes and restarts as an append-only log of
+// records next to a snapshot, in `directory`:
+//
+//   snapshot   "TPS1", sequence number of the last record it covers, records
+//   journal    "TPJ1", records
+//
+// where each record is its payload's size and CRC-32 followed by the
+// payload. Restoring reads the snapshot, then replays the journal records
+// newer than it, and stops at the first torn or corrupt record. Once the
+// journal is big enough the caller hands over the live records and they
+// become the new snapshot, which is written next to the old one and
+// renamed over it, so a crash at any point leaves a readable pair.
+//
+// append() only encodes the record into a buffer, a thread of its own
+// writes the buffer out in batches and syncs it as the FsyncPolicy says,
+// and encodes snapshots, so the UI thread never waits on the disk. Only
+// available on Linux, and only one process can have a directory open.
+class Journal {
+public:
+    Journal() = default;
+    ~Journal();
+
+    Journal(const Journal&) = delete;
+    Journal& operator=(const Journal&) = delete;
+
+    // Takes the directory's lock and starts the writer, false if another
+    // instance holds it or the files can't be opened
+    bool open(const std::string& directory, const JournalOptions& options);
+    bool is_open() const { return fdM >= 0; }
+
+    // Latest record of every object that wasn't removed, in the order
+    // they were first recorded
+    std::vector<JournalRecord> restore();
+
+    void append(const JournalRecord& record);
+
+    // True once enough was appended since the last snapshot
+    bool wants_compaction() const { return is_open() && journal_bytesM >= optionsM.compact_bytes; }
+    // Replaces everything recorded so far with `live`, which is encoded
+    // and written by the writer thread
+    void compact(std::vector<JournalRecord> live);
+
+private:
+    int fdM = -1;
+    int lock_fdM = -1;
+    std::string directoryM;
+    JournalOptions optionsM;
+    Uint64 sequenceM = 0;
+    // bytes appended since the last snapshot, on the caller's thread
+    size_t journal_bytesM = 0;
+
+    std::mutex mutexM;
+    std::condition_variable changedM;
+    // encoded records the writer hasn't picked up yet
+    std::string pendingM;
+    // the next snapshot and the sequence number it covers
+    std::optional<std::vector<JournalRecord>> snapshotM;
+    Uint64 snapshot_sequenceM = 0;
+    bool stoppingM = false;
+    std::thread writerM;
+
+    void run_writer();
+    void write_snapshot(const std::vector<JournalRecord>& live, Uint64 sequence);
+};
@@ -0,0 +1,194 @@
+#include "lap_store.hpp"
+#include <chrono>
+#include <format>
+#include <print>
+#include <random>
+#include <string>
+
+namespace {
+
+size_t default_capacity = 0;
+
+}
+
+LapStore::LapStore(size_t capacity)
+    : capacityM(capacity)
+    , headM(0)
+    , droppedM(0)
+    , base_split_nsM(0)
+{
+}
+
+void LapStore::set_default_capacity(size_t capacity) {
+    default_capacity = capacity;
+}
+
+size_t LapStore::get_default_capacity() {
+    return default_capacity;
+}
+
+void LapStore::add(Sint64 split_ns) {
+    Uint64 number = droppedM + splitsM.size() + 1;
+    Sint64 lap_ns = split_ns - (splitsM.empty() ? base_split_nsM : get_split_ns(splitsM.size() - 1));
+
+    if (capacityM != 0 && splitsM.size() == capacityM) {
+        // the oldest lap's split becomes the start of the next one
+        Uint64 oldest = droppedM + 1;
+        base_split_nsM = splitsM[headM];
+        splitsM[headM] = split_ns;
+        headM = (headM + 1) % capacityM;
+        droppedM++;
+        if (!best_candidatesM.empty() && best_candidatesM.front() == oldest)
+            best_candidatesM.pop_front();
+        if (!worst_candidatesM.empty() && worst_candidatesM.front() == oldest)
+            worst_candidatesM.pop_front();
+    } else {
+        splitsM.push_back(split_ns);
+    }
+
+    // a lap can't be the best while a later one at least as short is kept
+    while (!best_candidatesM.empty() && get_lap_ns(get_index(best_candidatesM.back())) > lap_ns)
+        best_candidatesM.pop_back();
+    best_candidatesM.push_back(number);
+    while (!worst_candidatesM.empty() && get_lap_ns(get_index(worst_candidatesM.back())) < lap_ns)
+        worst_candidatesM.pop_back();
+    worst_candidatesM.push_back(number);
+
+    // nothing is ever dropped without a ring, so only the fronts matter
+    if (capacityM == 0) {
+        best_candidatesM.resize(1);
+        worst_candidatesM.resize(1);
+    }
+}
+
+void LapStore::clear() {
+    splitsM.clear();
+    headM = 0;
+    droppedM = 0;
+    base_split_nsM = 0;
+    best_candidatesM.clear();
+    worst_candidatesM.clear();
+}
+
+Sint64 LapStore::get_split_ns(size_t index) const {
+    // headM is 0 until the ring is full, so this wraps at most once
+    size_t slot = headM + index;
+    return splitsM[slot < splitsM.size() ? slot : slot - splitsM.size()];
+}
+
+Sint64 LapStore::get_lap_ns(size_t index) const {
+    return get_split_ns(index) - (index == 0 ? base_split_nsM : get_split_ns(index - 1));
+}
+
+std::optional<size_t> LapStore::get_best() const {
+    if (best_candidatesM.empty())
+        return std::nullopt;
+    return get_index(best_candidatesM.front());
+}
+
+std::optional<size_t> LapStore::get_worst() const {
+    if (worst_candidatesM.empty())
+        return std::nullopt;
+    return get_index(worst_candidatesM.front());
+}
+
+Sint64 LapStore::get_average_ns() const {
+    if (splitsM.empty())
+        return 0;
+    return (get_split_ns(splitsM.size() - 1) - base_split_nsM) / static_cast<Sint64>(splitsM.size());
+}
+
+std::string format_lap_time(Sint64 ns) {
+    Sint64 centiseconds = ns / 10'000'000;
+    return std::format("{:02}:{:02}:{:02}.{:02}", centiseconds / 360'000, centiseconds / 6000 % 60,
+                       centiseconds / 100 % 60, centiseconds % 100);
+}
+
+static bool check_lap_stats(const LapStore& laps) {
+    size_t best = 0, worst = 0;
+    Sint64 sum_ns = 0;
+    for (size_t i = 0; i < laps.size(); i++) {
+        Sint64 lap_ns = laps.get_lap_ns(i);
+        if (lap_ns < laps.get_lap_ns(best))
+            best = i;
+        if (lap_ns > laps.get_lap_ns(worst))
+            worst = i;
+        sum_ns += lap_ns;
+    }
+    return laps.get_best() == best && laps.get_worst() == worst &&
+           laps.get_average_ns() == sum_ns / static_cast<Sint64>(laps.size());
+}
+
+bool run_lap_benchmark() {
+    using clock = std::chrono::steady_clock;
+    auto get_ns = [](clock::time_point start) {
+        return std::chrono::duration<double, std::nano>(clock::now() - start).count();
+    };
+
+    constexpr size_t lap_count = 1'000'000;
+    constexpr size_t ring_capacity = 1000;
+    // about a minute a lap give or take ten seconds, in whole milliseconds
+    // so equal laps and ties come up
+    std::mt19937 rng {42};
+    std::vector<Sint64> splits(lap_count);
+    Sint64 split_ns = 0;
+    for (Sint64& split : splits) {
+        split_ns += (50'000 + static_cast<Sint64>(rng() % 20'000)) * 1'000'000;
+        split = split_ns;
+    }
+
+    LapStore all(0);
+    auto start = clock::now();
+    for (Sint64 split : splits)
+        all.add(split);
+    double add_ns = get_ns(start) / lap_count;
+
+    LapStore ring(ring_capacity);
+    bool ok = true;
+    start = clock::now();
+    for (size_t i = 0; i < lap_count; i++) {
+        ring.add(splits[i]);
+        // checked now and then as laps drop out of the ring, outside the timing
+        if (i % 100'003 == 0) {
+            auto paused = clock::now();
+            ok = ok && check_lap_stats(ring);
+            start += clock::now() - paused;
+        }
+    }
+    double ring_add_ns = get_ns(start) / lap_count;
+
+    constexpr int rounds = 100'000;
+    Sint64 checksum = 0;
+    start = clock::now();
+    for (int i = 0; i < rounds; i++)
+        checksum += *all.get_best() + *all.get_worst() + all.get_average_ns();
+    double stats_ns = get_ns(start) / rounds;
+
+    ok = ok && check_lap_stats(all) && check_lap_stats(ring) && ring.size() == ring_capacity &&
+         ring.get_number(0) == lap_count - ring_capacity + 1;
+
+    // a screenful of rows is what the clipped list formats each frame,
+    // against what formatting every lap would cost
+    constexpr size_t visible_rows = 40;
+    size_t length = 0;
+    start = clock::now();
+    for (size_t i = all.size() - visible_rows; i < all.size(); i++)
+        length += format_lap_time(all.get_lap_ns(i)).size() + format_lap_time(all.get_split_ns(i)).size();
+    double visible_us = get_ns(start) / 1000;
+    start = clock::now();
+    for (size_t i = 0; i < all.size(); i++)
+        length += format_lap_time(all.get_lap_ns(i)).size() + format_lap_time(all.get_split_ns(i)).size();
+    double every_ms = get_ns(start) / 1'000'000;
+
+    // also keeps the loops above from being optimized out
+    ok = ok && checksum > 0 && length > 0;
+    if (ok) {
+        std::println("{} laps: {:.1f} ns per lap in {:.1f} MB, {:.1f} ns per lap in a ring of {}, "
+                     "{:.1f} ns for best, worst and average", lap_count, add_ns, lap_count * sizeof(Sint64) / 1e6,
+                     ring_add_ns, ring_capacity, stats_ns);
+        std::println("Formatting {} visible rows: {:.1f} us, every row: {:.0f} ms", visible_rows, visible_us, every_ms);
+    } else {
+        std::println(stderr, "Lap benchmark failed: the stats don't match the laps");
+    }
+    return ok;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <SDL3/SDL_stdinc.h>
+#include <deque>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Laps of a stopwatch run, stored as a single column of the run times in
+// nanoseconds each lap ended at. A lap's length is the difference to the
+// one before it, so nothing else is kept per lap. With a capacity only the
+// latest laps are kept in a ring and the oldest are dropped as new ones
+// come in, lap numbers keep counting from the first lap of the run.
+//
+// Best, worst and average are kept up to date as laps are added: the
+// average is the time between the first and last kept split, and best and
+// worst are the fronts of two queues of the laps that could still become
+// the shortest or longest once the laps before them are dropped.
+class LapStore {
+public:
+    // 0 keeps every lap
+    explicit LapStore(size_t capacity = get_default_capacity());
+
+    // Capacity of the stores created from then on, set by --max-laps
+    static void set_default_capacity(size_t capacity);
+    static size_t get_default_capacity();
+
+    // `split_ns` is the run time the lap ended at, never less than the last
+    void add(Sint64 split_ns);
+    void clear();
+
+    // Kept laps, oldest first
+    size_t size() const { return splitsM.size(); }
+    bool empty() const { return splitsM.empty(); }
+    size_t get_capacity() const { return capacityM; }
+
+    // 1 for the first lap of the run
+    Uint64 get_number(size_t index) const { return droppedM + index + 1; }
+    Sint64 get_split_ns(size_t index) const;
+    Sint64 get_lap_ns(size_t index) const;
+
+    // Indices of the shortest and longest kept lap, the earliest on a tie
+    std::optional<size_t> get_best() const;
+    std::optional<size_t> get_worst() const;
+    Sint64 get_average_ns() const;
+
+private:
+    std::vector<Sint64> splitsM;
+    size_t capacityM;
+    // slot of the oldest lap once the ring is full
+    size_t headM;
+    Uint64 droppedM;
+    // split of the lap before the oldest one kept, 0 until laps are dropped
+    Sint64 base_split_nsM;
+    // lap numbers in increasing order with increasing, respectively
+    // decreasing lengths
+    std::deque<Uint64> best_candidatesM;
+    std::deque<Uint64> worst_candidatesM;
+
+    size_t get_index(Uint64 number) const { return number - droppedM - 1; }
+};
+
+// "hh:mm:ss.cc" like the stopwatch shows
+std::string format_lap_time(Sint64 ns);
+
+// Records a million laps with and without a ring, checks best, worst and
+// average against a scan of them and prints how long adding laps, the
+// stats and formatting a screenful of rows take, for --lap-benchmark
+bool run_lap_benchmark();
@@ -0,0 +1,78 @@
+#include "local_time.hpp"
+#include <SDL3/SDL_time.h>
+#include <SDL3/SDL_timer.h>
+#include <algorithm>
+#include <ctime>
+
+Sint64 get_days_from_civil(Sint64 year, unsigned month, unsigned day) {
+    year -= month <= 2;
+    Sint64 era = (year >= 0 ? year : year - 399) / 400;
+    auto year_of_era = static_cast<unsigned>(year - era * 400);
+    unsigned day_of_year = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    unsigned day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+    return era * 146097 + static_cast<Sint64>(day_of_era) - 719468;
+}
+
+CivilDate get_civil_from_days(Sint64 days) {
+    days += 719468;
+    Sint64 era = (days >= 0 ? days : days - 146096) / 146097;
+    auto day_of_era = static_cast<unsigned>(days - era * 146097);
+    unsigned year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+    unsigned day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+    unsigned shifted_month = (5 * day_of_year + 2) / 153;
+    unsigned day = day_of_year - (153 * shifted_month + 2) / 5 + 1;
+    unsigned month = shifted_month < 10 ? shifted_month + 3 : shifted_month - 9;
+    return {year_of_era + era * 400 + (month <= 2), month, day};
+}
+
+int get_weekday(Sint64 days) {
+    // 1970-01-01 was a Thursday
+    return static_cast<int>(((days + 4) % 7 + 7) % 7);
+}
+
+void reread_time_zone() {
+#ifdef _WIN32
+    _tzset();
+#else
+    tzset();
+#endif
+}
+
+int get_utc_offset_s(Sint64 wall_ms) {
+    SDL_DateTime dt;
+    return SDL_TimeToDateTime(SDL_MS_TO_NS(wall_ms), &dt, true) ? dt.utc_offset : 0;
+}
+
+Sint64 get_local_day(Sint64 wall_ms) {
+    SDL_DateTime dt;
+    if (!SDL_TimeToDateTime(SDL_MS_TO_NS(wall_ms), &dt, true))
+        return 0;
+    return get_days_from_civil(dt.year, dt.month, dt.day);
+}
+
+Sint64 get_local_today() {
+    SDL_Time now;
+    return SDL_GetCurrentTime(&now) ? get_local_day(now / SDL_NS_PER_MS) : 0;
+}
+
+Sint64 get_wall_ms_from_local(Sint64 day, Sint64 second_of_day) {
+    Sint64 local_ms = day * ms_per_day + second_of_day * 1000;
+    // no zone is more than a day off UTC, so these are the offsets before
+    // and after any change around that time
+    int before_s = get_utc_offset_s(local_ms - ms_per_day);
+    int after_s = get_utc_offset_s(local_ms + ms_per_day);
+    Sint64 before_ms = local_ms - before_s * 1000LL;
+    if (before_s == after_s)
+        return before_ms;
+
+    Sint64 after_ms = local_ms - after_s * 1000LL;
+    bool before_holds = get_utc_offset_s(before_ms) == before_s;
+    bool after_holds = get_utc_offset_s(after_ms) == after_s;
+    if (before_holds && after_holds)
+        return std::min(before_ms, after_ms);
+    if (after_holds)
+        return after_ms;
+    // either the old offset still holds, or the time was skipped and read
+    // with the old offset it lands as far past the jump as it was into it
+    return before_ms;
+}
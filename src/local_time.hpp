@@ -0,0 +1,39 @@
+#pragma once
+
+#include <SDL3/SDL_stdinc.h>
+
+// Calendar arithmetic on days since 1970-01-01 and conversions between
+// system time and local time. Wall times are milliseconds since the epoch.
+
+constexpr Sint64 ms_per_day = 24 * 60 * 60 * 1000;
+
+// Rounds towards negative infinity, unlike /
+inline Sint64 divide_down(Sint64 value, Sint64 divisor) {
+    return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor);
+}
+
+struct CivilDate {
+    Sint64 year;
+    unsigned month;
+    unsigned day;
+};
+
+// Days between 1970-01-01 and the given date of the proleptic Gregorian calendar
+Sint64 get_days_from_civil(Sint64 year, unsigned month, unsigned day);
+// The inverse of get_days_from_civil
+CivilDate get_civil_from_days(Sint64 days);
+// 0 for Sunday to 6 for Saturday
+int get_weekday(Sint64 days);
+
+// Has the system's time zone read again, after TZ or /etc/localtime changed
+void reread_time_zone();
+// Seconds the local time is ahead of UTC at `wall_ms`
+int get_utc_offset_s(Sint64 wall_ms);
+// Days since 1970-01-01 of the local date `wall_ms` falls on
+Sint64 get_local_day(Sint64 wall_ms);
+Sint64 get_local_today();
+
+// When the local clock reads `second_of_day` on `day`. A time skipped by a
+// daylight saving change is moved forward by the length of the jump, 02:30
+// becomes 03:30, and of a time that comes twice the first one is taken.
+Sint64 get_wall_ms_from_local(Sint64 day, Sint64 second_of_day);
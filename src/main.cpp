@@ -1,4 +1,13 @@
+#include "audio_latency.hpp"
 #include "audio_player.hpp"
+#include "clock.hpp"
+#include "control_client.hpp"
+#include "control_server.hpp"
+#include "daemon.hpp"
+#include "history_export.hpp"
+#include "lap_store.hpp"
+#include "slot_map.hpp"
+#include "timer_service.hpp"
 #include "ui/misc.hpp"
 #include "ui/pomodoro_timer.hpp"
 #include "ui/stopwatch_creator.hpp"
@@ -6,6 +15,7 @@
 #include <print>
 #include "ui/timer_display.hpp"
 #include <algorithm>
+#include <charconv>
 #include <iostream>
 
 #define SDL_MAIN_USE_CALLBACKS
@@ -15,11 +25,17 @@
 #include "imgui.h"
 #include "imgui_impl_sdl3.h"
 #include "imgui_impl_sdlrenderer3.h"
+#include "imgui_stdlib.h"
 #include <thread>
 #include "appstate.hpp"
 #include "ui/sidebar.hpp"
 #include "ui/timer_creator.hpp"
+#include "ui/timer_dashboard.hpp"
+#include "ui/timer_table.hpp"
+#include "ui/history_view.hpp"
+#include "ui/alarms_view.hpp"
 #include <vector>
+#include <unordered_map>
 #include "miniaudio.h"
 #include "constants.hpp"
 #include <filesystem>
@@ -43,20 +59,29 @@ struct PomodoroTimerCreator {
     unsigned repeat = 3;
 };
 
+// how the timer tab lays out its timers
+enum class TimerView {
+    Windows, Dashboard, Table
+};
+
 struct AppState {
     SDL_Window* window;
     SDL_Renderer* renderer;
     ImGuiContext* main_imgui_ctx;
     CurrentTab current_tab;
-    std::vector<TimerDisplay> timers;
     TimerCreater timer_creater;
     StopwatchCreator stopwatch_creator;
-    std::vector<StopwatchDisplay> stopwatches;
     FocusState focus_state;
-    std::vector<PopoutWindow> popouts;
+    SlotMap<PopoutWindow> popouts;
+    std::unordered_map<SDL_WindowID, SlotHandle> popout_by_window;
     PomodoroTimerCreator pomodoro_creator;
-    std::optional<PomodoroTimer> pomodoro_timer;
-    AudioPlayer audio_player {ASSETS_FOLDER "sound/freesound_community-kitchen-timer-87485.mp3"};
+    TimerService service;
+    ControlServer control_server;
+    TimerView timer_view = TimerView::Windows;
+    TimerDashboard timer_dashboard;
+    TimerTable timer_table;
+    HistoryView history_view;
+    AlarmsView alarms_view;
 };
 
 void configure_imgui_ctx() {
@@ -129,8 +154,7 @@ void create_popout_window(AppState& app, FocusState focus) {
     
     popout.should_close = false;
     
-    // Add to vector
-    app.popouts.push_back(popout);
+    app.popout_by_window[popout.window_id] = app.popouts.emplace(popout);
 
     ImGui::SetCurrentContext(app.main_imgui_ctx);
 }
@@ -147,38 +171,231 @@ void destroy_popout_window(PopoutWindow& popout, AppState& state) {
     popout.should_close = true;
 
     if (*popout.focus_state.what_is_focused == WhatIsFullscreen::Timer) {
-        for (auto& timer : state.timers)
-            if (timer.get_id() == *popout.focus_state.id_of_focussed)
-                timer.set_focus_type(FocusType::None);
+        if (auto timer = state.service.timers.get(*popout.focus_state.id_of_focussed))
+            timer->set_focus_type(FocusType::None);
     } else if (*popout.focus_state.what_is_focused == WhatIsFullscreen::Stopwatch) {
-        for (auto& sw : state.stopwatches)
-            if (sw.get_id() == *popout.focus_state.id_of_focussed)
-                sw.set_focus_type(FocusType::None);
-    } else if (*popout.focus_state.what_is_focused == WhatIsFullscreen::Pomodoro && state.pomodoro_timer.has_value())
-        state.pomodoro_timer->set_focus_type(FocusType::None);
+        if (auto sw = state.service.stopwatches.get(*popout.focus_state.id_of_focussed))
+            sw->set_focus_type(FocusType::None);
+    } else if (*popout.focus_state.what_is_focused == WhatIsFullscreen::Pomodoro && state.service.pomodoro_timer.has_value())
+        state.service.pomodoro_timer->set_focus_type(FocusType::None);
 
     ImGui::SetCurrentContext(state.main_imgui_ctx);
 }
 
 void close_popout_by_window_id(AppState& app, SDL_WindowID window_id) {
-    app.popouts.erase(
-            std::remove_if(app.popouts.begin(), app.popouts.end(), [window_id, &app](PopoutWindow& pp) {
-                if (pp.window_id == window_id && !pp.should_close)
-                    destroy_popout_window(pp, app);
-                return pp.should_close;
-                }),
-            app.popouts.end()
-        );
+    auto it = app.popout_by_window.find(window_id);
+    if (it == app.popout_by_window.end())
+        return;
+
+    PopoutWindow* popout = app.popouts.get(it->second);
+    if (popout != nullptr && !popout->should_close)
+        destroy_popout_window(*popout, app);
+    app.popouts.erase(it->second);
+    app.popout_by_window.erase(it);
 }
 
-auto find_popout_by_window_id(AppState& app, SDL_WindowID window_id) {
-    return std::find_if(app.popouts.begin(), app.popouts.end(), [window_id](PopoutWindow& pp) {
-            return pp.window_id == window_id;
-            });
+PopoutWindow* find_popout_by_window_id(AppState& app, SDL_WindowID window_id) {
+    auto it = app.popout_by_window.find(window_id);
+    return it != app.popout_by_window.end() ? app.popouts.get(it->second) : nullptr;
+}
+
+// Brings back the timers of the last run, they aren't saved this time if
+// another instance has the journal open
+void open_journal(TimerService& service, const JournalOptions& options) {
+    std::string directory = journal_directory();
+    if (!service.journal.open(directory, options)) {
+        SDL_Log("Couldn't open the journal in %s, timers won't be saved", directory.c_str());
+        return;
+    }
+    restore_timers(service);
+    if (!service.history.open(directory))
+        SDL_Log("Couldn't open the history in %s", directory.c_str());
 }
 
 SDL_AppResult SDL_AppInit(void **appstate, int argc, char *argv[]) {
-    AppState *state = new AppState;
+    std::optional<size_t> sound_cache_mb;
+    AudioOptions audio_options;
+    // the latency is only worth printing to someone who's tuning it
+    bool audio_tuned = false;
+    bool daemon = false;
+    bool new_instance = false;
+    JournalOptions journal_options;
+    bool journal = true;
+    std::vector<int> start_timers_s;
+    std::optional<std::string> export_path;
+    Sint64 export_from_ms = SDL_MIN_SINT64;
+    Sint64 export_to_ms = SDL_MAX_SINT64;
+    for (int i = 1; i < argc; i++) {
+        std::string_view arg = argv[i];
+        if (arg == "--clock" && i + 1 < argc) {
+            auto mode = parse_clock_mode(argv[++i]);
+            if (!mode.has_value()) {
+                SDL_Log("Unknown clock \"%s\", expected monotonic, boottime or wall", argv[i]);
+                return SDL_APP_FAILURE;
+            }
+            set_clock_mode(*mode);
+        } else if (arg == "--sound-cache-mb" && i + 1 < argc) {
+            std::string_view value = argv[++i];
+            size_t mb = 0;
+            auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), mb);
+            if (ec != std::errc() || end != value.data() + value.size()) {
+                SDL_Log("Invalid sound cache size \"%s\", expected a number of megabytes", argv[i]);
+                return SDL_APP_FAILURE;
+            }
+            sound_cache_mb = mb;
+        } else if (arg == "--audio-period-ms" && i + 1 < argc) {
+            audio_tuned = true;
+            std::string_view value = argv[++i];
+            auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), audio_options.period_ms);
+            if (ec != std::errc() || end != value.data() + value.size()) {
+                SDL_Log("Invalid audio period \"%s\", expected a number of milliseconds", argv[i]);
+                return SDL_APP_FAILURE;
+            }
+        } else if (arg == "--audio-profile" && i + 1 < argc) {
+            audio_tuned = true;
+            std::string_view value = argv[++i];
+            if (value == "low-latency")
+                audio_options.profile = ma_performance_profile_low_latency;
+            else if (value == "conservative")
+                audio_options.profile = ma_performance_profile_conservative;
+            else {
+                SDL_Log("Unknown audio profile \"%s\", expected low-latency or conservative", argv[i]);
+                return SDL_APP_FAILURE;
+            }
+        } else if (arg == "--audio-realtime") {
+            audio_options.realtime_priority = true;
+        } else if (arg == "--ctl" && i + 1 < argc) {
+            // talks to the running instance and exits
+            return run_control_client(argv[++i]) ? SDL_APP_SUCCESS : SDL_APP_FAILURE;
+        } else if (arg == "--control-benchmark") {
+            bool ok = run_control_benchmark(ASSETS_FOLDER "sound/freesound_community-kitchen-timer-87485.mp3", 20'000);
+            return ok ? SDL_APP_SUCCESS : SDL_APP_FAILURE;
+        } else if (arg == "--history-benchmark") {
+            return run_history_benchmark() ? SDL_APP_SUCCESS : SDL_APP_FAILURE;
+        } else if (arg == "--lap-benchmark") {
+            return run_lap_benchmark() ? SDL_APP_SUCCESS : SDL_APP_FAILURE;
+        } else if (arg == "--alarm-benchmark") {
+            return run_alarm_benchmark() ? SDL_APP_SUCCESS : SDL_APP_FAILURE;
+        } else if (arg == "--interval-benchmark") {
+            return run_interval_benchmark() ? SDL_APP_SUCCESS : SDL_APP_FAILURE;
+        } else if (arg == "--slotmap-benchmark") {
+            return run_slotmap_benchmark() ? SDL_APP_SUCCESS : SDL_APP_FAILURE;
+        } else if (arg == "--batch-benchmark") {
+            return run_batch_benchmark() ? SDL_APP_SUCCESS : SDL_APP_FAILURE;
+        } else if (arg == "--dashboard-benchmark") {
+            bool ok = run_dashboard_benchmark(ASSETS_FOLDER "sound/freesound_community-kitchen-timer-87485.mp3");
+            return ok ? SDL_APP_SUCCESS : SDL_APP_FAILURE;
+        } else if (arg == "--table-benchmark") {
+            bool ok = run_table_benchmark(ASSETS_FOLDER "sound/freesound_community-kitchen-timer-87485.mp3");
+            return ok ? SDL_APP_SUCCESS : SDL_APP_FAILURE;
+        } else if (arg == "--max-laps" && i + 1 < argc) {
+            std::string_view value = argv[++i];
+            size_t laps = 0;
+            auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), laps);
+            if (ec != std::errc() || end != value.data() + value.size()) {
+                SDL_Log("Invalid lap count \"%s\", expected a number of laps", argv[i]);
+                return SDL_APP_FAILURE;
+            }
+            LapStore::set_default_capacity(laps);
+        } else if (arg == "--daemon") {
+            daemon = true;
+        } else if (arg == "--journal-fsync" && i + 1 < argc) {
+            auto policy = parse_fsync_policy(argv[++i]);
+            if (!policy.has_value()) {
+                SDL_Log("Unknown fsync policy \"%s\", expected always, interval or never", argv[i]);
+                return SDL_APP_FAILURE;
+            }
+            journal_options.fsync = *policy;
+        } else if (arg == "--no-journal") {
+            journal = false;
+        } else if (arg == "--new-instance") {
+            new_instance = true;
+        } else if (arg == "--timer" && i + 1 < argc) {
+            auto seconds = parse_duration_s(argv[++i]);
+            if (!seconds.has_value() || *seconds <= 0) {
+                SDL_Log("Invalid timer duration \"%s\", expected something like 25m or 90s", argv[i]);
+                return SDL_APP_FAILURE;
+            }
+            start_timers_s.push_back(*seconds);
+        } else if (arg == "--export" && i + 1 < argc) {
+            export_path = argv[++i];
+        } else if ((arg == "--from" || arg == "--to") && i + 1 < argc) {
+            bool to = arg == "--to";
+            auto ms = parse_export_time(argv[++i], to);
+            if (!ms.has_value()) {
+                SDL_Log("Invalid date \"%s\", expected something like 2026-10-19 or 2026-10-19T14:30", argv[i]);
+                return SDL_APP_FAILURE;
+            }
+            (to ? export_to_ms : export_from_ms) = *ms;
+        } else if (arg == "--journal-benchmark") {
+            // runs without a window or sound card and exits
+            bool ok = run_journal_benchmark(ASSETS_FOLDER "sound/freesound_community-kitchen-timer-87485.mp3", 10'000);
+            return ok ? SDL_APP_SUCCESS : SDL_APP_FAILURE;
+        } else if (arg == "--suspend-check") {
+            // runs without a window or sound card and exits
+            bool ok = run_suspend_check(ASSETS_FOLDER "sound/freesound_community-kitchen-timer-87485.mp3", 100);
+            return ok ? SDL_APP_SUCCESS : SDL_APP_FAILURE;
+        } else if (arg == "--audio-latency-check") {
+            // runs without a window or sound card and exits
+            bool ok = run_audio_latency_check(ASSETS_FOLDER "sound/freesound_community-kitchen-timer-87485.mp3", 500);
+            return ok ? SDL_APP_SUCCESS : SDL_APP_FAILURE;
+        } else if (arg == "--alarm-stress-check") {
+            // runs without a window or sound card and exits
+            bool ok = run_alarm_stress_check(ASSETS_FOLDER "sound/freesound_community-kitchen-timer-87485.mp3");
+            return ok ? SDL_APP_SUCCESS : SDL_APP_FAILURE;
+        }
+    }
+
+    // only reads the history, so it works while another instance is running
+    if (export_path.has_value()) {
+        ExportProgress progress;
+        std::string error;
+        auto written = export_history(journal_directory(), export_from_ms, export_to_ms, *export_path, progress, error);
+        if (!written.has_value()) {
+            SDL_Log("%s", error.c_str());
+            return SDL_APP_FAILURE;
+        }
+        std::println("Exported {} records to {}", *written, *export_path);
+        return SDL_APP_SUCCESS;
+    }
+
+    // before the sound is decoded or a window opens, so a second launch is
+    // over in a few milliseconds and the instance that's running takes it
+    if (!daemon && !new_instance) {
+        LaunchForward forwarded = forward_launch(argc, argv);
+        if (forwarded != LaunchForward::NotRunning)
+            return forwarded == LaunchForward::Forwarded ? SDL_APP_SUCCESS : SDL_APP_FAILURE;
+    }
+
+    if (daemon) {
+        // no window, renderer or ImGui context is ever created
+        TimerService service {
+            .audio_player = {ASSETS_FOLDER "sound/freesound_community-kitchen-timer-87485.mp3", audio_options}
+        };
+        if (sound_cache_mb.has_value())
+            service.audio_player.set_cache_budget(*sound_cache_mb * 1024 * 1024);
+        service.alarms.get_time_zone().start();
+        if (journal)
+            open_journal(service, journal_options);
+        for (int seconds : start_timers_s)
+            start_new_timer(service, seconds);
+        return run_daemon(service) ? SDL_APP_SUCCESS : SDL_APP_FAILURE;
+    }
+
+    AppState *state = new AppState {
+        .service = {.audio_player = {ASSETS_FOLDER "sound/freesound_community-kitchen-timer-87485.mp3", audio_options}}
+    };
+    if (audio_tuned) {
+        auto latency = state->service.audio_player.get_latency();
+        std::println("Audio output latency: {:.1f} ms ({} periods of {} frames at {} Hz)",
+                     latency.ms, latency.periods, latency.period_frames, latency.sample_rate);
+    }
+    if (sound_cache_mb.has_value())
+        state->service.audio_player.set_cache_budget(*sound_cache_mb * 1024 * 1024);
+    // reads the time zone while the window opens
+    state->service.alarms.get_time_zone().start();
+    if (!state->control_server.listen(control_socket_path()))
+        SDL_Log("Couldn't listen on %s, the control socket is off", control_socket_path().c_str());
 
     /* Create the window */
     if (!SDL_CreateWindowAndRenderer("Timepad", 800, 600, SDL_WINDOW_RESIZABLE, &state->window, &state->renderer)) {
@@ -187,6 +404,12 @@ SDL_AppResult SDL_AppInit(void **appstate, int argc, char *argv[]) {
     }
 
     state->current_tab = CurrentTab::PomodoroTimer;
+    if (journal)
+        open_journal(state->service, journal_options);
+    for (int seconds : start_timers_s) {
+        start_new_timer(state->service, seconds);
+        state->current_tab = CurrentTab::Timer;
+    }
 
     configure_sdl_renderer(state->renderer);
 
@@ -211,6 +434,12 @@ SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *event) {
     if (event->type == SDL_EVENT_QUIT)
         return SDL_APP_SUCCESS;
 
+#ifdef DEBUG
+    // pretend the laptop lid was closed for 5 minutes
+    if (event->type == SDL_EVENT_KEY_DOWN && event->key.key == SDLK_F8)
+        clock_simulate_suspend(5 * 60 * 1000);
+#endif
+
     // Handle window close events
     if (event->type == SDL_EVENT_WINDOW_CLOSE_REQUESTED) {
         // Close the specific popout window
@@ -222,8 +451,9 @@ SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *event) {
     if (focused) {
         auto id = SDL_GetWindowID(focused);
         ImGui::GetCurrentContext();
-        if (focused != state.window)
-            ImGui::SetCurrentContext(find_popout_by_window_id(state, id)->imgui_ctx);
+        PopoutWindow* popout = nullptr;
+        if (focused != state.window && (popout = find_popout_by_window_id(state, id)))
+            ImGui::SetCurrentContext(popout->imgui_ctx);
         else if (focused == state.window)
             ImGui::SetCurrentContext(state.main_imgui_ctx);
     }
@@ -248,17 +478,22 @@ void render_popout_window(AppState& app, PopoutWindow& popout) {
     auto id = popout.focus_state.id_of_focussed;
 
     if (*popout.focus_state.what_is_focused == WhatIsFullscreen::Timer) {
-        for (auto& timer : app.timers)
-            if (timer.get_id() == *id)
-                timer.draw(popout.renderer, app.audio_player);
+        if (auto timer = app.service.timers.get(*id)) {
+            timer->set_frame(app.service.timer_batch.get_frame(id->index));
+            timer->draw(popout.renderer, app.service.audio_player);
+            sync_timer_events(app.service, *id);
+        }
     } else if (*popout.focus_state.what_is_focused == WhatIsFullscreen::Stopwatch) {
-        for (auto& sw : app.stopwatches)
-            if (sw.get_id() == *id)
-                sw.draw();
+        if (auto sw = app.service.stopwatches.get(*id)) {
+            sw->draw();
+            sync_stopwatch(app.service, *id);
+        }
     } else if (*popout.focus_state.what_is_focused == WhatIsFullscreen::Pomodoro) {
-        if (app.pomodoro_timer.has_value())
-            app.pomodoro_timer->draw(popout.renderer, app.audio_player);
-        if ((app.pomodoro_timer.has_value() && app.pomodoro_timer->is_done()) || !app.pomodoro_timer.has_value())
+        if (app.service.pomodoro_timer.has_value()) {
+            app.service.pomodoro_timer->draw(popout.renderer, app.service.audio_player);
+            sync_timer_events(app.service, pomodoro_timer_handle);
+        }
+        if ((app.service.pomodoro_timer.has_value() && app.service.pomodoro_timer->is_done()) || !app.service.pomodoro_timer.has_value())
             popout.should_close = true;
     }
     
@@ -271,6 +506,19 @@ SDL_AppResult SDL_AppIterate(void *appstate) {
     AppState &state = *static_cast<AppState*>(appstate);
     SDL_Renderer *renderer = state.renderer;
 
+    // the clock is read once per frame, every timer's progress comes from this
+    Uint64 now = clock_now_ms();
+    // never waits, commands that came in since the last frame are all there is
+    state.control_server.poll(state.service, 0);
+    state.control_server.count_wakeup();
+    if (state.control_server.take_raise_request()) {
+        SDL_RestoreWindow(state.window);
+        SDL_RaiseWindow(state.window);
+    }
+    tick_timers(state.service, now);
+    state.control_server.publish_expired(state.service);
+    state.service.timer_batch.update(now);
+
     SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
     SDL_RenderClear(renderer);
 
@@ -288,7 +536,18 @@ SDL_AppResult SDL_AppIterate(void *appstate) {
         if (state.focus_state.type == FocusType::Fullscreen)
             assert(state.focus_state.what_is_focused.has_value());
 
-        for (TimerDisplay& timer : state.timers) {
+        if (state.timer_view == TimerView::Dashboard && state.focus_state.type == FocusType::None) {
+            auto changed = state.timer_dashboard.draw(renderer, state.service.timers, state.service.timer_batch, state.service.audio_player);
+            if (changed.has_value())
+                sync_timer_events(state.service, *changed);
+        } else if (state.timer_view == TimerView::Table && state.focus_state.type == FocusType::None) {
+            auto changed = state.timer_table.draw(state.service.timers, state.service.stopwatches, state.service.timer_batch, state.service.timer_order, now);
+            if (changed.has_value())
+                sync_timer_events(state.service, *changed);
+        }
+
+        for (size_t i = 0; i < state.service.timers.size() && state.timer_view == TimerView::Windows; i++) {
+            TimerDisplay& timer = state.service.timers[i];
             if (timer.get_focus_type() == FocusType::Popout)
                 continue;
             if (state.focus_state.type == FocusType::Fullscreen &&
@@ -296,7 +555,10 @@ SDL_AppResult SDL_AppIterate(void *appstate) {
                 *state.focus_state.id_of_focussed != timer.get_id())
                 continue;
 
-            auto focus_state = timer.draw(renderer, state.audio_player);
+            auto handle = state.service.timers.handle_at(i);
+            timer.set_frame(state.service.timer_batch.get_frame(handle.index));
+            auto focus_state = timer.draw(renderer, state.service.audio_player);
+            sync_timer_events(state.service, handle);
             if (focus_state.has_value() && focus_state->type != FocusType::Popout)
                 state.focus_state = *focus_state;
             else if (focus_state.has_value() && focus_state->type == FocusType::Popout) {
@@ -308,16 +570,26 @@ SDL_AppResult SDL_AppIterate(void *appstate) {
         if (state.focus_state.type == FocusType::None) {
             auto new_timer = state.timer_creater.draw();
             if (new_timer.has_value())
-                state.timers.push_back(*new_timer);
+                add_timer(state.service, *new_timer);
+            // appended to the creator's window
+            int view = static_cast<int>(state.timer_view);
+            ImGui::Begin("Create a Timer");
+            ImGui::RadioButton("Windows", &view, static_cast<int>(TimerView::Windows));
+            ImGui::SameLine();
+            ImGui::RadioButton("Dashboard", &view, static_cast<int>(TimerView::Dashboard));
+            ImGui::SameLine();
+            ImGui::RadioButton("Table", &view, static_cast<int>(TimerView::Table));
+            ImGui::End();
+            state.timer_view = static_cast<TimerView>(view);
         }
     } else if (state.current_tab == CurrentTab::Stopwatch) {
         if (state.focus_state.type == FocusType::None){
             auto stopwatch = state.stopwatch_creator.draw();
             if (stopwatch.has_value())
-                state.stopwatches.push_back(*stopwatch);
+                add_stopwatch(state.service, *stopwatch);
         }
 
-        for (auto& sw : state.stopwatches) {
+        for (auto& sw : state.service.stopwatches) {
             if (sw.get_focus_type() == FocusType::Popout)
                 continue;
             if (state.focus_state.type == FocusType::Fullscreen &&
@@ -326,6 +598,7 @@ SDL_AppResult SDL_AppIterate(void *appstate) {
                 continue;
 
             auto focus_state = sw.draw();
+            sync_stopwatch(state.service, sw.get_id());
             if (focus_state.has_value() && focus_state->type != FocusType::Popout)
                 state.focus_state = *focus_state;
             else if (focus_state.has_value() && focus_state->type == FocusType::Popout) {
@@ -334,7 +607,7 @@ SDL_AppResult SDL_AppIterate(void *appstate) {
             }
         }
     } else if (state.current_tab == CurrentTab::PomodoroTimer) {
-        if (!state.pomodoro_timer.has_value()) {
+        if (!state.service.pomodoro_timer.has_value()) {
             static int break_h {}, break_m {5}, break_s {};
             static int work_h {}, work_m {30}, work_s {};
             static int repeat {3};
@@ -343,15 +616,53 @@ SDL_AppResult SDL_AppIterate(void *appstate) {
             TimerInput("Work Time", &work_h, &work_m, &work_s);
             TimerInput("Break Time", &break_h, &break_m, &break_s);
             ImGui::InputInt("Repeat amount", &repeat);
-
-            if (ImGui::Button("Create"))
-                state.pomodoro_timer.emplace(
-                        work_h * 3600 + work_m * 60 + work_s,
-                        break_h * 3600 + break_m * 60 + break_s,
-                        repeat);
+            // takes the place of the times above when it's filled in
+            static std::string sequence, sequence_error;
+            ImGui::InputTextWithHint("Intervals", "warm-up 5m, 4x(work 25m, rest 5m), cool-down 5m", &sequence);
+
+            static std::string work_sound, break_sound;
+            ImGui::InputTextWithHint("Work end sound", "Default sound", &work_sound);
+            ImGui::InputTextWithHint("Break end sound", "Default sound", &break_sound);
+            // the end sound fades into these as the next phase starts
+            static std::string work_start_sound, break_start_sound;
+            ImGui::InputTextWithHint("Work start sound", "None", &work_start_sound);
+            ImGui::InputTextWithHint("Break start sound", "None", &break_start_sound);
+
+            bool create = ImGui::Button("Create");
+            if (!sequence_error.empty()) {
+                ImGui::SameLine();
+                ImGui::TextColored({0.95f, 0.45f, 0.4f, 1.0f}, "%s", sequence_error.c_str());
+            }
+            std::optional<std::vector<IntervalStep>> steps;
+            if (create && !sequence.empty()) {
+                sequence_error.clear();
+                steps = parse_interval_sequence(sequence, sequence_error);
+                create = steps.has_value();
+            } else if (create && repeat <= 0) {
+                // the plain session has no phases at all then
+                sequence_error = "A session needs at least one work phase";
+                create = false;
+            } else if (create) {
+                sequence_error.clear();
+            }
+            if (create) {
+                if (steps.has_value())
+                    state.service.pomodoro_timer.emplace(sequence, PomodoroSchedule {*steps});
+                else
+                    state.service.pomodoro_timer.emplace(
+                            work_h * 3600 + work_m * 60 + work_s,
+                            break_h * 3600 + break_m * 60 + break_s,
+                            repeat);
+                state.service.pomodoro_timer->set_sounds(work_sound, break_sound);
+                state.service.pomodoro_timer->set_start_sounds(work_start_sound, break_start_sound);
+                for (const std::string& sound : {work_sound, break_sound, work_start_sound, break_start_sound})
+                    if (!sound.empty())
+                        state.service.audio_player.preload(sound);
+            }
             ImGui::End();
-        } else if (state.pomodoro_timer->get_focus_type() != FocusType::Popout) {
-            auto focus_state = state.pomodoro_timer->draw(renderer, state.audio_player);
+        } else if (state.service.pomodoro_timer->get_focus_type() != FocusType::Popout) {
+            auto focus_state = state.service.pomodoro_timer->draw(renderer, state.service.audio_player);
+            sync_timer_events(state.service, pomodoro_timer_handle);
             if (focus_state.has_value() && focus_state->type != FocusType::Popout)
                 state.focus_state = *focus_state;
             else if (focus_state.has_value() && focus_state->type == FocusType::Popout) {
@@ -359,27 +670,28 @@ SDL_AppResult SDL_AppIterate(void *appstate) {
                 state.focus_state = {};
             }
         }
-        if (state.pomodoro_timer.has_value() && state.pomodoro_timer->is_done())
-            state.pomodoro_timer.reset();
 
+    } else if (state.current_tab == CurrentTab::History) {
+        state.history_view.draw(state.service.history);
     } else if (state.current_tab == CurrentTab::Alarms) {
-        ImGui::Begin("Under Construction");
-        ImGui::Text("This part of the app is not done yet, check back after an update!");
-        ImGui::End();
+        state.alarms_view.draw(state.service);
     }
+    // a ringing alarm shows up whichever tab is open
+    state.alarms_view.draw_ringing(state.service);
 
     ImGui::Render();
     ImGui_ImplSDLRenderer3_RenderDrawData(ImGui::GetDrawData(), renderer);
 
     SDL_RenderPresent(renderer);
 
-    for (auto it = state.popouts.begin(); it != state.popouts.end(); it++) {
-        auto& popout = *it;
+    // backwards, erasing moves the last popout into the freed spot
+    for (size_t i = state.popouts.size(); i-- > 0;) {
+        auto& popout = state.popouts[i];
         render_popout_window(state, popout);
         if (popout.should_close) {
             destroy_popout_window(popout, state);
-            it = state.popouts.erase(it);
-            if (it == state.popouts.end()) break;
+            state.popout_by_window.erase(popout.window_id);
+            state.popouts.erase(state.popouts.handle_at(i));
         }
     }
     ImGui::SetCurrentContext(state.main_imgui_ctx);
@@ -389,6 +701,9 @@ SDL_AppResult SDL_AppIterate(void *appstate) {
 
 void SDL_AppQuit(void *appstate, SDL_AppResult result) {
     AppState *state = static_cast<AppState *>(appstate);
+    // SDL_AppInit finished early, before anything was set up
+    if (state == nullptr)
+        return;
     ImGui_ImplSDL3_Shutdown();
     ImGui_ImplSDLRenderer3_Shutdown();
     ImGui::DestroyContext();
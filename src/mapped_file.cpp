@@ -0,0 +1,76 @@
+#include "mapped_file.hpp"
+#include <algorithm>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr size_t growth_chunk_bytes = 1 << 20;
+
+size_t round_up_to_chunk(size_t size) {
+    return (size + growth_chunk_bytes - 1) / growth_chunk_bytes * growth_chunk_bytes;
+}
+
+}
+
+#ifdef __linux__
+
+MappedFile::~MappedFile() {
+    if (dataM != nullptr)
+        munmap(dataM, sizeM);
+    if (fdM >= 0)
+        close(fdM);
+}
+
+bool MappedFile::open(const std::string& path, size_t min_size) {
+    fdM = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    struct stat st;
+    if (fdM < 0 || fstat(fdM, &st) != 0)
+        return false;
+
+    size_t size = std::max(static_cast<size_t>(st.st_size), round_up_to_chunk(min_size));
+    if (static_cast<size_t>(st.st_size) < size && ftruncate(fdM, size) != 0)
+        return false;
+
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fdM, 0);
+    if (data == MAP_FAILED)
+        return false;
+    dataM = static_cast<char*>(data);
+    sizeM = size;
+    return true;
+}
+
+bool MappedFile::reserve(size_t size) {
+    if (size <= sizeM)
+        return true;
+
+    // doubling keeps appends amortized O(1) however big the file gets
+    size_t new_size = round_up_to_chunk(std::max(size, sizeM * 2));
+    if (ftruncate(fdM, new_size) != 0)
+        return false;
+    void* data = mremap(dataM, sizeM, new_size, MREMAP_MAYMOVE);
+    if (data == MAP_FAILED)
+        return false;
+    dataM = static_cast<char*>(data);
+    sizeM = new_size;
+    return true;
+}
+
+#else
+
+MappedFile::~MappedFile() = default;
+
+bool MappedFile::open(const std::string&, size_t) {
+    return false;
+}
+
+bool MappedFile::reserve(size_t) {
+    return false;
+}
+
+#endif
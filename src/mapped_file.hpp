@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// A file mapped read-write into memory and shared with the file, so what's
+// written to the mapping lands in the file without any write calls and
+// only the pages that are read or written get loaded. Files grow in whole
+// chunks to keep remapping rare. Only available on Linux.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Opens or creates the file at `path`, growing it to `min_size` bytes
+    bool open(const std::string& path, size_t min_size);
+    bool is_open() const { return dataM != nullptr; }
+
+    // Grows the file and the mapping to at least `size` bytes. Pointers
+    // into the mapping don't survive this.
+    bool reserve(size_t size);
+
+    char* data() { return dataM; }
+    const char* data() const { return dataM; }
+    size_t size() const { return sizeM; }
+
+private:
+    int fdM = -1;
+    char* dataM = nullptr;
+    size_t sizeM = 0;
+};
@@ -0,0 +1,377 @@
+#include "pomodoro_schedule.hpp"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <format>
+#include <limits>
+#include <print>
+#include <random>
+#include <unordered_map>
+
+namespace {
+
+// deeper than anyone would nest repeats by hand
+constexpr int max_interval_depth = 16;
+
+template <typename T>
+std::optional<T> parse_number(std::string_view text) {
+    T value {};
+    auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (ec != std::errc() || end != text.data() + text.size())
+        return std::nullopt;
+    return value;
+}
+
+std::string_view trim(std::string_view text) {
+    size_t first = text.find_first_not_of(' ');
+    if (first == std::string_view::npos)
+        return {};
+    return text.substr(first, text.find_last_not_of(' ') - first + 1);
+}
+
+// Whether `label` has the word "break" or "rest" in it, in any case
+bool is_break_label(std::string_view label) {
+    auto equals = [](std::string_view word, std::string_view expected) {
+        return std::equal(word.begin(), word.end(), expected.begin(), expected.end(),
+                          [](char a, char b) { return std::tolower(static_cast<unsigned char>(a)) == b; });
+    };
+    while (!label.empty()) {
+        size_t end = label.find_first_of(" -_");
+        std::string_view word = label.substr(0, end);
+        if (equals(word, "break") || equals(word, "rest"))
+            return true;
+        label.remove_prefix(end == std::string_view::npos ? label.size() : end + 1);
+    }
+    return false;
+}
+
+// Takes the "4x(" of a block off the front of `text`, leaves it alone if
+// it doesn't start one
+std::optional<int> take_repeat(std::string_view& text) {
+    size_t digits = text.find_first_not_of("0123456789");
+    if (digits == 0 || digits == std::string_view::npos)
+        return std::nullopt;
+    std::string_view rest = trim(text.substr(digits));
+    if (rest.starts_with('x'))
+        rest.remove_prefix(1);
+    else if (rest.starts_with("×"))
+        rest.remove_prefix(std::string_view("×").size());
+    else
+        return std::nullopt;
+    rest = trim(rest);
+    if (!rest.starts_with('('))
+        return std::nullopt;
+
+    auto repeat = parse_number<int>(text.substr(0, digits));
+    if (!repeat.has_value())
+        return std::nullopt;
+    // the trim above can take trailing spaces too, the bracket is never last
+    text = text.substr(text.find('(', digits) + 1);
+    return repeat;
+}
+
+// Parses steps separated by commas up to the end of `text` or a closing
+// bracket, which is left for the caller
+bool parse_steps(std::string_view& text, int depth, std::vector<IntervalStep>& steps, std::string& error) {
+    while (true) {
+        text = text.substr(std::min(text.find_first_not_of(' '), text.size()));
+        IntervalStep step;
+        if (auto repeat = take_repeat(text)) {
+            if (*repeat <= 0) {
+                error = "A repeat needs to be at least 1";
+                return false;
+            }
+            if (depth == max_interval_depth) {
+                error = std::format("Repeats can't be nested more than {} deep", max_interval_depth);
+                return false;
+            }
+            step.repeat = *repeat;
+            if (!parse_steps(text, depth + 1, step.steps, error))
+                return false;
+            if (!text.starts_with(')')) {
+                error = "Missing )";
+                return false;
+            }
+            text.remove_prefix(1);
+        } else {
+            size_t end = std::min(text.find_first_of(",()"), text.size());
+            std::string_view phase = trim(text.substr(0, end));
+            text.remove_prefix(end);
+            size_t space = phase.find_last_of(' ');
+            std::string_view label = space == std::string_view::npos ? std::string_view {} : trim(phase.substr(0, space));
+            auto seconds = parse_duration_s(phase.substr(space == std::string_view::npos ? 0 : space + 1));
+            if (label.empty() || !seconds.has_value() || *seconds <= 0) {
+                error = std::format("Expected a label and a duration like \"work 25m\", not \"{}\"", phase);
+                return false;
+            }
+            step.state = is_break_label(label) ? PomodoroState::Break : PomodoroState::Work;
+            step.label = label;
+            step.length_s = *seconds;
+        }
+        steps.push_back(std::move(step));
+
+        text = text.substr(std::min(text.find_first_not_of(' '), text.size()));
+        if (!text.starts_with(','))
+            return true;
+        text.remove_prefix(1);
+    }
+}
+
+// Phases the steps expand to at most, stops counting past max_interval_phases
+size_t count_phases(const std::vector<IntervalStep>& steps) {
+    size_t count = 0;
+    for (const IntervalStep& step : steps) {
+        size_t phases = step.steps.empty() ? 1 : count_phases(step.steps);
+        count += std::min<size_t>(phases * static_cast<size_t>(step.repeat), max_interval_phases + 1);
+        if (count > max_interval_phases)
+            return count;
+    }
+    return count;
+}
+
+// Whether any of the steps is a work phase, those are never left out
+bool has_work(const std::vector<IntervalStep>& steps) {
+    return std::any_of(steps.begin(), steps.end(), [](const IntervalStep& step) {
+        return step.steps.empty() ? step.state == PomodoroState::Work : has_work(step.steps);
+    });
+}
+
+// Expands nested steps into phases back to back
+struct ScheduleBuilder {
+    std::vector<PomodoroPhase>& phases;
+    std::vector<std::string>& labels;
+    std::unordered_map<std::string, Uint32> label_indices;
+    Uint64 offset_ms = 0;
+
+    void append(const std::vector<IntervalStep>& steps) {
+        for (const IntervalStep& step : steps) {
+            if (step.steps.empty()) {
+                append_phase(step);
+                continue;
+            }
+            for (int round = 1; round <= step.repeat; round++) {
+                size_t round_start = phases.size();
+                append(step.steps);
+                if (round != step.repeat)
+                    continue;
+                // the last round doesn't end on a break
+                while (phases.size() > round_start && phases.back().state == PomodoroState::Break) {
+                    offset_ms -= static_cast<Uint64>(phases.back().length_s) * 1000;
+                    phases.pop_back();
+                }
+            }
+        }
+    }
+
+    void append_phase(const IntervalStep& step) {
+        auto [it, added] = label_indices.try_emplace(step.label, static_cast<Uint32>(labels.size()));
+        if (added)
+            labels.push_back(step.label);
+        offset_ms += static_cast<Uint64>(step.length_s) * 1000;
+        phases.push_back({step.state, it->second, 0, 0, step.length_s, offset_ms});
+    }
+};
+
+}
+
+std::optional<int> parse_duration_s(std::string_view text) {
+    if (auto seconds = parse_number<int>(text))
+        return *seconds >= 0 ? seconds : std::nullopt;
+
+    // summed wide so "9999999h" is refused rather than wrapping around
+    Sint64 total = 0;
+    while (!text.empty()) {
+        size_t unit = text.find_first_of("hms");
+        if (unit == 0 || unit == std::string_view::npos)
+            return std::nullopt;
+        auto value = parse_number<int>(text.substr(0, unit));
+        if (!value.has_value() || *value < 0)
+            return std::nullopt;
+        total += static_cast<Sint64>(*value) * (text[unit] == 'h' ? 3600 : text[unit] == 'm' ? 60 : 1);
+        if (total > std::numeric_limits<int>::max())
+            return std::nullopt;
+        text.remove_prefix(unit + 1);
+    }
+    return static_cast<int>(total);
+}
+
+std::optional<std::vector<IntervalStep>> parse_interval_sequence(std::string_view text, std::string& error) {
+    std::vector<IntervalStep> steps;
+    if (!parse_steps(text, 0, steps, error))
+        return std::nullopt;
+    if (!text.empty()) {
+        error = std::format("Unexpected \"{}\"", text.substr(0, 1));
+        return std::nullopt;
+    }
+    if (count_phases(steps) > max_interval_phases) {
+        error = std::format("A session can't have more than {} phases", max_interval_phases);
+        return std::nullopt;
+    }
+    // "1x(rest 5m)" loses its only phase to the last round's trailing breaks
+    if (!has_work(steps) && PomodoroSchedule {steps}.phase_count() == 0) {
+        error = "A session needs at least one work phase";
+        return std::nullopt;
+    }
+    return steps;
+}
+
+PomodoroSchedule::PomodoroSchedule(int work_time_s, int break_time_s, int repeat)
+    : PomodoroSchedule(std::vector<IntervalStep> {{
+          .repeat = repeat,
+          // every work session is followed by a break except the last one
+          .steps = {{PomodoroState::Work, "Work", work_time_s}, {PomodoroState::Break, "Break", break_time_s}},
+      }})
+{
+}
+
+PomodoroSchedule::PomodoroSchedule(const std::vector<IntervalStep>& steps) {
+    ScheduleBuilder builder {phasesM, labelsM};
+    builder.append(steps);
+
+    // "2/3" for each label, once it's known how many of them there are
+    std::vector<int> counts(labelsM.size());
+    for (PomodoroPhase& phase : phasesM)
+        phase.round = ++counts[phase.label];
+    for (PomodoroPhase& phase : phasesM)
+        phase.rounds = counts[phase.label];
+}
+
+size_t PomodoroSchedule::phase_at(Uint64 elapsed_ms) const {
+    // first phase that hasn't ended yet
+    auto it = std::upper_bound(phasesM.begin(), phasesM.end(), elapsed_ms,
+            [](Uint64 elapsed, const PomodoroPhase& phase) { return elapsed < phase.end_offset_ms; });
+    return it - phasesM.begin();
+}
+
+size_t PomodoroSchedule::phase_at(Uint64 elapsed_ms, size_t hint) const {
+    if (hint < phasesM.size() && elapsed_ms >= get_phase_start_ms(hint) && elapsed_ms < phasesM[hint].end_offset_ms)
+        return hint;
+    return phase_at(elapsed_ms);
+}
+
+Uint64 PomodoroSchedule::get_phase_start_ms(size_t index) const {
+    return index == 0 ? 0 : phasesM[index - 1].end_offset_ms;
+}
+
+Uint64 PomodoroSchedule::get_total_ms() const {
+    return phasesM.empty() ? 0 : phasesM.back().end_offset_ms;
+}
+
+namespace {
+
+// "warm-up 1/1, work 1/8, ..." of every phase, to compare against
+std::string describe_phases(const PomodoroSchedule& schedule) {
+    std::string text;
+    for (size_t i = 0; i < schedule.phase_count(); i++) {
+        const PomodoroPhase& phase = schedule.get_phase(i);
+        if (!text.empty())
+            text += ", ";
+        text += std::format("{}{} {}/{}", phase.state == PomodoroState::Break ? "~" : "", schedule.get_label(phase),
+                            phase.round, phase.rounds);
+    }
+    return text;
+}
+
+bool check_schedules() {
+    bool ok = true;
+    auto expect = [&](const char* what, const std::string& got, const std::string& expected) {
+        if (got != expected) {
+            std::println(stderr, "{}: expected\n  {}\nbut got\n  {}", what, expected, got);
+            ok = false;
+        }
+    };
+
+    PomodoroSchedule pomodoro {25 * 60, 5 * 60, 3};
+    expect("work/break", describe_phases(pomodoro), "Work 1/3, ~Break 1/2, Work 2/3, ~Break 2/2, Work 3/3");
+    expect("work/break length", std::to_string(pomodoro.get_total_ms()), std::to_string((3 * 25 + 2 * 5) * 60'000));
+
+    std::string error;
+    auto steps = parse_interval_sequence("warm-up 5m, 2x(3 x (work 25m, rest 5m), Long Break 15m), cool-down 5m", error);
+    PomodoroSchedule nested {steps.value_or(std::vector<IntervalStep> {})};
+    expect("nested repeats", describe_phases(nested),
+           "warm-up 1/1, work 1/6, ~rest 1/4, work 2/6, ~rest 2/4, work 3/6, ~Long Break 1/1, "
+           "work 4/6, ~rest 3/4, work 5/6, ~rest 4/4, work 6/6, cool-down 1/1");
+    expect("nested length", std::to_string(nested.get_total_ms()), std::to_string((5 + 6 * 25 + 4 * 5 + 15 + 5) * 60'000));
+    // the phase running at each boundary is the one that starts there
+    size_t boundary_misses = 0;
+    for (size_t i = 0; i < nested.phase_count(); i++)
+        if (nested.phase_at(nested.get_phase_start_ms(i)) != i)
+            boundary_misses++;
+    expect("phase boundaries", std::to_string(boundary_misses), "0");
+
+    // an explicit break after a block stays
+    steps = parse_interval_sequence("4x(sprint 30s, rest 90s), rest 5m", error);
+    expect("trailing break", describe_phases(PomodoroSchedule {steps.value_or(std::vector<IntervalStep> {})}),
+           "sprint 1/4, ~rest 1/4, sprint 2/4, ~rest 2/4, sprint 3/4, ~rest 3/4, sprint 4/4, ~rest 4/4");
+
+    for (const char* invalid : {"", "work", "work 0m", "25m", "4x(work 25m", "work 25m)", "0x(work 1m)", "4x()",
+                                "work 25m,", "1000x(1000x(work 1s))", "work 25m (rest 5m)",
+                                "1x(rest 5m)", "2x(1x(rest 5m))"}) {
+        if (parse_interval_sequence(invalid, error).has_value()) {
+            std::println(stderr, "\"{}\" was taken for a session", invalid);
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+}
+
+bool run_interval_benchmark() {
+    using clock = std::chrono::steady_clock;
+    auto get_ns = [](clock::time_point start) {
+        return std::chrono::duration<double, std::nano>(clock::now() - start).count();
+    };
+
+    bool ok = check_schedules();
+
+    // what a frame looks up, the phase at some point of the session
+    constexpr int lookups = 1'000'000;
+    std::mt19937_64 rng {42};
+    std::string report;
+    Uint64 checksum = 0;
+    for (const char* text : {"work 25m, rest 5m", "warm-up 5m, 100x(5x(sprint 30s, rest 30s)), cool-down 5m",
+                             "10x(100x(50x(sprint 20s, rest 10s)))"}) {
+        std::string error;
+        auto start = clock::now();
+        auto steps = parse_interval_sequence(text, error);
+        if (!steps.has_value()) {
+            std::println(stderr, "Interval benchmark: {}", error);
+            return false;
+        }
+        PomodoroSchedule schedule {*steps};
+        double compile_us = get_ns(start) / 1000;
+
+        std::vector<Uint64> elapsed(4096);
+        for (Uint64& ms : elapsed)
+            ms = rng() % (schedule.get_total_ms() + 1);
+        start = clock::now();
+        for (int i = 0; i < lookups; i++)
+            checksum += schedule.phase_at(elapsed[i & 4095]);
+        double lookup_ns = get_ns(start) / lookups;
+
+        // frames moving through the whole session, each starting from the
+        // phase of the one before
+        Uint64 step_ms = std::max<Uint64>(schedule.get_total_ms() / lookups, 1);
+        size_t phase = 0;
+        start = clock::now();
+        for (Uint64 ms = 0; ms < static_cast<Uint64>(lookups) * step_ms; ms += step_ms) {
+            phase = schedule.phase_at(ms, phase);
+            checksum += phase;
+        }
+        double frame_ns = get_ns(start) / lookups;
+        if (phase != schedule.phase_at(static_cast<Uint64>(lookups - 1) * step_ms)) {
+            std::println(stderr, "Interval benchmark: the hinted lookup lost its place");
+            ok = false;
+        }
+        report += std::format("\n  {:>6} phases: compiled in {:.0f} us, {:.1f} ns to find the phase at any time, "
+                              "{:.1f} ns from the last frame's", schedule.phase_count(), compile_us, lookup_ns, frame_ns);
+    }
+
+    if (ok && checksum != 0)
+        std::println("Interval sessions: ok{}", report);
+    else
+        std::println(stderr, "Interval benchmark failed");
+    return ok && checksum != 0;
+}
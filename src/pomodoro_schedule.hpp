@@ -0,0 +1,83 @@
+#pragma once
+
+#include <SDL3/SDL_stdinc.h>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+enum class PomodoroState {
+    Work, Break
+};
+
+// Parses durations like "25m", "1h30m", "90s" or a plain number of seconds,
+// nullopt for negative durations and ones that don't fit an int
+std::optional<int> parse_duration_s(std::string_view text);
+
+// One step of an interval session: a phase, or a block of steps repeated
+struct IntervalStep {
+    // phases only
+    PomodoroState state = PomodoroState::Work;
+    std::string label;
+    int length_s = 0;
+    // blocks only, a step with steps is a block
+    int repeat = 1;
+    std::vector<IntervalStep> steps;
+};
+
+// Sessions longer than this are refused, 100x(100x(...)) adds up quickly
+constexpr size_t max_interval_phases = 100'000;
+
+// Parses a session like
+//   warm-up 5m, 3x(4x(work 25m, rest 5m), long break 15m), cool-down 5m
+// Phases are a label and a duration and are breaks if the label has the
+// word "break" or "rest" in it. "N x (...)" repeats what's in the brackets
+// N times without the breaks that would end the last round, the way a
+// pomodoro doesn't end on a break. nullopt with `error` set if the text
+// isn't a session or it has more than max_interval_phases phases.
+std::optional<std::vector<IntervalStep>> parse_interval_sequence(std::string_view text, std::string& error);
+
+struct PomodoroPhase {
+    PomodoroState state;
+    // index into the schedule's labels
+    Uint32 label;
+    // 1 based count of phases with this label, "2" in "Work 2/3", out of `rounds`
+    int round;
+    int rounds;
+    int length_s;
+    // end of the phase, measured from the start of the session
+    Uint64 end_offset_ms;
+};
+
+// The whole session laid out up front, a pomodoro's work/break alternation
+// or any interval sequence, nested repeats expanded. Phases are found from
+// the session's elapsed time with a binary search, so transitions land
+// exactly on the boundaries no matter when they are looked up. With the
+// phase of the last frame as a hint a session of a thousand phases costs
+// a frame what one of two does.
+class PomodoroSchedule {
+public:
+    PomodoroSchedule(int work_time_s, int break_time_s, int repeat);
+    explicit PomodoroSchedule(const std::vector<IntervalStep>& steps);
+
+    // Index of the phase running `elapsed_ms` into the session,
+    // phase_count() once the session is over
+    size_t phase_at(Uint64 elapsed_ms) const;
+    // The same, looking at phase `hint` first, which for a clock that moved
+    // on a frame since the phase it was last in is usually still the one
+    size_t phase_at(Uint64 elapsed_ms, size_t hint) const;
+
+    const PomodoroPhase& get_phase(size_t index) const { return phasesM[index]; }
+    const std::string& get_label(const PomodoroPhase& phase) const { return labelsM[phase.label]; }
+    Uint64 get_phase_start_ms(size_t index) const;
+    size_t phase_count() const { return phasesM.size(); }
+    Uint64 get_total_ms() const;
+
+private:
+    std::vector<PomodoroPhase> phasesM;
+    std::vector<std::string> labelsM;
+};
+
+// Checks the phases a few sessions compile to and times compiling and
+// looking up phases in sessions of 2 to 100,000 phases, for --interval-benchmark
+bool run_interval_benchmark();
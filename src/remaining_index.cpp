@@ -0,0 +1,64 @@
+#include "remaining_index.hpp"
+
+namespace {
+
+// Merges the running and stopped rows, `before` decides which one comes
+// first, and keeps the ids from position `first` up to `end`
+template <typename It, typename Before>
+void merge_rows(It running, It running_end, It stopped, It stopped_end, Before before,
+                size_t first, size_t end, std::vector<Uint64>& out) {
+    for (size_t i = 0; i < end && (running != running_end || stopped != stopped_end); i++) {
+        bool take_running = stopped == stopped_end || (running != running_end && before(*running, *stopped));
+        Uint64 id = take_running ? (running++)->second : (stopped++)->second;
+        if (i >= first)
+            out.push_back(id);
+    }
+}
+
+}
+
+void RemainingIndex::set_running(Uint64 id, Uint64 deadline_ms) {
+    place(id, true, deadline_ms);
+}
+
+void RemainingIndex::set_stopped(Uint64 id, Uint64 remaining_ms) {
+    place(id, false, remaining_ms);
+}
+
+void RemainingIndex::place(Uint64 id, bool running, Uint64 key) {
+    auto [it, added] = entriesM.try_emplace(id, Entry {running, key});
+    if (!added) {
+        (it->second.running ? runningM : stoppedM).erase({it->second.key, id});
+        it->second = {running, key};
+    }
+    // timers mostly come in with more time left than the ones before them,
+    // so the end is tried first
+    auto& set = running ? runningM : stoppedM;
+    set.emplace_hint(set.end(), key, id);
+}
+
+void RemainingIndex::erase(Uint64 id) {
+    auto it = entriesM.find(id);
+    if (it == entriesM.end())
+        return;
+
+    auto& set = it->second.running ? runningM : stoppedM;
+    set.erase({it->second.key, id});
+    entriesM.erase(it);
+}
+
+void RemainingIndex::collect(Uint64 now_ms, size_t first, size_t count, bool descending, std::vector<Uint64>& out) const {
+    // remaining time of a running timer, expired ones all sit at 0
+    auto remaining = [now_ms](const std::pair<Uint64, Uint64>& running) {
+        return running.first > now_ms ? running.first - now_ms : 0;
+    };
+
+    if (!descending)
+        merge_rows(runningM.begin(), runningM.end(), stoppedM.begin(), stoppedM.end(),
+                   [&](const auto& running, const auto& stopped) { return remaining(running) <= stopped.first; },
+                   first, first + count, out);
+    else
+        merge_rows(runningM.rbegin(), runningM.rend(), stoppedM.rbegin(), stoppedM.rend(),
+                   [&](const auto& running, const auto& stopped) { return remaining(running) >= stopped.first; },
+                   first, first + count, out);
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <SDL3/SDL_stdinc.h>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Timers ordered by remaining time, kept up to date as timers are started,
+// paused or reset rather than sorted every frame. A running timer's
+// remaining time shrinks with the clock but its deadline doesn't, so
+// running timers are ordered by deadline and stopped ones by their frozen
+// remaining time. Reading the order merges the two, which only walks as
+// far as the rows asked for.
+class RemainingIndex {
+public:
+    void set_running(Uint64 id, Uint64 deadline_ms);
+    void set_stopped(Uint64 id, Uint64 remaining_ms);
+    void erase(Uint64 id);
+    // Makes room for `count` timers, so adding them doesn't rehash
+    void reserve(size_t count) { entriesM.reserve(count); }
+
+    // Appends the ids at positions [first, first + count) of the order at
+    // `now_ms` to `out`, shortest remaining time first unless `descending`
+    void collect(Uint64 now_ms, size_t first, size_t count, bool descending, std::vector<Uint64>& out) const;
+
+    size_t size() const { return entriesM.size(); }
+
+private:
+    struct Entry {
+        bool running;
+        Uint64 key;
+    };
+
+    void place(Uint64 id, bool running, Uint64 key);
+
+    // (deadline or remaining time, id)
+    std::set<std::pair<Uint64, Uint64>> runningM;
+    std::set<std::pair<Uint64, Uint64>> stoppedM;
+    std::unordered_map<Uint64, Entry> entriesM;
+};
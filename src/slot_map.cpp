@@ -0,0 +1,133 @@
+#include "slot_map.hpp"
+#include <algorithm>
+#include <chrono>
+#include <print>
+#include <random>
+#include <unordered_map>
+
+namespace {
+
+// stands in for a timer, about as big as a TimerDisplay so scanning them
+// touches as much memory
+struct BenchTimer {
+    Uint64 id;
+    char state[248];
+};
+
+// stands in for a popout window, the timer it shows and its SDL window id
+struct BenchPopout {
+    SlotHandle timer;
+    Uint64 timer_id;
+    Uint32 window_id;
+};
+
+}
+
+bool run_slotmap_benchmark() {
+    using clock = std::chrono::steady_clock;
+    auto get_ns = [](clock::time_point start) {
+        return std::chrono::duration<double, std::nano>(clock::now() - start).count();
+    };
+
+    constexpr size_t timer_count = 10'000;
+    constexpr size_t popout_count = 50;
+    constexpr int frames = 1000;
+
+    // the timers as they were, a vector searched by id, next to the slot map
+    std::vector<BenchTimer> timer_vector(timer_count);
+    SlotMap<BenchTimer> timers;
+    timers.reserve(timer_count);
+    std::vector<SlotHandle> handles;
+    for (size_t i = 0; i < timer_count; i++) {
+        timer_vector[i].id = i + 1;
+        handles.push_back(timers.emplace(BenchTimer {i + 1, {}}));
+    }
+
+    std::mt19937 rng {42};
+    SlotMap<BenchPopout> popouts;
+    std::unordered_map<Uint32, SlotHandle> popout_by_window;
+    std::vector<Uint32> window_ids;
+    for (size_t i = 0; i < popout_count; i++) {
+        size_t timer = rng() % timer_count;
+        Uint32 window_id = static_cast<Uint32>(100 + i);
+        popout_by_window[window_id] = popouts.emplace(BenchPopout {handles[timer], timer + 1, window_id});
+        window_ids.push_back(window_id);
+    }
+
+    // every frame every popout finds its timer
+    Uint64 scan_sum = 0;
+    auto start = clock::now();
+    for (int frame = 0; frame < frames; frame++) {
+        for (const BenchPopout& popout : popouts) {
+            auto it = std::find_if(timer_vector.begin(), timer_vector.end(),
+                                   [&](const BenchTimer& timer) { return timer.id == popout.timer_id; });
+            scan_sum += it->id;
+        }
+    }
+    double scan_us = get_ns(start) / frames / 1000;
+
+    Uint64 lookup_sum = 0;
+    start = clock::now();
+    for (int frame = 0; frame < frames; frame++) {
+        for (const BenchPopout& popout : popouts)
+            lookup_sum += timers.get(popout.timer)->id;
+    }
+    double lookup_us = get_ns(start) / frames / 1000;
+    bool ok = scan_sum == lookup_sum;
+
+    // and every event finds the popout its window belongs to
+    constexpr int events = 1'000'000;
+    Uint64 event_scan_sum = 0;
+    start = clock::now();
+    for (int i = 0; i < events; i++) {
+        Uint32 window_id = window_ids[i % popout_count];
+        for (const BenchPopout& popout : popouts) {
+            if (popout.window_id == window_id) {
+                event_scan_sum += popout.timer_id;
+                break;
+            }
+        }
+    }
+    double event_scan_ns = get_ns(start) / events;
+
+    Uint64 event_lookup_sum = 0;
+    start = clock::now();
+    for (int i = 0; i < events; i++)
+        event_lookup_sum += popouts.get(popout_by_window[window_ids[i % popout_count]])->timer_id;
+    double event_lookup_ns = get_ns(start) / events;
+    ok = ok && event_scan_sum == event_lookup_sum;
+
+    // half the timers go and as many new ones come, the handles of the ones
+    // that went must not find the new ones in their slots
+    start = clock::now();
+    for (size_t i = 0; i < timer_count; i += 2)
+        ok = ok && timers.erase(handles[i]);
+    std::vector<SlotHandle> new_handles;
+    for (size_t i = 0; i < timer_count; i += 2)
+        new_handles.push_back(timers.emplace(BenchTimer {timer_count + i + 1, {}}));
+    double churn_ns = get_ns(start) / timer_count;
+
+    Uint64 id_sum = 0;
+    for (const BenchTimer& timer : timers)
+        id_sum += timer.id;
+    Uint64 expected_sum = 0;
+    for (size_t i = 0; i < timer_count; i++)
+        expected_sum += i % 2 == 0 ? timer_count + i + 1 : i + 1;
+    ok = ok && timers.size() == timer_count && id_sum == expected_sum;
+    for (size_t i = 0; i < timer_count; i++) {
+        const BenchTimer* timer = timers.get(handles[i]);
+        ok = ok && (i % 2 == 0 ? timer == nullptr : timer != nullptr && timer->id == i + 1);
+    }
+    for (size_t i = 0; i < new_handles.size(); i++)
+        ok = ok && timers.get(new_handles[i])->id == timer_count + i * 2 + 1;
+
+    if (ok) {
+        std::println("{} timers, {} popouts: finding every popout's timer {:.1f} us a frame by id, {:.2f} us by handle",
+                     timer_count, popout_count, scan_us, lookup_us);
+        std::println("Finding the popout of an event {:.1f} ns by scanning, {:.1f} ns through the map, "
+                     "{:.1f} ns to erase or add a timer", event_scan_ns, event_lookup_ns, churn_ns);
+    } else {
+        std::println(stderr, "Slot map benchmark failed: a handle found the wrong timer");
+    }
+    return ok;
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <SDL3/SDL_stdinc.h>
+#include <utility>
+#include <vector>
+
+// Refers to an element of a SlotMap. The generation changes every time a
+// slot is freed, so handles to erased elements stop resolving instead of
+// pointing at whatever took their place.
+struct SlotHandle {
+    Uint32 index = SDL_MAX_UINT32;
+    Uint32 generation = 0;
+
+    // packs the handle into one integer, for use as a map key
+    Uint64 to_key() const { return static_cast<Uint64>(generation) << 32 | index; }
+    static SlotHandle from_key(Uint64 key) { return {static_cast<Uint32>(key), static_cast<Uint32>(key >> 32)}; }
+    bool operator==(const SlotHandle&) const = default;
+};
+
+// Stores elements contiguously for iteration while handing out handles that
+// stay valid across insertions and erasures, with O(1) lookup through them.
+// Erasing moves the last element into the hole, so iteration order is not
+// insertion order.
+template <typename T>
+class SlotMap {
+public:
+    template <typename... Args>
+    SlotHandle emplace(Args&&... args) {
+        Uint32 slot;
+        if (!free_slotsM.empty()) {
+            slot = free_slotsM.back();
+            free_slotsM.pop_back();
+        } else {
+            slot = static_cast<Uint32>(slotsM.size());
+            // generation 0 is left to default constructed handles
+            slotsM.push_back({0, 1});
+        }
+
+        valuesM.emplace_back(std::forward<Args>(args)...);
+        dense_to_slotM.push_back(slot);
+        slotsM[slot].dense_index = static_cast<Uint32>(valuesM.size() - 1);
+
+        return {slot, slotsM[slot].generation};
+    }
+
+    bool erase(SlotHandle handle) {
+        if (!contains(handle))
+            return false;
+
+        Uint32 dense = slotsM[handle.index].dense_index;
+        Uint32 last = static_cast<Uint32>(valuesM.size() - 1);
+        if (dense != last) {
+            valuesM[dense] = std::move(valuesM[last]);
+            dense_to_slotM[dense] = dense_to_slotM[last];
+            slotsM[dense_to_slotM[dense]].dense_index = dense;
+        }
+        valuesM.pop_back();
+        dense_to_slotM.pop_back();
+
+        slotsM[handle.index].generation++;
+        free_slotsM.push_back(handle.index);
+        return true;
+    }
+
+    bool contains(SlotHandle handle) const {
+        return handle.index < slotsM.size() && slotsM[handle.index].generation == handle.generation;
+    }
+
+    T* get(SlotHandle handle) {
+        return contains(handle) ? &valuesM[slotsM[handle.index].dense_index] : nullptr;
+    }
+
+    const T* get(SlotHandle handle) const {
+        return contains(handle) ? &valuesM[slotsM[handle.index].dense_index] : nullptr;
+    }
+
+    // Handle of the element at position `dense_index` of the iteration order
+    SlotHandle handle_at(size_t dense_index) const {
+        Uint32 slot = dense_to_slotM[dense_index];
+        return {slot, slotsM[slot].generation};
+    }
+
+    T& operator[](size_t dense_index) { return valuesM[dense_index]; }
+    const T& operator[](size_t dense_index) const { return valuesM[dense_index]; }
+
+    size_t size() const { return valuesM.size(); }
+    bool empty() const { return valuesM.empty(); }
+
+    // Makes room for `count` elements in all, so inserting them moves nothing
+    void reserve(size_t count) {
+        valuesM.reserve(count);
+        dense_to_slotM.reserve(count);
+        slotsM.reserve(count);
+    }
+
+    auto begin() { return valuesM.begin(); }
+    auto end() { return valuesM.end(); }
+    auto begin() const { return valuesM.begin(); }
+    auto end() const { return valuesM.end(); }
+
+private:
+    struct Slot {
+        Uint32 dense_index;
+        Uint32 generation;
+    };
+
+    std::vector<T> valuesM;
+    std::vector<Uint32> dense_to_slotM;
+    std::vector<Slot> slotsM;
+    std::vector<Uint32> free_slotsM;
+};
+
+// Times 50 popouts finding their timers among 10,000 by handle against
+// scanning for their ids, and events finding their popout, and checks the
+// handles of erased timers stop resolving, for --slotmap-benchmark
+bool run_slotmap_benchmark();
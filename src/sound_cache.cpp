@@ -0,0 +1,144 @@
+#include "sound_cache.hpp"
+
+ma_result decode_sound(const char* path, ma_uint32 channels, ma_uint32 sample_rate, size_t stream_above_bytes, Sound& out) {
+    ma_decoder_config config = ma_decoder_config_init(ma_format_f32, channels, sample_rate);
+    ma_decoder decoder;
+    ma_result result = ma_decoder_init_file(path, &config, &decoder);
+    if (result != MA_SUCCESS)
+        return result;
+
+    out.path = path;
+    out.streamed = false;
+    out.length_in_frames = 0;
+
+    ma_uint64 length = 0;
+    if (ma_decoder_get_length_in_pcm_frames(&decoder, &length) == MA_SUCCESS && length != 0) {
+        if (length * channels * sizeof(float) > stream_above_bytes) {
+            ma_decoder_uninit(&decoder);
+            out.streamed = true;
+            out.length_in_frames = length;
+            return MA_SUCCESS;
+        }
+        out.pcm.reserve(length * channels);
+    }
+
+    // the length of compressed formats can be an estimate, so this reads
+    // until the decoder runs dry
+    constexpr ma_uint64 chunk_frames = 4096;
+    ma_uint64 frames_read = 0;
+    do {
+        size_t used = out.pcm.size();
+        out.pcm.resize(used + chunk_frames * channels);
+        result = ma_decoder_read_pcm_frames(&decoder, out.pcm.data() + used, chunk_frames, &frames_read);
+        out.pcm.resize(used + frames_read * channels);
+    } while (result == MA_SUCCESS && frames_read == chunk_frames);
+
+    ma_decoder_uninit(&decoder);
+    out.length_in_frames = out.pcm.size() / channels;
+    return out.pcm.empty() ? MA_INVALID_FILE : MA_SUCCESS;
+}
+
+SoundCache::SoundCache(size_t budget_bytes)
+    : bytesM {0}, budgetM {budget_bytes}, hitsM {0}, missesM {0}, channelsM {0}, sample_rateM {0}, stoppingM {false}
+{
+}
+
+SoundCache::~SoundCache() {
+    {
+        std::lock_guard lock(mutexM);
+        stoppingM = true;
+    }
+    queue_changedM.notify_all();
+    if (loaderM.joinable())
+        loaderM.join();
+}
+
+void SoundCache::start(ma_uint32 channels, ma_uint32 sample_rate) {
+    channelsM = channels;
+    sample_rateM = sample_rate;
+    loaderM = std::thread(&SoundCache::run_loader, this);
+}
+
+std::shared_ptr<const Sound> SoundCache::get(const std::string& path) {
+    std::lock_guard lock(mutexM);
+    auto it = entriesM.find(path);
+    if (it == entriesM.end()) {
+        missesM++;
+        queue_load(path);
+        return nullptr;
+    }
+
+    hitsM++;
+    lruM.splice(lruM.begin(), lruM, it->second.lru_pos);
+    return it->second.sound;
+}
+
+void SoundCache::prefetch(const std::string& path) {
+    std::lock_guard lock(mutexM);
+    // picking a sound that failed before tries it again, the file may have been fixed
+    failedM.erase(path);
+    if (!entriesM.contains(path))
+        queue_load(path);
+}
+
+void SoundCache::set_budget(size_t budget_bytes) {
+    std::lock_guard lock(mutexM);
+    budgetM = budget_bytes;
+    evict();
+}
+
+SoundCacheStats SoundCache::get_stats() const {
+    std::lock_guard lock(mutexM);
+    return {hitsM, missesM, bytesM, budgetM, entriesM.size()};
+}
+
+void SoundCache::queue_load(const std::string& path) {
+    if (pendingM.contains(path) || failedM.contains(path))
+        return;
+    pendingM.insert(path);
+    queueM.push_back(path);
+    queue_changedM.notify_one();
+}
+
+void SoundCache::insert(const std::string& path, std::shared_ptr<const Sound> sound) {
+    size_t bytes = sound->pcm.size() * sizeof(float);
+    lruM.push_front(path);
+    entriesM[path] = {std::move(sound), lruM.begin(), bytes};
+    bytesM += bytes;
+    evict();
+}
+
+void SoundCache::evict() {
+    // the most recent sound stays even if it's over budget on its own
+    while (bytesM > budgetM && lruM.size() > 1) {
+        auto it = entriesM.find(lruM.back());
+        bytesM -= it->second.bytes;
+        entriesM.erase(it);
+        lruM.pop_back();
+    }
+}
+
+void SoundCache::run_loader() {
+    std::unique_lock lock(mutexM);
+    while (true) {
+        queue_changedM.wait(lock, [this] { return stoppingM || !queueM.empty(); });
+        if (stoppingM)
+            return;
+
+        std::string path = std::move(queueM.front());
+        queueM.pop_front();
+        // sounds that would take up more than a quarter of the budget are streamed
+        size_t stream_above_bytes = budgetM / 4;
+
+        lock.unlock();
+        auto sound = std::make_shared<Sound>();
+        ma_result result = decode_sound(path.c_str(), channelsM, sample_rateM, stream_above_bytes, *sound);
+        lock.lock();
+
+        pendingM.erase(path);
+        if (result != MA_SUCCESS)
+            failedM.insert(path);
+        else
+            insert(path, std::move(sound));
+    }
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "miniaudio.h"
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// A sound ready to play. Short files are decoded up front to interleaved
+// f32 PCM in the engine's format, files too long to keep in memory only
+// remember their path and are streamed from disk.
+struct Sound {
+    std::string path;
+    std::vector<float> pcm;
+    ma_uint64 length_in_frames;
+    bool streamed;
+};
+
+struct SoundCacheStats {
+    size_t hits;
+    size_t misses;
+    size_t bytes;
+    size_t budget_bytes;
+    size_t sounds;
+};
+
+// Decodes `path` into `out` at the given channel count and sample rate.
+// Files whose decoded size would be over `stream_above_bytes` are left
+// to be streamed instead.
+ma_result decode_sound(const char* path, ma_uint32 channels, ma_uint32 sample_rate, size_t stream_above_bytes, Sound& out);
+
+// Sounds picked by the user, kept decoded while they fit in a byte budget
+// and evicted least recently used first. Loading happens on a thread of
+// its own: looking up a sound that isn't loaded yet returns nothing and
+// queues it, so the UI thread never waits on the disk or the decoder.
+// Evicted sounds stay alive for as long as a voice still plays them.
+class SoundCache {
+public:
+    SoundCache(size_t budget_bytes);
+    ~SoundCache();
+
+    SoundCache(const SoundCache&) = delete;
+    SoundCache& operator=(const SoundCache&) = delete;
+
+    // Starts the loader thread, sounds are decoded to this format
+    void start(ma_uint32 channels, ma_uint32 sample_rate);
+
+    // The sound at `path`, or nullptr while it's loading or if it failed to load
+    std::shared_ptr<const Sound> get(const std::string& path);
+    // Queues `path` for loading without counting a lookup
+    void prefetch(const std::string& path);
+
+    void set_budget(size_t budget_bytes);
+    SoundCacheStats get_stats() const;
+
+private:
+    struct Entry {
+        std::shared_ptr<const Sound> sound;
+        std::list<std::string>::iterator lru_pos;
+        size_t bytes;
+    };
+
+    mutable std::mutex mutexM;
+    std::condition_variable queue_changedM;
+    std::deque<std::string> queueM;
+    // queued or being loaded
+    std::unordered_set<std::string> pendingM;
+    std::unordered_set<std::string> failedM;
+
+    std::unordered_map<std::string, Entry> entriesM;
+    // most recently used at the front
+    std::list<std::string> lruM;
+    size_t bytesM;
+    size_t budgetM;
+    size_t hitsM;
+    size_t missesM;
+
+    ma_uint32 channelsM;
+    ma_uint32 sample_rateM;
+    bool stoppingM;
+    std::thread loaderM;
+
+    // all of these expect mutexM to be held
+    void queue_load(const std::string& path);
+    void insert(const std::string& path, std::shared_ptr<const Sound> sound);
+    void evict();
+
+    void run_loader();
+};
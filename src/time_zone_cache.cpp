@@ -0,0 +1,190 @@
+#include "time_zone_cache.hpp"
+#include "local_time.hpp"
+#include <SDL3/SDL_time.h>
+#include <SDL3/SDL_timer.h>
+
+#ifdef __linux__
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// alarms look at the days around now, so this only fills up after months
+// of running
+constexpr size_t max_days = 4096;
+
+#ifdef __linux__
+
+constexpr const char* local_time_path = "/etc/localtime";
+
+// Watches the zone file /etc/localtime links to, which a tzdata update
+// replaces without touching the link, -1 if it's not a link
+int watch_link_target(int inotify_fd) {
+    char target[PATH_MAX];
+    if (realpath(local_time_path, target) == nullptr || std::strcmp(target, local_time_path) == 0)
+        return -1;
+    return inotify_add_watch(inotify_fd, target, IN_CLOSE_WRITE | IN_ATTRIB | IN_MOVE_SELF | IN_DELETE_SELF);
+}
+
+#endif
+
+}
+
+TimeZoneCache::TimeZoneCache()
+    : last_offset_sM(0)
+    , lookupsM(0)
+    , missesM(0)
+    , generationM(0)
+    , seen_generationM(0)
+    , watchingM(false)
+    , change_fdM(-1)
+    , stop_fdM(-1)
+{
+}
+
+TimeZoneCache::~TimeZoneCache() {
+#ifdef __linux__
+    if (watcherM.joinable()) {
+        Uint64 one = 1;
+        [[maybe_unused]] auto written = write(stop_fdM, &one, sizeof(one));
+        watcherM.join();
+    }
+    if (change_fdM >= 0)
+        close(change_fdM);
+    if (stop_fdM >= 0)
+        close(stop_fdM);
+#else
+    if (watcherM.joinable())
+        watcherM.join();
+#endif
+}
+
+void TimeZoneCache::start() {
+    if (watcherM.joinable())
+        return;
+#ifdef __linux__
+    change_fdM = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    stop_fdM = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+#endif
+    watcherM = std::thread(&TimeZoneCache::run_watcher, this);
+}
+
+bool TimeZoneCache::take_change() {
+    Uint64 generation = generationM.load(std::memory_order_acquire);
+    if (generation == seen_generationM)
+        return false;
+    seen_generationM = generation;
+    clear();
+    return true;
+}
+
+void TimeZoneCache::clear() {
+    daysM.clear();
+}
+
+Sint64 TimeZoneCache::get_local_day(Sint64 wall_ms) {
+    // guessed with the offset of the last day, which is right unless the
+    // offset changes around then or the time is far away
+    for (int attempt = 0; attempt < 2; attempt++) {
+        Sint64 day = divide_down(wall_ms + last_offset_sM * 1000LL, ms_per_day);
+        const DayZone& zone = get_day(day);
+        if (zone.changes)
+            break;
+        if (zone.offset_s == last_offset_sM)
+            return day;
+        last_offset_sM = zone.offset_s;
+    }
+    return ::get_local_day(wall_ms);
+}
+
+Sint64 TimeZoneCache::get_wall_ms_from_local(Sint64 day, Sint64 second_of_day) {
+    const DayZone& zone = get_day(day);
+    if (zone.changes)
+        return ::get_wall_ms_from_local(day, second_of_day);
+    last_offset_sM = zone.offset_s;
+    return day * ms_per_day + (second_of_day - zone.offset_s) * 1000;
+}
+
+const TimeZoneCache::DayZone& TimeZoneCache::get_day(Sint64 day) {
+    lookupsM++;
+    auto it = daysM.find(day);
+    if (it != daysM.end())
+        return it->second;
+
+    missesM++;
+    if (daysM.size() >= max_days)
+        daysM.clear();
+    // the same two points get_wall_ms_from_local() looks at for any time of
+    // the day, no zone changes its offset twice in between
+    int before_s = get_utc_offset_s((day - 1) * ms_per_day);
+    int after_s = get_utc_offset_s((day + 2) * ms_per_day);
+    return daysM.emplace(day, DayZone {before_s, before_s != after_s}).first->second;
+}
+
+void TimeZoneCache::run_watcher() {
+    // the first conversion is what reads the zone file, this way it's this
+    // thread that waits for it
+    reread_time_zone();
+    SDL_Time now;
+    if (SDL_GetCurrentTime(&now))
+        get_utc_offset_s(now / SDL_NS_PER_MS);
+
+#ifdef __linux__
+    int inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd < 0)
+        return;
+    // the directory, since setting the zone replaces the link
+    int directory_watch = inotify_add_watch(inotify_fd, "/etc", IN_CREATE | IN_MOVED_TO | IN_CLOSE_WRITE | IN_DELETE | IN_ATTRIB);
+    if (directory_watch < 0) {
+        close(inotify_fd);
+        return;
+    }
+    int target_watch = watch_link_target(inotify_fd);
+    watchingM.store(true, std::memory_order_release);
+
+    pollfd fds[2] = {{inotify_fd, POLLIN, 0}, {stop_fdM, POLLIN, 0}};
+    alignas(inotify_event) char buffer[4096];
+    while (true) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        if (fds[1].revents != 0)
+            break;
+
+        bool changed = false;
+        ssize_t length;
+        while ((length = read(inotify_fd, buffer, sizeof(buffer))) > 0) {
+            for (char* pos = buffer; pos < buffer + length;) {
+                auto* event = reinterpret_cast<inotify_event*>(pos);
+                if (event->wd == target_watch ||
+                    (event->wd == directory_watch && event->len != 0 && std::strcmp(event->name, "localtime") == 0))
+                    changed = true;
+                pos += sizeof(inotify_event) + event->len;
+            }
+        }
+        if (!changed)
+            continue;
+
+        // the link may lead somewhere else now
+        if (target_watch >= 0)
+            inotify_rm_watch(inotify_fd, target_watch);
+        target_watch = watch_link_target(inotify_fd);
+        reread_time_zone();
+        generationM.fetch_add(1, std::memory_order_release);
+        Uint64 one = 1;
+        [[maybe_unused]] auto written = write(change_fdM, &one, sizeof(one));
+    }
+
+    watchingM.store(false, std::memory_order_release);
+    close(inotify_fd);
+#endif
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <SDL3/SDL_stdinc.h>
+#include <atomic>
+#include <thread>
+#include <unordered_map>
+
+// The local time conversions of the alarms, remembered per local day so
+// on all but the few days around a daylight saving change they're plain
+// arithmetic. start() reads the system's time zone on a thread of its own,
+// so the first conversion doesn't wait on the zone file, and on Linux that
+// thread then watches /etc/localtime and the file it links to with inotify.
+// Everything remembered is forgotten once the zone changes.
+class TimeZoneCache {
+public:
+    TimeZoneCache();
+    ~TimeZoneCache();
+    TimeZoneCache(const TimeZoneCache&) = delete;
+    TimeZoneCache& operator=(const TimeZoneCache&) = delete;
+
+    // Starts the thread that reads the time zone and watches it
+    void start();
+    // Whether zone changes are noticed by the watcher, otherwise they have
+    // to be looked for by reading the zone again
+    bool is_watching() const { return watchingM.load(std::memory_order_acquire); }
+    // Readable once the watcher saw the zone change, for the daemon's
+    // epoll, -1 before start() and where zones aren't watched
+    int get_change_fd() const { return change_fdM; }
+    // True once for every change the watcher saw since the last call,
+    // which also forgets everything remembered
+    bool take_change();
+    // Forgets everything remembered, after the zone was changed some other way
+    void clear();
+
+    // Same as the functions of local_time.hpp, `second_of_day` is less
+    // than a day
+    Sint64 get_local_day(Sint64 wall_ms);
+    Sint64 get_wall_ms_from_local(Sint64 day, Sint64 second_of_day);
+
+    // How many days were looked up and how many of them weren't remembered yet
+    Uint64 get_lookups() const { return lookupsM; }
+    Uint64 get_misses() const { return missesM; }
+
+private:
+    struct DayZone {
+        // offset from the day before until the day after, when it doesn't change
+        int offset_s;
+        bool changes;
+    };
+
+    std::unordered_map<Sint64, DayZone> daysM;
+    // offset of the last day looked up, the guess for the next one
+    int last_offset_sM;
+    Uint64 lookupsM;
+    Uint64 missesM;
+
+    std::atomic<Uint64> generationM;
+    Uint64 seen_generationM;
+    std::atomic<bool> watchingM;
+    int change_fdM;
+    int stop_fdM;
+    std::thread watcherM;
+
+    const DayZone& get_day(Sint64 day);
+    void run_watcher();
+};
@@ -0,0 +1,143 @@
+#include "timer_batch.hpp"
+#include "clock.hpp"
+#include <algorithm>
+#include <chrono>
+#include <print>
+#include <random>
+
+namespace {
+
+// Both sides of every select are computed up front and the loop has no
+// branches, a conditional subtraction could raise an FP exception and would
+// keep the compiler from vectorizing. restrict is only honoured on
+// parameters, which is why this isn't part of TimerBatch::update.
+void update_rows(size_t n, double now, const double* __restrict start, const double* __restrict paused,
+                 const double* __restrict paused_start, const double* __restrict offset, const double* __restrict duration,
+                 double* __restrict elapsed_out, double* __restrict remaining_out, float* __restrict progress_out) {
+    for (size_t i = 0; i < n; i++) {
+        double since_pause = now - paused_start[i];
+        double running = now - start[i] - paused[i] - (paused_start[i] != 0 ? since_pause : 0.0);
+        // a timer that isn't running waits at the start of its phase
+        double raw = start[i] != 0 ? running : offset[i];
+        double elapsed = std::max(raw - offset[i], 0.0);
+        double progress = elapsed / std::max(duration[i], 1.0);
+
+        elapsed_out[i] = elapsed;
+        remaining_out[i] = std::max(duration[i] - elapsed, 0.0);
+        progress_out[i] = static_cast<float>(progress < 1 ? progress : 1);
+    }
+}
+
+}
+
+TimerFrame compute_timer_frame(const TimerTiming& timing, Uint64 now_ms) {
+    double start = timing.start_ms, paused = timing.paused_ms, paused_start = timing.paused_start_ms;
+    double offset = timing.offset_ms, duration = timing.duration_ms;
+    double elapsed, remaining;
+    float progress;
+    update_rows(1, static_cast<double>(now_ms), &start, &paused, &paused_start, &offset, &duration,
+                &elapsed, &remaining, &progress);
+    return {static_cast<Uint64>(elapsed), static_cast<Uint64>(remaining), progress, remaining == 0};
+}
+
+void TimerBatch::set_row(size_t row, const TimerTiming& timing) {
+    if (row >= startM.size()) {
+        size_t new_size = row + 1;
+        startM.resize(new_size);
+        pausedM.resize(new_size);
+        paused_startM.resize(new_size);
+        offsetM.resize(new_size);
+        durationM.resize(new_size);
+        elapsedM.resize(new_size);
+        remainingM.resize(new_size);
+        progressM.resize(new_size);
+    }
+
+    startM[row] = timing.start_ms;
+    pausedM[row] = timing.paused_ms;
+    paused_startM[row] = timing.paused_start_ms;
+    offsetM[row] = timing.offset_ms;
+    durationM[row] = timing.duration_ms;
+}
+
+void TimerBatch::reserve(size_t rows) {
+    for (auto* column : {&startM, &pausedM, &paused_startM, &offsetM, &durationM, &elapsedM, &remainingM})
+        column->reserve(rows);
+    progressM.reserve(rows);
+}
+
+void TimerBatch::update(Uint64 now_ms) {
+    update_rows(startM.size(), static_cast<double>(now_ms), startM.data(), pausedM.data(), paused_startM.data(),
+                offsetM.data(), durationM.data(), elapsedM.data(), remainingM.data(), progressM.data());
+}
+
+TimerFrame TimerBatch::get_frame(size_t row) const {
+    // a timer is done exactly when nothing remains, so that column doubles as the done flag
+    return {static_cast<Uint64>(elapsedM[row]), static_cast<Uint64>(remainingM[row]), progressM[row], remainingM[row] == 0};
+}
+
+bool run_batch_benchmark() {
+    using clock = std::chrono::steady_clock;
+    auto get_ns = [](clock::time_point start) {
+        return std::chrono::duration<double, std::nano>(clock::now() - start).count();
+    };
+
+    bool ok = true;
+    std::mt19937 rng {42};
+    for (size_t timer_count : {1'000, 10'000, 100'000}) {
+        // a mix of timers that are stopped, running, paused and done, an
+        // hour into the run of the app
+        Uint64 now = 3'600'000;
+        std::vector<TimerTiming> timings(timer_count);
+        TimerBatch batch;
+        for (size_t i = 0; i < timer_count; i++) {
+            TimerTiming& timing = timings[i];
+            timing.duration_ms = (1 + rng() % 3600) * 1000;
+            if (i % 4 != 0) {
+                timing.start_ms = 1 + rng() % now;
+                timing.paused_ms = rng() % (now - timing.start_ms + 1) / 2;
+                if (i % 4 == 2)
+                    timing.paused_start_ms = now - rng() % (now - timing.start_ms - timing.paused_ms + 1);
+            }
+            batch.set_row(i, timing);
+        }
+
+        // the whole batch against every view working out its timer's frame
+        // on its own from a clock reading, three times a frame, the way they
+        // used to
+        int frames = static_cast<int>(10'000'000 / timer_count);
+        Uint64 batch_sum = 0;
+        auto start = clock::now();
+        for (int frame = 0; frame < frames; frame++) {
+            batch.update(now + frame);
+            for (size_t i = 0; i < timer_count; i++)
+                batch_sum += batch.get_frame(i).remaining_ms;
+        }
+        double batch_ns = get_ns(start) / frames / timer_count;
+
+        Uint64 single_sum = 0;
+        start = clock::now();
+        for (int frame = 0; frame < frames; frame++) {
+            for (size_t i = 0; i < timer_count; i++) {
+                for (int call = 0; call < 3; call++)
+                    single_sum += compute_timer_frame(timings[i], clock_now_ms()).done;
+            }
+        }
+        double single_ns = get_ns(start) / frames / timer_count;
+
+        batch.update(now);
+        for (size_t i = 0; i < timer_count; i++) {
+            TimerFrame expected = compute_timer_frame(timings[i], now);
+            TimerFrame frame = batch.get_frame(i);
+            ok = ok && frame.elapsed_ms == expected.elapsed_ms && frame.remaining_ms == expected.remaining_ms &&
+                 frame.progress == expected.progress && frame.done == expected.done;
+        }
+        // also keeps the loops above from being optimized out
+        ok = ok && batch_sum > 0 && single_sum <= static_cast<Uint64>(frames) * timer_count * 3;
+        std::println("{} timers: {:.2f} ns per timer in the batch, {:.1f} ns one at a time, {:.1f} us a frame",
+                     timer_count, batch_ns, single_ns, batch_ns * timer_count / 1000);
+    }
+    if (!ok)
+        std::println(stderr, "Batch benchmark failed: the batch doesn't match the timers' own frames");
+    return ok;
+}
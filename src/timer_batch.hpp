@@ -0,0 +1,61 @@
+#pragma once
+
+#include <SDL3/SDL_stdinc.h>
+#include <vector>
+
+// What a timer's progress is computed from, see TimerDisplay for the meaning
+// of each field. A start of 0 means the timer hasn't been started.
+struct TimerTiming {
+    Uint64 start_ms;
+    Uint64 paused_ms;
+    Uint64 paused_start_ms;
+    Uint64 offset_ms;
+    Uint64 duration_ms;
+};
+
+// A timer's progress at one instant
+struct TimerFrame {
+    Uint64 elapsed_ms;
+    Uint64 remaining_ms;
+    float progress;
+    bool done;
+};
+
+TimerFrame compute_timer_frame(const TimerTiming& timing, Uint64 now_ms);
+
+// Progress of every timer, computed once per tick from a single clock
+// reading. Inputs and results are kept in parallel arrays so update() is
+// one branch free loop the compiler can vectorize. Times are stored as
+// doubles, which hold whole milliseconds exactly and, unlike 64 bit
+// integers, convert to the progress fraction without AVX-512. Rows are
+// addressed by the caller, AppState uses the timer's slot index so rows
+// never move.
+class TimerBatch {
+public:
+    // Copies the timing into `row`, growing the batch if needed
+    void set_row(size_t row, const TimerTiming& timing);
+    // Makes room for `rows` rows, so growing to them moves nothing
+    void reserve(size_t rows);
+
+    void update(Uint64 now_ms);
+
+    TimerFrame get_frame(size_t row) const;
+    size_t size() const { return startM.size(); }
+
+private:
+    // inputs
+    std::vector<double> startM;
+    std::vector<double> pausedM;
+    std::vector<double> paused_startM;
+    std::vector<double> offsetM;
+    std::vector<double> durationM;
+
+    // results of the last update()
+    std::vector<double> elapsedM;
+    std::vector<double> remainingM;
+    std::vector<float> progressM;
+};
+
+// Checks a batch of 1,000, 10,000 and 100,000 timers against computing
+// each timer's frame on its own and times both, for --batch-benchmark
+bool run_batch_benchmark();
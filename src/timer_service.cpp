@@ -0,0 +1,667 @@
+#include "timer_service.hpp"
+#include "clock.hpp"
+#include "local_time.hpp"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <format>
+#include <memory>
+#include <print>
+#include <stdexcept>
+#include <unordered_map>
+
+TimerDisplay* get_timer(TimerService& service, SlotHandle handle) {
+    if (handle == pomodoro_timer_handle)
+        return service.pomodoro_timer.has_value() ? &service.pomodoro_timer->get_timer() : nullptr;
+    return service.timers.get(handle);
+}
+
+static void schedule_alarm_events(TimerService& service, SlotHandle handle, const TimerDisplay& timer, Uint64 deadline, Uint64 now) {
+    // the alarm starts early so the ring in the sound lands on the deadline,
+    // timers shorter than that start it right away
+    Uint64 alarm_ms = std::max(deadline - std::min(deadline, timer.get_alarm_lead_ms()), now);
+    service.alarm_deadlines.schedule(handle.to_key(), alarm_ms - std::min(alarm_ms, alarm_arm_ahead_ms));
+    service.expiry_deadlines.schedule(handle.to_key(), deadline);
+}
+
+static JournalState get_journal_state(bool started, bool paused) {
+    if (!started)
+        return JournalState::Idle;
+    return paused ? JournalState::Paused : JournalState::Running;
+}
+
+static JournalRecord get_timer_record(const TimerService& service, SlotHandle handle, const TimerDisplay& timer,
+                                      JournalState state) {
+    if (handle == pomodoro_timer_handle) {
+        const PomodoroTimer& pomodoro = *service.pomodoro_timer;
+        return {JournalKind::Pomodoro, state, handle.to_key(), journal_wall_ms(), timer.get_elapsed_ms(),
+                pomodoro.get_work_time_s(), pomodoro.get_break_time_s(), pomodoro.get_repeat(), pomodoro.get_all_sounds(),
+                pomodoro.get_sequence()};
+    }
+    auto length_s = static_cast<Sint32>(timer.get_timing().duration_ms / 1000);
+    return {JournalKind::Timer, state, handle.to_key(), journal_wall_ms(), timer.get_elapsed_ms(),
+            length_s, 0, 0, {timer.get_label(), timer.get_sound()}};
+}
+
+static JournalRecord get_timer_record(const TimerService& service, SlotHandle handle, const TimerDisplay& timer) {
+    return get_timer_record(service, handle, timer, get_journal_state(timer.is_started(), timer.is_paused()));
+}
+
+static JournalRecord get_stopwatch_record(SlotHandle handle, const StopwatchDisplay& stopwatch) {
+    return {JournalKind::Stopwatch, get_journal_state(stopwatch.is_started(), stopwatch.is_paused()), handle.to_key(),
+            journal_wall_ms(), stopwatch.calculate_time_progress_ms(), 0, 0, 0, {}};
+}
+
+static JournalRecord get_alarm_record(SlotHandle handle, const Alarm& alarm, JournalState state) {
+    const AlarmRule& rule = alarm.rule;
+    Sint32 days = rule.repeat == AlarmRepeat::Weekdays ? rule.weekdays : rule.interval_days;
+    std::string dates = format_alarm_dates(rule.repeat == AlarmRepeat::EveryNDays ? std::vector {rule.first_day} : rule.dates);
+    return {JournalKind::Alarm, state, handle.to_key(), journal_wall_ms(), static_cast<Uint64>(alarm.next_ms.value_or(0)),
+            rule.time_of_day_s, static_cast<Sint32>(rule.repeat), days, {alarm.label, alarm.sound, std::move(dates), {}}};
+}
+
+static JournalRecord get_alarm_record(SlotHandle handle, const Alarm& alarm) {
+    return get_alarm_record(handle, alarm, alarm.enabled ? JournalState::Running : JournalState::Idle);
+}
+
+static Alarm get_alarm_from_record(const JournalRecord& record) {
+    Alarm alarm;
+    AlarmRule& rule = alarm.rule;
+    rule.repeat = static_cast<AlarmRepeat>(std::clamp(record.break_s, 0, static_cast<Sint32>(AlarmRepeat::EveryNDays)));
+    rule.time_of_day_s = record.length_s;
+    auto dates = parse_alarm_dates(record.strings[2]).value_or(std::vector<Sint64> {});
+    if (rule.repeat == AlarmRepeat::Weekdays)
+        rule.weekdays = static_cast<Uint8>(record.repeat);
+    else if (rule.repeat == AlarmRepeat::EveryNDays)
+        rule.interval_days = record.repeat;
+    if (rule.repeat == AlarmRepeat::EveryNDays)
+        rule.first_day = dates.empty() ? 0 : dates.front();
+    else
+        rule.dates = std::move(dates);
+    alarm.label = record.strings[0];
+    alarm.sound = record.strings[1];
+    alarm.enabled = record.state == JournalState::Running;
+    return alarm;
+}
+
+// keeps the timer's row in the batch and its place in the order up to date
+static void update_timer_order(TimerService& service, SlotHandle handle, const TimerDisplay& timer) {
+    service.timer_batch.set_row(handle.index, timer.get_timing());
+    if (auto deadline = timer.get_deadline_ms())
+        service.timer_order.set_running(handle.to_key(), *deadline);
+    else
+        service.timer_order.set_stopped(handle.to_key(), compute_timer_frame(timer.get_timing(), clock_now_ms()).remaining_ms);
+}
+
+static HistoryKind get_phase_kind(const PomodoroPhase& phase) {
+    return phase.state == PomodoroState::Work ? HistoryKind::Work : HistoryKind::Break;
+}
+
+// Adds the pomodoro phases that ended since the last call to the history.
+// Their ends are worked out from the schedule, so phases the session went
+// through all at once, after a suspend say, still get their own times.
+static void record_pomodoro_phases(TimerService& service) {
+    PomodoroTimer& pomodoro = *service.pomodoro_timer;
+    pomodoro.update();
+    auto [first, last] = pomodoro.take_completed_phases();
+    if (first == last)
+        return;
+
+    Sint64 session_start_ms = journal_wall_ms() - static_cast<Sint64>(pomodoro.get_timer().get_elapsed_ms());
+    for (size_t i = first; i < last; i++) {
+        const PomodoroPhase& phase = pomodoro.get_schedule().get_phase(i);
+        service.history.append(get_phase_kind(phase), true, session_start_ms + static_cast<Sint64>(phase.end_offset_ms),
+                               static_cast<Uint64>(phase.length_s) * 1000, pomodoro.get_phase_label(i));
+    }
+}
+
+// A timer or pomodoro phase reset before it ran out still goes into the
+// history, as a stopped run
+static void record_stopped_run(TimerService& service, SlotHandle handle, TimerDisplay& timer) {
+    auto run_ms = timer.take_stopped_run();
+    if (!run_ms.has_value())
+        return;
+
+    if (handle == pomodoro_timer_handle) {
+        const PomodoroTimer& pomodoro = *service.pomodoro_timer;
+        if (pomodoro.get_phase_index() >= pomodoro.get_schedule().phase_count())
+            return;
+        const PomodoroPhase& phase = pomodoro.get_schedule().get_phase(pomodoro.get_phase_index());
+        service.history.append(get_phase_kind(phase), false, journal_wall_ms(), *run_ms,
+                               pomodoro.get_phase_label(pomodoro.get_phase_index()));
+    } else {
+        service.history.append(HistoryKind::Timer, false, journal_wall_ms(), *run_ms, timer.get_label());
+    }
+}
+
+void sync_timer_events(TimerService& service, SlotHandle handle) {
+    TimerDisplay* timer = get_timer(service, handle);
+    if (timer == nullptr)
+        return;
+    // moving to the phase the clock is in can be a schedule change of its own
+    if (handle == pomodoro_timer_handle)
+        record_pomodoro_phases(service);
+    if (!timer->take_schedule_change())
+        return;
+
+    service.journal.append(get_timer_record(service, handle, *timer));
+    record_stopped_run(service, handle, *timer);
+
+    auto deadline = timer->get_deadline_ms();
+    if (handle != pomodoro_timer_handle)
+        update_timer_order(service, handle, *timer);
+
+    // an alarm that's already ringing keeps going, one that's only
+    // scheduled is for a deadline that no longer holds
+    service.audio_player.cancel_pending(handle.to_key());
+    if (handle == pomodoro_timer_handle)
+        service.audio_player.cancel_pending(pomodoro_cue_handle.to_key());
+
+    if (!deadline.has_value()) {
+        service.alarm_deadlines.cancel(handle.to_key());
+        service.expiry_deadlines.cancel(handle.to_key());
+        return;
+    }
+
+    schedule_alarm_events(service, handle, *timer, *deadline, clock_now_ms());
+}
+
+// "Stopwatch 2", what the runs of a stopwatch and their laps are recorded as
+static std::string get_stopwatch_label(SlotHandle handle) {
+    return std::format("Stopwatch {}", handle.index + 1);
+}
+
+// Adds the laps that ended since the last call to the history, as they
+// end, so they can be exported next to the run they're part of
+static void record_laps(TimerService& service, SlotHandle handle, StopwatchDisplay& stopwatch) {
+    const LapStore& laps = stopwatch.get_laps();
+    size_t count = std::min<Uint64>(stopwatch.take_new_laps(), laps.size());
+    Sint64 run_ns = static_cast<Sint64>(stopwatch.calculate_time_progress_ns());
+    Sint64 wall_now = journal_wall_ms();
+    for (size_t index = laps.size() - count; index < laps.size(); index++) {
+        Sint64 end_ms = wall_now - (run_ns - laps.get_split_ns(index)) / 1'000'000;
+        auto lap_ns = static_cast<Uint64>(laps.get_lap_ns(index));
+        service.history.append(HistoryKind::Lap, true, end_ms, lap_ns / 1'000'000,
+                               std::format("{} lap {}", get_stopwatch_label(handle), laps.get_number(index)),
+                               static_cast<Uint32>(lap_ns % 1'000'000));
+    }
+}
+
+void sync_stopwatch(TimerService& service, SlotHandle handle) {
+    StopwatchDisplay* stopwatch = service.stopwatches.get(handle);
+    if (stopwatch == nullptr)
+        return;
+    record_laps(service, handle, *stopwatch);
+    if (!stopwatch->take_state_change())
+        return;
+
+    service.journal.append(get_stopwatch_record(handle, *stopwatch));
+    if (auto run_ms = stopwatch->take_finished_run())
+        service.history.append(HistoryKind::Stopwatch, true, journal_wall_ms(), *run_ms, get_stopwatch_label(handle));
+}
+
+static SlotHandle insert_timer(TimerService& service, TimerDisplay timer) {
+    auto handle = service.timers.emplace(std::move(timer));
+    TimerDisplay& inserted = *service.timers.get(handle);
+    inserted.set_id(handle);
+    update_timer_order(service, handle, inserted);
+    return handle;
+}
+
+SlotHandle add_timer(TimerService& service, const TimerDisplay& timer) {
+    auto handle = insert_timer(service, timer);
+    service.journal.append(get_timer_record(service, handle, *service.timers.get(handle)));
+    return handle;
+}
+
+SlotHandle start_new_timer(TimerService& service, int seconds) {
+    auto handle = add_timer(service, TimerDisplay {seconds});
+    service.timers.get(handle)->start();
+    sync_timer_events(service, handle);
+    return handle;
+}
+
+SlotHandle add_stopwatch(TimerService& service, const StopwatchDisplay& stopwatch) {
+    auto handle = service.stopwatches.emplace(stopwatch);
+    service.stopwatches.get(handle)->set_id(handle);
+    service.journal.append(get_stopwatch_record(handle, stopwatch));
+    return handle;
+}
+
+static void ring_alarm(TimerService& service, SlotHandle handle, const Alarm& alarm) {
+    // without a lead in, the default sound starts at its ring
+    Uint64 lead_ms = alarm.sound.empty() ? timer_sound_goes_off_ms : 0;
+    service.audio_player.play_alarm(get_alarm_sound_key(handle), alarm.sound, lead_ms, 0, alarm_fade_in_ms);
+    if (std::find(service.ringing_alarms.begin(), service.ringing_alarms.end(), handle) == service.ringing_alarms.end())
+        service.ringing_alarms.push_back(handle);
+}
+
+SlotHandle add_alarm(TimerService& service, Alarm alarm) {
+    auto handle = service.alarms.add(std::move(alarm), journal_wall_ms());
+    service.journal.append(get_alarm_record(handle, *service.alarms.get(handle)));
+    return handle;
+}
+
+void sync_alarm(TimerService& service, SlotHandle handle) {
+    service.alarms.update(handle, journal_wall_ms());
+    if (const Alarm* alarm = service.alarms.get(handle))
+        service.journal.append(get_alarm_record(handle, *alarm));
+}
+
+void remove_alarm(TimerService& service, SlotHandle handle) {
+    const Alarm* alarm = service.alarms.get(handle);
+    if (alarm == nullptr)
+        return;
+    service.journal.append(get_alarm_record(handle, *alarm, JournalState::Removed));
+    dismiss_alarm(service, handle);
+    service.alarms.remove(handle);
+}
+
+void dismiss_alarm(TimerService& service, SlotHandle handle) {
+    service.audio_player.stop(get_alarm_sound_key(handle));
+    std::erase(service.ringing_alarms, handle);
+}
+
+// What the journal needs to bring back everything there is now
+static std::vector<JournalRecord> get_live_records(const TimerService& service) {
+    std::vector<JournalRecord> live;
+    live.reserve(service.timers.size() + service.stopwatches.size() + service.alarms.size() + 1);
+    for (size_t i = 0; i < service.timers.size(); i++)
+        live.push_back(get_timer_record(service, service.timers.handle_at(i), service.timers[i]));
+    for (size_t i = 0; i < service.stopwatches.size(); i++)
+        live.push_back(get_stopwatch_record(service.stopwatches.handle_at(i), service.stopwatches[i]));
+    if (service.pomodoro_timer.has_value())
+        live.push_back(get_timer_record(service, pomodoro_timer_handle, service.pomodoro_timer->get_timer()));
+    const SlotMap<Alarm>& alarms = service.alarms.get_alarms();
+    for (size_t i = 0; i < alarms.size(); i++)
+        live.push_back(get_alarm_record(alarms.handle_at(i), alarms[i]));
+    return live;
+}
+
+void restore_timers(TimerService& service) {
+    auto records = service.journal.restore();
+    Sint64 wall_now = journal_wall_ms();
+    size_t timer_count = std::count_if(records.begin(), records.end(),
+                                       [](const JournalRecord& record) { return record.kind == JournalKind::Timer; });
+    service.timers.reserve(timer_count);
+    service.stopwatches.reserve(records.size() - timer_count);
+    // everything a timer is added to, so restoring thousands grows nothing
+    service.timer_batch.reserve(timer_count);
+    service.timer_order.reserve(timer_count);
+    service.alarm_deadlines.reserve(timer_count);
+    service.expiry_deadlines.reserve(timer_count);
+
+    for (JournalRecord& record : records) {
+        Uint64 elapsed_ms = record.elapsed_ms;
+        if (record.state == JournalState::Running && wall_now > record.wall_ms)
+            elapsed_ms += wall_now - record.wall_ms;
+        bool resumes = record.state == JournalState::Running || record.state == JournalState::Paused;
+        bool paused = record.state == JournalState::Paused;
+
+        switch (record.kind) {
+            case JournalKind::Timer: {
+                TimerDisplay timer {record.length_s, record.strings[0]};
+                timer.set_sound(record.strings[1]);
+                // a timer that already rang comes back reset
+                if (resumes)
+                    timer.restore(elapsed_ms, paused);
+                timer.take_schedule_change();
+                auto deadline = timer.get_deadline_ms();
+                auto handle = insert_timer(service, std::move(timer));
+                if (deadline.has_value())
+                    schedule_alarm_events(service, handle, *service.timers.get(handle), *deadline, clock_now_ms());
+                record.id = handle.to_key();
+                break;
+            }
+
+            case JournalKind::Stopwatch: {
+                auto handle = service.stopwatches.emplace();
+                StopwatchDisplay& stopwatch = *service.stopwatches.get(handle);
+                stopwatch.set_id(handle);
+                if (resumes)
+                    stopwatch.restore(elapsed_ms, paused);
+                record.id = handle.to_key();
+                break;
+            }
+
+            case JournalKind::Pomodoro: {
+                std::optional<std::vector<IntervalStep>> steps;
+                if (!record.sequence.empty()) {
+                    std::string error;
+                    steps = parse_interval_sequence(record.sequence, error);
+                    if (!steps.has_value()) {
+                        std::println(stderr, "Couldn't restore the interval session \"{}\": {}", record.sequence, error);
+                        break;
+                    }
+                }
+                PomodoroTimer& pomodoro = steps.has_value()
+                    ? service.pomodoro_timer.emplace(record.sequence, PomodoroSchedule {*steps})
+                    : service.pomodoro_timer.emplace(record.length_s, record.break_s, record.repeat);
+                pomodoro.set_sounds(record.strings[0], record.strings[1]);
+                pomodoro.set_start_sounds(record.strings[2], record.strings[3]);
+                if (resumes) {
+                    pomodoro.get_timer().restore(elapsed_ms, paused);
+                    pomodoro.update();
+                    // the phases that ended while the app wasn't running
+                    // still go into the history on the next sync
+                    pomodoro.mark_phases_reported(pomodoro.get_schedule().phase_at(record.elapsed_ms));
+                }
+                TimerDisplay& timer = pomodoro.get_timer();
+                timer.take_schedule_change();
+                if (auto deadline = timer.get_deadline_ms())
+                    schedule_alarm_events(service, pomodoro_timer_handle, timer, *deadline, clock_now_ms());
+                break;
+            }
+
+            case JournalKind::Alarm: {
+                // like a timer that ran out, an alarm due while the app
+                // wasn't running goes off right away, once
+                bool missed = record.state == JournalState::Running && record.elapsed_ms != 0 &&
+                              static_cast<Sint64>(record.elapsed_ms) <= wall_now;
+                auto handle = service.alarms.add(get_alarm_from_record(record), wall_now);
+                const Alarm& alarm = *service.alarms.get(handle);
+                if (missed)
+                    ring_alarm(service, handle, alarm);
+                record = get_alarm_record(handle, alarm);
+                break;
+            }
+        }
+    }
+
+    if (!records.empty())
+        std::println("Restored {} timer(s) and stopwatch(es) from the journal", records.size());
+    // the ids changed, the records with the new ones still describe
+    // everything as of when they were taken
+    service.journal.compact(std::move(records));
+}
+
+static void start_alarm(AudioPlayer& ap, SlotHandle handle, const TimerDisplay& timer, Uint64 deadline_ms, Uint64 now) {
+    if (ap.is_playing(handle.to_key()))
+        return;
+
+    Uint64 remaining_ms = deadline_ms > now ? deadline_ms - now : 0;
+    ap.play_alarm(handle.to_key(), timer.get_sound(), timer.get_alarm_lead_ms(), remaining_ms, alarm_fade_in_ms);
+}
+
+// The alarm ending a pomodoro phase crossfades into the start sound of
+// `phase` on the phase boundary. It's armed along with the alarm, so both
+// fades are scheduled on the engine's clock and run on the audio thread.
+static void start_phase_crossfade(TimerService& service, size_t phase, Uint64 deadline_ms, Uint64 now) {
+    const std::string* sound = service.pomodoro_timer->get_start_sound(phase);
+    if (sound == nullptr)
+        return;
+
+    Uint64 remaining_ms = deadline_ms > now ? deadline_ms - now : 0;
+    service.audio_player.crossfade(pomodoro_timer_handle.to_key(), pomodoro_cue_handle.to_key(), *sound,
+                                 remaining_ms, phase_crossfade_ms);
+}
+
+// The audio engine's clock stands still during a suspend, so alarms
+// scheduled on it would start late by however long it lasted. They're
+// cancelled and scheduled again from the timers' deadlines.
+static void rearm_alarms(TimerService& service, Uint64 now) {
+    service.audio_player.cancel_all_pending();
+    auto rearm = [&](SlotHandle handle, const TimerDisplay& timer) {
+        if (auto deadline = timer.get_deadline_ms())
+            schedule_alarm_events(service, handle, timer, *deadline, now);
+    };
+
+    for (size_t i = 0; i < service.timers.size(); i++)
+        rearm(service.timers.handle_at(i), service.timers[i]);
+    if (service.pomodoro_timer.has_value())
+        rearm(pomodoro_timer_handle, service.pomodoro_timer->get_timer());
+}
+
+// Rings the alarms that came due on the wall clock, after a suspend each
+// one that was missed once. The time zone is only looked at once a minute,
+// and right after the alarms came due, so a change of zone moves the
+// alarms within a minute of it.
+static void tick_alarms(TimerService& service) {
+    constexpr Sint64 time_zone_check_interval_ms = 60 * 1000;
+    if (service.alarms.size() == 0)
+        return;
+
+    Sint64 wall_now = journal_wall_ms();
+    auto next = service.alarms.next_fire_ms();
+    bool due = next.has_value() && *next <= wall_now;
+    if (due) {
+        service.fired_alarms.clear();
+        service.alarms.pop_due(wall_now, service.fired_alarms);
+        for (SlotHandle handle : service.fired_alarms) {
+            const Alarm& alarm = *service.alarms.get(handle);
+            ring_alarm(service, handle, alarm);
+            service.journal.append(get_alarm_record(handle, alarm));
+        }
+    }
+
+    // a watched zone is a single atomic load, otherwise it's read again once a minute
+    if (due || service.alarms.get_time_zone().is_watching() || wall_now >= service.time_zone_check_ms) {
+        service.time_zone_check_ms = wall_now + time_zone_check_interval_ms;
+        if (service.alarms.check_time_zone(wall_now)) {
+            std::println("The time zone or its offset changed, alarms rescheduled");
+            const SlotMap<Alarm>& alarms = service.alarms.get_alarms();
+            for (size_t i = 0; i < alarms.size(); i++)
+                service.journal.append(get_alarm_record(alarms.handle_at(i), alarms[i]));
+        }
+    }
+}
+
+void tick_timers(TimerService& service, Uint64 now) {
+    auto suspended_ms = clock_take_suspended_ms();
+    if (suspended_ms != 0)
+        rearm_alarms(service, now);
+
+    service.due_events.clear();
+    service.alarm_deadlines.pop_due(now, service.due_events);
+    for (const DueEvent& ev : service.due_events) {
+        SlotHandle handle = SlotHandle::from_key(ev.id);
+        TimerDisplay* timer = get_timer(service, handle);
+        if (timer == nullptr)
+            continue;
+
+        auto deadline = timer->get_deadline_ms();
+        if (!deadline.has_value())
+            continue;
+        start_alarm(service.audio_player, handle, *timer, *deadline, now);
+        if (handle == pomodoro_timer_handle)
+            start_phase_crossfade(service, service.pomodoro_timer->get_phase_index() + 1, *deadline, now);
+    }
+
+    service.due_events.clear();
+    size_t expired = service.expiry_deadlines.pop_due(now, service.due_events);
+    Sint64 wall_now = expired != 0 ? journal_wall_ms() : 0;
+    for (const DueEvent& ev : service.due_events) {
+        SlotHandle handle = SlotHandle::from_key(ev.id);
+        TimerDisplay* timer = get_timer(service, handle);
+        if (timer == nullptr)
+            continue;
+        service.expired.push_back(ev);
+        // a missed alarm goes straight to the ring
+        start_alarm(service.audio_player, handle, *timer, ev.deadline_ms, now);
+
+        if (handle == pomodoro_timer_handle) {
+            record_pomodoro_phases(service);
+            // like a missed alarm, a crossfade that hasn't started yet goes
+            // straight into the new phase
+            if (!service.audio_player.is_playing(pomodoro_cue_handle.to_key()))
+                start_phase_crossfade(service, service.pomodoro_timer->get_phase_index(), ev.deadline_ms, now);
+            if (service.pomodoro_timer->is_done()) {
+                service.journal.append(get_timer_record(service, handle, *timer, JournalState::Removed));
+                service.pomodoro_timer.reset();
+            } else {
+                sync_timer_events(service, handle);
+            }
+        } else {
+            service.journal.append(get_timer_record(service, handle, *timer, JournalState::Expired));
+            service.history.append(HistoryKind::Timer, true, wall_now - static_cast<Sint64>(now - ev.deadline_ms),
+                                   timer->get_timing().duration_ms, timer->get_label());
+        }
+    }
+
+    tick_alarms(service);
+
+    if (service.journal.wants_compaction())
+        service.journal.compact(get_live_records(service));
+
+    if (suspended_ms != 0)
+        std::println("Resumed after being suspended for {} s, {} timer(s) expired meanwhile", suspended_ms / 1000, expired);
+}
+
+std::optional<Uint64> next_timer_event_ms(TimerService& service) {
+    auto alarm = service.alarm_deadlines.next_deadline();
+    auto expiry = service.expiry_deadlines.next_deadline();
+    if (alarm.has_value() && expiry.has_value())
+        return std::min(*alarm, *expiry);
+    return alarm.has_value() ? alarm : expiry;
+}
+
+std::optional<Sint64> next_alarm_ms(TimerService& service) {
+    return service.alarms.next_fire_ms();
+}
+
+bool run_suspend_check(const char* sound_path, int timer_count) {
+    std::unique_ptr<TimerService> service;
+    try {
+        service.reset(new TimerService {.audio_player = {sound_path, AudioOptions {.no_device = true}}});
+    } catch (const std::runtime_error& e) {
+        std::println(stderr, "Suspend check failed: {}", e.what());
+        return false;
+    }
+
+    // timers of 10 s, 20 s, 30 s and so on, every fifth one paused, which
+    // mustn't run out however long the suspend
+    std::unordered_map<Uint64, Uint64> deadlines;
+    for (int i = 0; i < timer_count; i++) {
+        auto handle = add_timer(*service, TimerDisplay {(i + 1) * 10});
+        TimerDisplay& timer = *service->timers.get(handle);
+        timer.start();
+        if (i % 5 == 4)
+            timer.pause();
+        sync_timer_events(*service, handle);
+        if (auto deadline = timer.get_deadline_ms())
+            deadlines[handle.to_key()] = *deadline;
+    }
+    tick_timers(*service, clock_now_ms());
+    bool ok = service->expired.empty();
+
+    // halfway through the longest timer, so about half of them run out
+    // while the system is asleep
+    Uint64 suspend_ms = static_cast<Uint64>(timer_count) * 5'000;
+    clock_simulate_suspend(suspend_ms);
+    service->expired.clear();
+    Uint64 now = clock_now_ms();
+    auto start = std::chrono::steady_clock::now();
+    tick_timers(*service, now);
+    double tick_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    // every timer whose deadline passed comes out of that one tick, with
+    // the deadline it had and not the time the system woke up
+    size_t due = 0;
+    for (auto [id, deadline] : deadlines)
+        due += deadline <= now;
+    ok = ok && service->expired.size() == due && due > 0 && due < deadlines.size();
+    for (const DueEvent& ev : service->expired) {
+        auto it = deadlines.find(ev.id);
+        ok = ok && it != deadlines.end() && it->second == ev.deadline_ms && ev.deadline_ms <= now;
+    }
+
+    // and nothing is left over for the next one
+    service->expired.clear();
+    tick_timers(*service, clock_now_ms());
+    ok = ok && service->expired.empty();
+
+    if (ok)
+        std::println("{} of {} timers ran out during a simulated suspend of {} s and came out of one tick "
+                     "with their own deadlines, in {:.2f} ms", due, timer_count, suspend_ms / 1000, tick_ms);
+    else
+        std::println(stderr, "Suspend check failed: the timers that ran out during the suspend didn't come out "
+                             "of one tick with their deadlines");
+    return ok;
+}
+
+bool run_journal_benchmark(const char* sound_path, int timer_count) {
+    namespace fs = std::filesystem;
+    using clock = std::chrono::steady_clock;
+    auto get_ms = [](clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(clock::now() - start).count();
+    };
+    constexpr double budget_ms = 10;
+    constexpr int rounds = 5;
+
+    fs::path directory = fs::temp_directory_path() / std::format("timepad-journal-bench-{}", clock::now().time_since_epoch().count());
+    fs::path written = directory / "written";
+    fs::path restored = directory / "restored";
+    std::error_code error;
+    // nothing here needs to survive a power cut
+    JournalOptions options {.fsync = FsyncPolicy::Never};
+    auto new_service = [&]() -> std::unique_ptr<TimerService> {
+        try {
+            return std::unique_ptr<TimerService>(new TimerService {.audio_player = {sound_path, AudioOptions {.no_device = true}}});
+        } catch (const std::runtime_error& e) {
+            std::println(stderr, "Journal benchmark failed: {}", e.what());
+            return nullptr;
+        }
+    };
+
+    // a running, a paused and an idle timer in turn, the writer has
+    // flushed them all once the service is gone
+    {
+        auto service = new_service();
+        if (service == nullptr)
+            return false;
+        if (!service->journal.open(written.string(), options)) {
+            std::println(stderr, "Journal benchmark failed: couldn't open a journal in {}", written.string());
+            fs::remove_all(directory, error);
+            return false;
+        }
+        for (int i = 0; i < timer_count; i++) {
+            auto handle = add_timer(*service, TimerDisplay {60 + i, std::format("Timer {}", i + 1)});
+            if (i % 3 != 2) {
+                service->timers.get(handle)->start();
+                if (i % 3 == 1)
+                    service->timers.get(handle)->pause();
+                sync_timer_events(*service, handle);
+            }
+        }
+    }
+    Uint64 journal_bytes = fs::file_size(written / "journal", error);
+    size_t running = (timer_count + 2) / 3;
+
+    // restoring compacts the journal, so every round starts from a copy
+    bool ok = true;
+    std::vector<double> restore_ms;
+    for (int round = 0; round < rounds && ok; round++) {
+        fs::remove_all(restored, error);
+        fs::copy(written, restored, error);
+        auto service = new_service();
+        if (service == nullptr) {
+            ok = false;
+            break;
+        }
+
+        auto start = clock::now();
+        ok = service->journal.open(restored.string(), options);
+        restore_timers(*service);
+        restore_ms.push_back(get_ms(start));
+        ok = ok && service->timers.size() == static_cast<size_t>(timer_count) &&
+             service->expiry_deadlines.size() == running;
+    }
+    fs::remove_all(directory, error);
+    if (!ok) {
+        std::println(stderr, "Journal benchmark failed: {} timers were journaled but didn't all come back as they were",
+                     timer_count);
+        return false;
+    }
+
+    // the median, a single round is at the mercy of whatever else the machine is doing
+    std::sort(restore_ms.begin(), restore_ms.end());
+    double median_ms = restore_ms[rounds / 2];
+    if (median_ms > budget_ms) {
+        std::println(stderr, "Journal benchmark failed: restoring {} timers took {:.2f} ms, more than {:.0f} ms",
+                     timer_count, median_ms, budget_ms);
+        return false;
+    }
+    std::println("Opened a journal of {} timers ({} KiB) and restored them in {:.2f} ms, {:.2f} ms at best",
+                 timer_count, journal_bytes / 1024, median_ms, restore_ms.front());
+    return true;
+}
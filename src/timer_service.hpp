@@ -0,0 +1,98 @@
+#pragma once
+
+#include "alarm_schedule.hpp"
+#include "audio_player.hpp"
+#include "deadline_queue.hpp"
+#include "history.hpp"
+#include "journal.hpp"
+#include "remaining_index.hpp"
+#include "slot_map.hpp"
+#include "timer_batch.hpp"
+#include "ui/pomodoro_timer.hpp"
+#include "ui/stopwatch_display.hpp"
+#include "ui/timer_display.hpp"
+#include <optional>
+#include <vector>
+
+// The timers, stopwatches, the pomodoro and everything that keeps their
+// alarms going. None of it needs a window: the GUI draws from it every
+// frame and the daemon only wakes up for the deadlines in its queues.
+struct TimerService {
+    SlotMap<TimerDisplay> timers;
+    SlotMap<StopwatchDisplay> stopwatches;
+    std::optional<PomodoroTimer> pomodoro_timer;
+    AudioPlayer audio_player;
+    DeadlineQueue alarm_deadlines;
+    DeadlineQueue expiry_deadlines;
+    std::vector<DueEvent> due_events;
+    // timers that ran out since whoever reports them last took them
+    std::vector<DueEvent> expired;
+    // rows are the timers' slot indices
+    TimerBatch timer_batch;
+    // keyed like the deadline queues, the pomodoro's timer isn't in it
+    RemainingIndex timer_order;
+    // every state transition goes in here once it's open
+    Journal journal;
+    // finished pomodoro phases, timers and stopwatch runs
+    HistoryStore history;
+    // wall clock alarms, unlike the timers on the system time of day
+    AlarmScheduler alarms;
+    // alarms that went off and weren't dismissed yet
+    std::vector<SlotHandle> ringing_alarms;
+    std::vector<SlotHandle> fired_alarms;
+    // wall time the time zone is looked at again
+    Sint64 time_zone_check_ms = 0;
+};
+
+// Brings back whatever the journal recorded, with the time the app wasn't
+// running counted for everything that was running, then compacts the
+// journal. Timers that ran out meanwhile ring as soon as the service ticks.
+// Expects the journal to be open and the service to be empty.
+void restore_timers(TimerService& service);
+
+// The timer behind `handle`, pomodoro_timer_handle included
+TimerDisplay* get_timer(TimerService& service, SlotHandle handle);
+SlotHandle add_timer(TimerService& service, const TimerDisplay& timer);
+// Adds a timer of `seconds` and starts it right away, for --timer
+SlotHandle start_new_timer(TimerService& service, int seconds);
+SlotHandle add_stopwatch(TimerService& service, const StopwatchDisplay& stopwatch);
+
+SlotHandle add_alarm(TimerService& service, Alarm alarm);
+// Works out the alarm's next time again and journals it after it was
+// edited, turned on or turned off
+void sync_alarm(TimerService& service, SlotHandle handle);
+void remove_alarm(TimerService& service, SlotHandle handle);
+// Stops the alarm's sound and takes it off the ringing ones
+void dismiss_alarm(TimerService& service, SlotHandle handle);
+
+// Keeps the deadline queues and the journal in sync after the timer was
+// started, paused, reset or moved to another pomodoro phase
+void sync_timer_events(TimerService& service, SlotHandle handle);
+// Journals the stopwatch if it was started, paused or reset since the last call
+void sync_stopwatch(TimerService& service, SlotHandle handle);
+
+// Handles every time driven state change that came due since the last
+// call, whether or not the timer involved is on screen, and rings the
+// alarms that came due on the wall clock. After the system
+// resumes from suspend this is everything that came due while it was
+// asleep, handled as one batch. Only due events are looked at, so idle
+// timers cost nothing here.
+void tick_timers(TimerService& service, Uint64 now);
+
+// When tick_timers next has something to do, nullopt while no timer is running
+std::optional<Uint64> next_timer_event_ms(TimerService& service);
+// Wall time tick_timers next has an alarm to ring, nullopt while none is on
+std::optional<Sint64> next_alarm_ms(TimerService& service);
+
+// Starts `timer_count` timers of growing length, moves the clock forward as
+// if the system was suspended past about half of their deadlines and checks
+// a single tick hands out every timer that ran out meanwhile, with its own
+// deadline, and none of the rest, for --suspend-check. Needs no window or
+// sound card.
+bool run_suspend_check(const char* sound_path, int timer_count);
+
+// Journals `timer_count` labelled timers, some running and some paused, in
+// a directory of its own, then times opening the journal and restoring
+// them into a fresh service the way startup does, for --journal-benchmark.
+// Fails when that takes more than 10 ms. Needs no window or sound card.
+bool run_journal_benchmark(const char* sound_path, int timer_count);
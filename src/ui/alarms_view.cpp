@@ -0,0 +1,347 @@
+#include "alarms_view.hpp"
+#include "IconsFontAwesome7.h"
+#include "imgui.h"
+#include "imgui_stdlib.h"
+#include "local_time.hpp"
+#include <SDL3/SDL_time.h>
+#include <SDL3/SDL_timer.h>
+#include <algorithm>
+#include <format>
+
+namespace {
+
+enum RepeatChoice {
+    RepeatOnce, RepeatDaily, RepeatWeekdays, RepeatEveryNDays, RepeatDates
+};
+
+constexpr const char* repeat_names[] = {"Once", "Daily", "Days of the week", "Every few days", "On dates"};
+// Monday first, like the weekday checkboxes
+constexpr const char* weekday_names[] = {"Mon", "Tue", "Wed", "Thu", "Fri", "Sat", "Sun"};
+
+enum Column {
+    ColumnOn, ColumnTime, ColumnRepeat, ColumnLabel, ColumnNext, ColumnActions
+};
+
+// Bit of the AlarmRule weekday mask for the checkbox at `index`
+Uint8 get_weekday_bit(int index) {
+    return static_cast<Uint8>(1 << (index + 1) % 7);
+}
+
+std::string format_time_of_day(Sint32 seconds) {
+    return std::format("{:02}:{:02}", seconds / 3600, seconds / 60 % 60);
+}
+
+// Local date and time of `wall_ms`
+std::string format_wall_time(Sint64 wall_ms) {
+    SDL_DateTime dt;
+    if (!SDL_TimeToDateTime(SDL_MS_TO_NS(wall_ms), &dt, true))
+        return "-";
+    return std::format("{} {}-{:02}-{:02} {:02}:{:02}", weekday_names[(dt.day_of_week + 6) % 7], dt.year, dt.month,
+                       dt.day, dt.hour, dt.minute);
+}
+
+Sint64 get_now_ms() {
+    SDL_Time now;
+    return SDL_GetCurrentTime(&now) ? now / SDL_NS_PER_MS : 0;
+}
+
+}
+
+AlarmsView::AlarmsView()
+    : editingM(std::nullopt)
+    , order_versionM(SDL_MAX_UINT64)
+{
+    reset_editor();
+}
+
+void AlarmsView::draw(TimerService& service) {
+    ImGui::SetNextWindowSize({650.0f, 500.0f}, ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowPos({200, 30}, ImGuiCond_FirstUseEver);
+    ImGui::Begin("Alarms");
+
+    draw_editor(service);
+    ImGui::Separator();
+    draw_list(service);
+
+    ImGui::End();
+}
+
+void AlarmsView::draw_ringing(TimerService& service) {
+    if (service.ringing_alarms.empty())
+        return;
+
+    ImGui::SetNextWindowPos({ImGui::GetIO().DisplaySize.x * 0.5f, 40.0f}, ImGuiCond_FirstUseEver, {0.5f, 0.0f});
+    ImGui::Begin("Alarm", nullptr, ImGuiWindowFlags_NoSavedSettings);
+
+    std::optional<SlotHandle> dismissed;
+    for (SlotHandle handle : service.ringing_alarms) {
+        const Alarm* alarm = service.alarms.get(handle);
+        ImGui::PushID(static_cast<int>(handle.index));
+        ImGui::Text(ICON_FA_BELL " %s  %s", format_time_of_day(alarm != nullptr ? alarm->rule.time_of_day_s : 0).c_str(),
+                    alarm != nullptr ? alarm->label.c_str() : "");
+        ImGui::SameLine();
+        if (ImGui::SmallButton("Dismiss"))
+            dismissed = handle;
+        ImGui::PopID();
+    }
+    if (service.ringing_alarms.size() > 1 && ImGui::Button("Dismiss all")) {
+        while (!service.ringing_alarms.empty())
+            dismiss_alarm(service, service.ringing_alarms.back());
+    }
+    if (dismissed.has_value())
+        dismiss_alarm(service, *dismissed);
+
+    ImGui::End();
+}
+
+void AlarmsView::draw_editor(TimerService& service) {
+    ImGui::TextUnformatted(editingM.has_value() ? "Edit alarm" : "New alarm");
+
+    ImGui::SetNextItemWidth(90.0f);
+    ImGui::InputInt("##hour", &hourM);
+    ImGui::SameLine();
+    ImGui::TextUnformatted(":");
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(90.0f);
+    ImGui::InputInt("##minute", &minuteM);
+    hourM = std::clamp(hourM, 0, 23);
+    minuteM = std::clamp(minuteM, 0, 59);
+
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(160.0f);
+    ImGui::Combo("Repeat", &repeatM, repeat_names, IM_ARRAYSIZE(repeat_names));
+
+    if (repeatM == RepeatWeekdays) {
+        for (int i = 0; i < 7; i++) {
+            if (i != 0)
+                ImGui::SameLine();
+            ImGui::Checkbox(weekday_names[i], &weekdaysM[i]);
+        }
+    } else if (repeatM == RepeatEveryNDays) {
+        ImGui::SetNextItemWidth(120.0f);
+        ImGui::InputInt("days, starting", &interval_daysM);
+        interval_daysM = std::clamp(interval_daysM, 1, 365);
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(120.0f);
+        ImGui::InputTextWithHint("##first", "today", &datesM);
+    } else if (repeatM == RepeatDates) {
+        ImGui::InputTextWithHint("Dates", "2026-12-24 2026-12-31", &datesM);
+    }
+
+    ImGui::InputTextWithHint("Label", "Alarm", &labelM);
+    ImGui::InputTextWithHint("Sound", "Default sound", &soundM);
+
+    if (ImGui::Button(editingM.has_value() ? "Save" : "Add")) {
+        if (auto alarm = get_edited_alarm()) {
+            if (!alarm->sound.empty())
+                service.audio_player.preload(alarm->sound);
+            Alarm* edited = editingM.has_value() ? service.alarms.get(*editingM) : nullptr;
+            if (edited != nullptr) {
+                *edited = std::move(*alarm);
+                sync_alarm(service, *editingM);
+            } else {
+                add_alarm(service, std::move(*alarm));
+            }
+            reset_editor();
+        }
+    }
+    if (editingM.has_value()) {
+        ImGui::SameLine();
+        if (ImGui::Button("Cancel"))
+            reset_editor();
+    }
+    if (!errorM.empty()) {
+        ImGui::SameLine();
+        ImGui::TextColored({0.95f, 0.45f, 0.4f, 1.0f}, "%s", errorM.c_str());
+    }
+}
+
+void AlarmsView::draw_list(TimerService& service) {
+    const SlotMap<Alarm>& alarms = service.alarms.get_alarms();
+    if (alarms.empty()) {
+        ImGui::TextDisabled("No alarms yet");
+        return;
+    }
+
+    // soonest first, the ones that are off at the end
+    if (order_versionM != service.alarms.get_version()) {
+        order_versionM = service.alarms.get_version();
+        orderM.clear();
+        for (size_t i = 0; i < alarms.size(); i++)
+            orderM.push_back(alarms.handle_at(i));
+        std::sort(orderM.begin(), orderM.end(), [&](SlotHandle a, SlotHandle b) {
+            const Alarm& first = *alarms.get(a);
+            const Alarm& second = *alarms.get(b);
+            return first.next_ms.value_or(SDL_MAX_SINT64) < second.next_ms.value_or(SDL_MAX_SINT64);
+        });
+    }
+
+    ImGuiTableFlags flags = ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV | ImGuiTableFlags_ScrollY |
+                            ImGuiTableFlags_Resizable | ImGuiTableFlags_SizingStretchProp;
+    std::optional<SlotHandle> toggled, removed;
+    if (ImGui::BeginTable("alarms", 6, flags)) {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("On", 0, 0.3f, ColumnOn);
+        ImGui::TableSetupColumn("Time", 0, 0.5f, ColumnTime);
+        ImGui::TableSetupColumn("Repeat", 0, 1.2f, ColumnRepeat);
+        ImGui::TableSetupColumn("Label", 0, 1.2f, ColumnLabel);
+        ImGui::TableSetupColumn("Next", 0, 1.4f, ColumnNext);
+        ImGui::TableSetupColumn("", 0, 0.6f, ColumnActions);
+        ImGui::TableHeadersRow();
+
+        ImGuiListClipper clipper;
+        clipper.Begin(static_cast<int>(orderM.size()));
+        while (clipper.Step()) {
+            for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++) {
+                SlotHandle handle = orderM[row];
+                const Alarm& alarm = *alarms.get(handle);
+                ImGui::TableNextRow();
+                ImGui::PushID(static_cast<int>(handle.index));
+
+                ImGui::TableSetColumnIndex(ColumnOn);
+                bool enabled = alarm.enabled;
+                if (ImGui::Checkbox("##on", &enabled))
+                    toggled = handle;
+                ImGui::TableSetColumnIndex(ColumnTime);
+                ImGui::TextUnformatted(format_time_of_day(alarm.rule.time_of_day_s).c_str());
+                ImGui::TableSetColumnIndex(ColumnRepeat);
+                ImGui::TextUnformatted(describe_alarm_rule(alarm.rule).c_str());
+                ImGui::TableSetColumnIndex(ColumnLabel);
+                ImGui::TextUnformatted(alarm.label.c_str());
+                ImGui::TableSetColumnIndex(ColumnNext);
+                if (alarm.next_ms.has_value())
+                    ImGui::TextUnformatted(format_wall_time(*alarm.next_ms).c_str());
+                else
+                    ImGui::TextDisabled("Off");
+                ImGui::TableSetColumnIndex(ColumnActions);
+                if (ImGui::SmallButton(ICON_FA_PEN))
+                    edit(handle, alarm);
+                ImGui::SameLine();
+                if (ImGui::SmallButton(ICON_FA_TRASH))
+                    removed = handle;
+
+                ImGui::PopID();
+            }
+        }
+        clipper.End();
+
+        ImGui::EndTable();
+    }
+
+    // changed after drawing, the order they're drawn in would go stale
+    if (toggled.has_value()) {
+        Alarm& alarm = *service.alarms.get(*toggled);
+        alarm.enabled = !alarm.enabled;
+        sync_alarm(service, *toggled);
+    }
+    if (removed.has_value()) {
+        if (editingM == removed)
+            reset_editor();
+        remove_alarm(service, *removed);
+    }
+}
+
+void AlarmsView::edit(SlotHandle handle, const Alarm& alarm) {
+    reset_editor();
+    editingM = handle;
+    const AlarmRule& rule = alarm.rule;
+    hourM = rule.time_of_day_s / 3600;
+    minuteM = rule.time_of_day_s / 60 % 60;
+    labelM = alarm.label;
+    soundM = alarm.sound;
+    switch (rule.repeat) {
+        case AlarmRepeat::Dates:
+            repeatM = RepeatDates;
+            datesM = format_alarm_dates(rule.dates);
+            break;
+        case AlarmRepeat::Daily:
+            repeatM = RepeatDaily;
+            break;
+        case AlarmRepeat::Weekdays:
+            repeatM = RepeatWeekdays;
+            for (int i = 0; i < 7; i++)
+                weekdaysM[i] = rule.weekdays & get_weekday_bit(i);
+            break;
+        case AlarmRepeat::EveryNDays:
+            repeatM = RepeatEveryNDays;
+            interval_daysM = rule.interval_days;
+            datesM = format_alarm_dates({rule.first_day});
+            break;
+    }
+}
+
+void AlarmsView::reset_editor() {
+    editingM = std::nullopt;
+    hourM = 7;
+    minuteM = 0;
+    repeatM = RepeatOnce;
+    for (int i = 0; i < 7; i++)
+        weekdaysM[i] = i < 5;
+    interval_daysM = 2;
+    datesM.clear();
+    labelM.clear();
+    soundM.clear();
+    errorM.clear();
+}
+
+std::optional<Alarm> AlarmsView::get_edited_alarm() {
+    Alarm alarm;
+    AlarmRule& rule = alarm.rule;
+    rule.time_of_day_s = (hourM * 60 + minuteM) * 60;
+    alarm.label = labelM.empty() ? "Alarm" : labelM;
+    alarm.sound = soundM;
+
+    Sint64 now_ms = get_now_ms();
+    Sint64 today = get_local_day(now_ms);
+    switch (repeatM) {
+        case RepeatOnce: {
+            // the next time the clock shows it
+            rule.repeat = AlarmRepeat::Dates;
+            Sint64 day = get_wall_ms_from_local(today, rule.time_of_day_s) > now_ms ? today : today + 1;
+            rule.dates = {day};
+            break;
+        }
+
+        case RepeatDaily:
+            rule.repeat = AlarmRepeat::Daily;
+            break;
+
+        case RepeatWeekdays:
+            rule.repeat = AlarmRepeat::Weekdays;
+            rule.weekdays = 0;
+            for (int i = 0; i < 7; i++)
+                if (weekdaysM[i])
+                    rule.weekdays |= get_weekday_bit(i);
+            if (rule.weekdays == 0) {
+                errorM = "Pick at least one day";
+                return std::nullopt;
+            }
+            break;
+
+        case RepeatEveryNDays: {
+            rule.repeat = AlarmRepeat::EveryNDays;
+            rule.interval_days = interval_daysM;
+            auto first = parse_alarm_dates(datesM);
+            if (!first.has_value() || first->size() > 1) {
+                errorM = "Expected a start date like 2026-10-19";
+                return std::nullopt;
+            }
+            rule.first_day = first->empty() ? today : first->front();
+            break;
+        }
+
+        case RepeatDates: {
+            rule.repeat = AlarmRepeat::Dates;
+            auto dates = parse_alarm_dates(datesM);
+            if (!dates.has_value() || dates->empty()) {
+                errorM = "Expected dates like 2026-12-24 2026-12-31";
+                return std::nullopt;
+            }
+            rule.dates = std::move(*dates);
+            break;
+        }
+    }
+
+    errorM.clear();
+    return alarm;
+}
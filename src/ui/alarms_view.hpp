@@ -0,0 +1,44 @@
+#pragma once
+
+#include "timer_service.hpp"
+#include <optional>
+#include <string>
+#include <vector>
+
+// The Alarms tab: every alarm with the next time it goes off, soonest
+// first, and an editor for adding and changing them. The order is only
+// sorted again once an alarm was added, changed or went off, and only the
+// visible rows are drawn, so hundreds of alarms cost no more per frame
+// than a few.
+class AlarmsView {
+public:
+    AlarmsView();
+
+    void draw(TimerService& service);
+    // The alarms ringing right now with a button to dismiss them, drawn
+    // on every tab
+    void draw_ringing(TimerService& service);
+
+private:
+    // the alarm being edited, nullopt while adding a new one
+    std::optional<SlotHandle> editingM;
+    int hourM;
+    int minuteM;
+    int repeatM;
+    bool weekdaysM[7];
+    int interval_daysM;
+    std::string datesM;
+    std::string labelM;
+    std::string soundM;
+    std::string errorM;
+
+    std::vector<SlotHandle> orderM;
+    Uint64 order_versionM;
+
+    void draw_editor(TimerService& service);
+    void draw_list(TimerService& service);
+    void edit(SlotHandle handle, const Alarm& alarm);
+    void reset_editor();
+    // The alarm the editor describes, nullopt with errorM set if it's not a valid one
+    std::optional<Alarm> get_edited_alarm();
+};
@@ -49,12 +49,8 @@ void CircularProgressBar::set_progress_color(Uint8 r, Uint8 g, Uint8 b, Uint8 a)
     progress_colorM = {r, g, b, a};
 }
 
-bool CircularProgressBar::draw_arc(SDL_Renderer* renderer, float start_angle, float end_angle, 
-                                    const SDL_Color& color) {
-    if (!renderer) {
-        return false;
-    }
-    
+void CircularProgressBar::append_arc(std::vector<SDL_Vertex>& out, float start_angle, float end_angle, 
+                                     const SDL_Color& color) const {
     // Convert SDL_Color to SDL_FColor (0-255 range to 0.0-1.0 range)
     SDL_FColor fcolor;
     fcolor.r = color.r / 255.0f;
@@ -127,9 +123,7 @@ bool CircularProgressBar::draw_arc(SDL_Renderer* renderer, float start_angle, fl
             vertices[5].position.y = y1_inner;
             vertices[5].color = feather_color;
             
-            if (!SDL_RenderGeometry(renderer, nullptr, vertices, 6, nullptr, 0)) {
-                return false;
-            }
+            out.insert(out.end(), vertices, vertices + 6);
         }
     }
     
@@ -174,9 +168,7 @@ bool CircularProgressBar::draw_arc(SDL_Renderer* renderer, float start_angle, fl
         vertices[5].position.y = y1_inner;
         vertices[5].color = fcolor;
         
-        if (!SDL_RenderGeometry(renderer, nullptr, vertices, 6, nullptr, 0)) {
-            return false;
-        }
+        out.insert(out.end(), vertices, vertices + 6);
     }
     
     // Draw feathered inner edge (semi-transparent)
@@ -228,38 +220,35 @@ bool CircularProgressBar::draw_arc(SDL_Renderer* renderer, float start_angle, fl
             vertices[5].position.y = y1_inner;
             vertices[5].color = feather_color;
             
-            if (!SDL_RenderGeometry(renderer, nullptr, vertices, 6, nullptr, 0)) {
-                return false;
-            }
+            out.insert(out.end(), vertices, vertices + 6);
         }
     }
-    
-    return true;
 }
 
-bool CircularProgressBar::draw(SDL_Renderer* renderer) {
-    if (!renderer) {
-        return false;
-    }
-    
+void CircularProgressBar::append_geometry(std::vector<SDL_Vertex>& out) const {
     // Start angle at top (-90 degrees = -PI/2 radians)
     float start_angle = -M_PI / 2.0f;
     
     // Full circle is 2*PI radians
     float full_circle = 2.0f * M_PI;
     
-    // Draw background circle (full circle)
-    if (!draw_arc(renderer, start_angle, start_angle + full_circle, background_colorM)) {
-        return false;
-    }
+    // Background circle (full circle)
+    append_arc(out, start_angle, start_angle + full_circle, background_colorM);
     
-    // Draw progress arc
+    // Progress arc
     if (progressM > 0.0f) {
         float progress_angle = start_angle + (full_circle * progressM);
-        if (!draw_arc(renderer, start_angle, progress_angle, progress_colorM)) {
-            return false;
-        }
+        append_arc(out, start_angle, progress_angle, progress_colorM);
     }
-    
-    return true;
+}
+
+bool CircularProgressBar::draw(SDL_Renderer* renderer) {
+    if (!renderer) {
+        return false;
+    }
+
+    // the whole ring goes to the renderer in one call
+    verticesM.clear();
+    append_geometry(verticesM);
+    return SDL_RenderGeometry(renderer, nullptr, verticesM.data(), verticesM.size(), nullptr, 0);
 }
@@ -2,6 +2,7 @@
 #define CIRCULAR_PROGRESS_BAR_H
 
 #include <SDL3/SDL.h>
+#include <vector>
 
 class CircularProgressBar {
 public:
@@ -16,6 +17,10 @@ public:
     // Draw the progress bar
     bool draw(SDL_Renderer* renderer);
 
+    // Add the triangles of the progress bar to `out` without drawing them,
+    // for batching several bars into one draw call
+    void append_geometry(std::vector<SDL_Vertex>& out) const;
+
     // Setters for customization
     void set_position(float x, float y);
     void set_radius(float radius);
@@ -34,9 +39,12 @@ private:
     SDL_Color background_colorM;
     SDL_Color progress_colorM;
 
-    // Helper method to draw an arc
-    bool draw_arc(SDL_Renderer* renderer, float start_angle, float end_angle, 
-                  const SDL_Color& color);
+    // reused between frames so drawing doesn't allocate
+    std::vector<SDL_Vertex> verticesM;
+
+    // Helper method to add the triangles of an arc
+    void append_arc(std::vector<SDL_Vertex>& out, float start_angle, float end_angle, 
+                    const SDL_Color& color) const;
 };
 
 #endif // CIRCULAR_PROGRESS_BAR_H
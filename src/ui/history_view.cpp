@@ -0,0 +1,168 @@
+#include "history_view.hpp"
+#include "imgui.h"
+#include "imgui_stdlib.h"
+#include "ui/timer_display.hpp"
+#include <SDL3/SDL_filesystem.h>
+#include <SDL3/SDL_time.h>
+#include <SDL3/SDL_timer.h>
+#include <cfloat>
+#include <format>
+#include <numeric>
+
+namespace {
+
+constexpr int charted_days = 90;
+
+enum Column {
+    ColumnKind, ColumnLabel, ColumnStart, ColumnEnd, ColumnDuration
+};
+
+const char* get_kind_name(HistoryKind kind) {
+    switch (kind) {
+        case HistoryKind::Work: return "Work";
+        case HistoryKind::Break: return "Break";
+        case HistoryKind::Timer: return "Timer";
+        case HistoryKind::Stopwatch: return "Stopwatch";
+        case HistoryKind::Lap: return "Lap";
+    }
+    return "-";
+}
+
+// Local date and time of `wall_ms`
+std::string format_wall_time(Sint64 wall_ms) {
+    SDL_DateTime dt;
+    if (!SDL_TimeToDateTime(SDL_MS_TO_NS(wall_ms), &dt, true))
+        return "-";
+    return std::format("{}-{:02}-{:02} {:02}:{:02}", dt.year, dt.month, dt.day, dt.hour, dt.minute);
+}
+
+Sint64 get_now_ms() {
+    SDL_Time now;
+    return SDL_GetCurrentTime(&now) ? now / SDL_NS_PER_MS : 0;
+}
+
+}
+
+void HistoryView::draw(const HistoryStore& history) {
+    ImGui::SetNextWindowSize({650.0f, 500.0f}, ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowPos({200, 30}, ImGuiCond_FirstUseEver);
+    ImGui::Begin("History");
+
+    if (!history.is_open()) {
+        ImGui::TextDisabled("The history is kept next to the saved timers, which are turned off.");
+        ImGui::End();
+        return;
+    }
+
+    // the minute check also moves the chart on at midnight
+    Sint64 now_ms = get_now_ms();
+    if (history.size() != charted_countM || now_ms >= chart_expiry_msM) {
+        work_minutesM = get_daily_work_minutes(history, charted_days);
+        charted_countM = history.size();
+        chart_expiry_msM = now_ms + 60 * 1000;
+    }
+
+    // all of it comes straight from the stats' per day sums
+    const HistoryStats& stats = history.get_stats();
+    Sint64 today = get_local_today();
+    HistoryTotals week = stats.get_totals(today - 6, today);
+    HistoryTotals all = stats.get_totals(SDL_MIN_SINT64, today);
+    ImGui::Text("This week %s worked in %u sessions, %u day streak (longest %u)",
+                format_time(static_cast<int>(week.work_ms / 1000)).c_str(), week.work_count,
+                stats.get_current_streak(today), stats.get_longest_streak());
+    if (all.work_count > 0) {
+        Uint32 finished = all.work_count + all.timer_count;
+        ImGui::Text("Average work session %s, %.0f%% of work sessions and timers finished",
+                    format_time(static_cast<int>(all.work_ms / all.work_count / 1000)).c_str(),
+                    100.0 * finished / (finished + all.stopped_count));
+    }
+
+    draw_export(history);
+
+    float total_minutes = std::accumulate(work_minutesM.begin(), work_minutesM.end(), 0.0f);
+    auto overlay = std::format("today {:.0f} min, last {} days {:.1f} h", work_minutesM.back(), charted_days,
+                               total_minutes / 60.0f);
+    ImGui::PlotHistogram("##work", work_minutesM.data(), static_cast<int>(work_minutesM.size()), 0, overlay.c_str(),
+                         0.0f, FLT_MAX, {-1.0f, 120.0f});
+
+    ImGuiTableFlags flags = ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV | ImGuiTableFlags_ScrollY |
+                            ImGuiTableFlags_Resizable | ImGuiTableFlags_SizingStretchProp;
+    if (ImGui::BeginTable("history", 5, flags)) {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("Kind", 0, 0.8f, ColumnKind);
+        ImGui::TableSetupColumn("Label", 0, 1.5f, ColumnLabel);
+        ImGui::TableSetupColumn("Started", 0, 1.3f, ColumnStart);
+        ImGui::TableSetupColumn("Ended", 0, 1.3f, ColumnEnd);
+        ImGui::TableSetupColumn("Duration", 0, 1.0f, ColumnDuration);
+        ImGui::TableHeadersRow();
+
+        // a run with many laps would bury everything else
+        for (; listed_countM < history.size(); listed_countM++) {
+            if (history[listed_countM].kind != HistoryKind::Lap)
+                rowsM.push_back(listed_countM);
+        }
+        size_t count = rowsM.size();
+        ImGuiListClipper clipper;
+        clipper.Begin(static_cast<int>(count));
+        while (clipper.Step()) {
+            for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++) {
+                const HistoryRecord& record = history[rowsM[count - 1 - row]];
+                ImGui::TableNextRow();
+
+                ImGui::TableSetColumnIndex(ColumnKind);
+                ImGui::TextUnformatted(get_kind_name(record.kind));
+                if (!record.completed) {
+                    ImGui::SameLine();
+                    ImGui::TextDisabled("stopped");
+                }
+                ImGui::TableSetColumnIndex(ColumnLabel);
+                ImGui::TextUnformatted(record.label);
+                ImGui::TableSetColumnIndex(ColumnStart);
+                ImGui::TextUnformatted(format_wall_time(record.start_ms).c_str());
+                ImGui::TableSetColumnIndex(ColumnEnd);
+                ImGui::TextUnformatted(format_wall_time(record.end_ms).c_str());
+                ImGui::TableSetColumnIndex(ColumnDuration);
+                ImGui::TextUnformatted(format_time(static_cast<int>(record.duration_ms / 1000)).c_str());
+            }
+        }
+        clipper.End();
+
+        ImGui::EndTable();
+    }
+
+    ImGui::End();
+}
+
+void HistoryView::draw_export(const HistoryStore& history) {
+    if (export_pathM.empty()) {
+        const char* documents = SDL_GetUserFolder(SDL_FOLDER_DOCUMENTS);
+        export_pathM = std::string(documents != nullptr ? documents : "") + "timepad-history.csv";
+    }
+
+    ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x * 0.5f);
+    ImGui::InputTextWithHint("##export path", ".csv, .json, optionally .gz", &export_pathM);
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(ImGui::CalcTextSize("0000-00-00T00:00").x);
+    ImGui::InputTextWithHint("##export from", "from", &export_fromM);
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(ImGui::CalcTextSize("0000-00-00T00:00").x);
+    ImGui::InputTextWithHint("##export to", "to", &export_toM);
+    ImGui::SameLine();
+
+    if (exportM.is_running()) {
+        ImGui::ProgressBar(exportM.get_progress(), {-1.0f, 0.0f});
+    } else if (ImGui::Button("Export")) {
+        // empty dates leave that end of the range open
+        auto from_ms = export_fromM.empty() ? SDL_MIN_SINT64 : parse_export_time(export_fromM, false);
+        auto to_ms = export_toM.empty() ? SDL_MAX_SINT64 : parse_export_time(export_toM, true);
+        if (!from_ms.has_value() || !to_ms.has_value())
+            export_messageM = "Dates look like 2026-10-19 or 2026-10-19T14:30";
+        else if (exportM.start(history.get_directory(), *from_ms, *to_ms, export_pathM))
+            export_messageM.clear();
+    }
+
+    if (auto result = exportM.take_result())
+        export_messageM = *result;
+    if (!export_messageM.empty())
+        ImGui::TextDisabled("%s", export_messageM.c_str());
+}
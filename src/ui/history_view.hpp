@@ -0,0 +1,35 @@
+#pragma once
+
+#include "history.hpp"
+#include "history_export.hpp"
+#include <string>
+#include <vector>
+
+// Everything in the history but laps, newest first, under the week's
+// totals, streaks and a chart of the minutes worked per day. Where the
+// rows are is gathered once and then only for new records, only the
+// visible rows are read from the store, the numbers come from the
+// HistoryStats, and the chart is only worked out again once something was
+// added or a minute went by, so a long history costs no more per frame
+// than a short one. Laps are only in the export, next to their run.
+// Exports run on an ExportJob, with a progress bar in their place.
+class HistoryView {
+public:
+    void draw(const HistoryStore& history);
+
+private:
+    std::vector<float> work_minutesM;
+    size_t charted_countM = 0;
+    Sint64 chart_expiry_msM = 0;
+    // positions of the records that get a row
+    std::vector<size_t> rowsM;
+    size_t listed_countM = 0;
+
+    ExportJob exportM;
+    std::string export_pathM;
+    std::string export_fromM;
+    std::string export_toM;
+    std::string export_messageM;
+
+    void draw_export(const HistoryStore& history);
+};
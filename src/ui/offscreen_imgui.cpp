@@ -0,0 +1,51 @@
+#include "offscreen_imgui.hpp"
+#include "imgui.h"
+#include "imgui_impl_sdlrenderer3.h"
+
+OffscreenImGui::OffscreenImGui(int width, int height)
+    : surfaceM(SDL_CreateSurface(width, height, SDL_PIXELFORMAT_RGBA32))
+    , rendererM(surfaceM != nullptr ? SDL_CreateSoftwareRenderer(surfaceM) : nullptr)
+    , contextM(nullptr)
+{
+    if (rendererM == nullptr)
+        return;
+
+    contextM = ImGui::CreateContext();
+    ImGui::SetCurrentContext(contextM);
+    ImGuiIO& io = ImGui::GetIO();
+    io.IniFilename = nullptr;
+    io.DisplaySize = ImVec2(static_cast<float>(width), static_cast<float>(height));
+    ImGui::StyleColorsDark();
+    ImGui_ImplSDLRenderer3_Init(rendererM);
+}
+
+OffscreenImGui::~OffscreenImGui() {
+    if (contextM != nullptr) {
+        ImGui::SetCurrentContext(contextM);
+        ImGui_ImplSDLRenderer3_Shutdown();
+        ImGui::DestroyContext(contextM);
+    }
+    if (rendererM != nullptr)
+        SDL_DestroyRenderer(rendererM);
+    if (surfaceM != nullptr)
+        SDL_DestroySurface(surfaceM);
+}
+
+void OffscreenImGui::new_frame() {
+    ImGui::SetCurrentContext(contextM);
+    // as if every frame came right on time at 60 Hz
+    ImGui::GetIO().DeltaTime = 1.0f / 60.0f;
+    SDL_SetRenderDrawColor(rendererM, 0, 0, 0, 255);
+    SDL_RenderClear(rendererM);
+    ImGui_ImplSDLRenderer3_NewFrame();
+    ImGui::NewFrame();
+}
+
+void OffscreenImGui::end_frame() {
+    ImGui::Render();
+}
+
+void OffscreenImGui::present() {
+    ImGui_ImplSDLRenderer3_RenderDrawData(ImGui::GetDrawData(), rendererM);
+    SDL_RenderPresent(rendererM);
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+struct ImGuiContext;
+
+// An ImGui context drawing into a software renderer with no window, so
+// views can be timed frame by frame on a machine without a display. Uses
+// ImGui's default font and keeps no imgui.ini.
+class OffscreenImGui {
+public:
+    OffscreenImGui(int width, int height);
+    ~OffscreenImGui();
+
+    OffscreenImGui(const OffscreenImGui&) = delete;
+    OffscreenImGui& operator=(const OffscreenImGui&) = delete;
+
+    // False if the renderer couldn't be created, SDL_GetError() says why
+    bool is_ready() const { return rendererM != nullptr; }
+    SDL_Renderer* get_renderer() { return rendererM; }
+
+    // Starts a frame, like the app's loop does before drawing its views
+    void new_frame();
+    // Ends the frame, which is where ImGui lays out the draw lists
+    void end_frame();
+    // Draws the frame's draw lists into the renderer
+    void present();
+
+private:
+    SDL_Surface* surfaceM;
+    SDL_Renderer* rendererM;
+    ImGuiContext* contextM;
+};
@@ -1,27 +1,11 @@
 #include "pomodoro_timer.hpp"
+#include "clock.hpp"
 #include "ui/timer_display.hpp"
+#include <algorithm>
 
 std::optional<FocusState> PomodoroTimer::draw(SDL_Renderer *renderer, AudioPlayer &ap) {
-    if (timerM.is_done()) {
-        std::string new_title;
-        switch (get_current_state()) {
-            case PomodoroState::Break:
-                break_times_completedM++;
-                timerM.set_timer_value(work_time_sM);
-                new_title = std::format(format_string, work_times_completedM+1, repeatM, "work", format_time(work_time_sM));
-                break;
-
-            case PomodoroState::Work:
-                work_times_completedM++;
-                timerM.set_timer_value(break_time_sM);
-                new_title = std::format(format_string, break_times_completedM+1, repeatM-1, "break", format_time(break_time_sM));
-        }
-
-        timerM.reset(ap);
-        timerM.set_label(new_title);
-        timerM.start();
-    }
-
+    update();
+    timerM.set_frame(compute_timer_frame(timerM.get_timing(), clock_now_ms()));
 
     auto focus_state = timerM.draw(renderer, ap);
     if (focus_state.has_value() && focus_state->type != FocusType::None) {
@@ -31,10 +15,61 @@ std::optional<FocusState> PomodoroTimer::draw(SDL_Renderer *renderer, AudioPlaye
     return focus_state;
 }
 
+void PomodoroTimer::update() {
+    // from the phase of the last frame, however many phases the session has
+    auto phase_index = scheduleM.phase_at(timerM.get_elapsed_ms(), current_phaseM);
+    if (phase_index == current_phaseM)
+        return;
+    current_phaseM = phase_index;
+    // the timer keeps running, it just counts down the next part of the session
+    show_phase(phase_index);
+}
+
+void PomodoroTimer::show_phase(size_t index) {
+    if (index >= scheduleM.phase_count())
+        return;
+
+    const PomodoroPhase& phase = scheduleM.get_phase(index);
+    timerM.set_phase(phase.length_s, scheduleM.get_phase_start_ms(index));
+    timerM.set_label(std::format("{} - {}", get_phase_label(index), format_time(phase.length_s)));
+    timerM.set_sound(phase.state == PomodoroState::Work ? work_soundM : break_soundM);
+}
+
+std::string PomodoroTimer::get_phase_label(size_t index) const {
+    const PomodoroPhase& phase = scheduleM.get_phase(index);
+    return std::format("{} {}/{}", scheduleM.get_label(phase), phase.round, phase.rounds);
+}
+
+std::pair<size_t, size_t> PomodoroTimer::take_completed_phases() {
+    // phases only move forward, a reset restarts the current one, but a
+    // restored session can be marked reported past where its clock is
+    reported_phaseM = std::min(reported_phaseM, current_phaseM);
+    std::pair<size_t, size_t> completed {reported_phaseM, current_phaseM};
+    reported_phaseM = current_phaseM;
+    return completed;
+}
+
+void PomodoroTimer::set_sounds(std::string work_sound, std::string break_sound) {
+    work_soundM = std::move(work_sound);
+    break_soundM = std::move(break_sound);
+    timerM.set_sound(get_current_state() == PomodoroState::Work ? work_soundM : break_soundM);
+}
+
+void PomodoroTimer::set_start_sounds(std::string work_sound, std::string break_sound) {
+    work_start_soundM = std::move(work_sound);
+    break_start_soundM = std::move(break_sound);
+}
+
+const std::string* PomodoroTimer::get_start_sound(size_t index) const {
+    if (index >= scheduleM.phase_count())
+        return nullptr;
+
+    const std::string& sound = scheduleM.get_phase(index).state == PomodoroState::Work ? work_start_soundM : break_start_soundM;
+    return sound.empty() ? nullptr : &sound;
+}
+
 PomodoroState PomodoroTimer::get_current_state() const {
-    if (work_times_completedM == break_times_completedM)
+    if (current_phaseM >= scheduleM.phase_count())
         return PomodoroState::Work;
-    else
-        return PomodoroState::Break;
+    return scheduleM.get_phase(current_phaseM).state;
 }
-
@@ -1,43 +1,101 @@
 #pragma once
 
 #include "appstate.hpp"
+#include "pomodoro_schedule.hpp"
 #include "ui/timer_display.hpp"
+#include <array>
 #include <format>
+#include <utility>
 
-enum class PomodoroState {
-    Work, Break
-};
-
-constexpr const char* format_string {"{}/{} {} session - {}"};
+// stands in for a handle into AppState::timers for the pomodoro's timer
+constexpr SlotHandle pomodoro_timer_handle {SDL_MAX_UINT32, SDL_MAX_UINT32};
+// owner of the sound a phase starts with, so it can overlap the alarm of
+// the phase before it
+constexpr SlotHandle pomodoro_cue_handle {SDL_MAX_UINT32, SDL_MAX_UINT32 - 1};
 
 class PomodoroTimer {
 public:
     PomodoroTimer(int work_time_s, int break_time_s, int repeat)
-         : work_time_sM {work_time_s}, break_time_sM {break_time_s}, repeatM {repeat},
-           timerM {work_time_s}, work_times_completedM {}, break_times_completedM {}
+         : PomodoroTimer(work_time_s, break_time_s, repeat, {}, {work_time_s, break_time_s, repeat})
+    {
+    }
+
+    // A session of any phases, `sequence` is the text it was parsed from
+    PomodoroTimer(std::string sequence, PomodoroSchedule schedule)
+         : PomodoroTimer(0, 0, 0, std::move(sequence), std::move(schedule))
     {
-        timerM.set_label(std::format(format_string, work_times_completedM+1, repeatM, "work", format_time(work_time_sM)));
     }
 
     std::optional<FocusState> draw(SDL_Renderer *renderer, AudioPlayer &ap);
 
+    // Moves to whichever phase the clock is in, however many boundaries
+    // were crossed since the last call
+    void update();
+
     PomodoroState get_current_state() const;
-    bool is_done() {
-        return work_times_completedM == repeatM && break_times_completedM == repeatM - 1;
+
+    // Sounds played at the end of work and break phases, empty for the default sound
+    void set_sounds(std::string work_sound, std::string break_sound);
+    // Sounds the alarm crossfades into when work and break phases start, empty for none
+    void set_start_sounds(std::string work_sound, std::string break_sound);
+    // Start sound of the phase at `index`, nullptr if it has none or the session ends there
+    const std::string* get_start_sound(size_t index) const;
+    size_t get_phase_index() const { return current_phaseM; }
+    const PomodoroSchedule& get_schedule() const { return scheduleM; }
+
+    // Phases that ended since the last call, as indices [first, last)
+    std::pair<size_t, size_t> take_completed_phases();
+    // Leaves the phases before `phase` out of take_completed_phases(), for
+    // sessions restored from the journal that reported them already
+    void mark_phases_reported(size_t phase) { reported_phaseM = phase; }
+
+    // work and break lengths and the repeat of a plain pomodoro, 0 for a sequence
+    int get_work_time_s() const { return work_time_sM; }
+    int get_break_time_s() const { return break_time_sM; }
+    int get_repeat() const { return repeatM; }
+    // the interval sequence the session was made from, empty for a plain pomodoro
+    const std::string& get_sequence() const { return sequenceM; }
+    // "Work 2/4" for the phase at `index`
+    std::string get_phase_label(size_t index) const;
+    // alarm sounds of work and break phases, then their start sounds
+    std::array<std::string, 4> get_all_sounds() const {
+        return {work_soundM, break_soundM, work_start_soundM, break_start_soundM};
     }
 
+    bool is_done() const { return current_phaseM == scheduleM.phase_count(); }
+
+    TimerDisplay& get_timer() { return timerM; }
+    const TimerDisplay& get_timer() const { return timerM; }
     void set_focus_type(FocusType ft) { timerM.set_focus_type(ft); }
     FocusType get_focus_type() const { return timerM.get_focus_type(); }
 
 private:
+    PomodoroTimer(int work_time_s, int break_time_s, int repeat, std::string sequence, PomodoroSchedule schedule)
+         : work_time_sM {work_time_s}, break_time_sM {break_time_s}, repeatM {repeat}, sequenceM {std::move(sequence)},
+           scheduleM {std::move(schedule)}, current_phaseM {}, timerM {work_time_s}, reported_phaseM {}
+    {
+        timerM.set_id(pomodoro_timer_handle);
+        show_phase(0);
+        // nothing is scheduled before the session starts
+        timerM.take_schedule_change();
+    }
 
     int work_time_sM;
     int break_time_sM;
     int repeatM;
+    std::string sequenceM;
+
+    PomodoroSchedule scheduleM;
+    size_t current_phaseM;
 
     TimerDisplay timerM;
+    std::string work_soundM;
+    std::string break_soundM;
+    std::string work_start_soundM;
+    std::string break_start_soundM;
 
-    int work_times_completedM;
-    int break_times_completedM;
-};
+    size_t reported_phaseM;
 
+    // Points the timer at the phase at `index`, its title and sound
+    void show_phase(size_t index);
+};
@@ -16,6 +16,8 @@ constexpr const char* CurrentTab_to_str(CurrentTab ct) {
         return "Timer";
     else if (ct == CurrentTab::Stopwatch)
         return "Stopwatch";
+    else if (ct == CurrentTab::History)
+        return "History";
     return "Error kasdjflksjdfjaslkfdj";
 }
 
@@ -28,6 +30,8 @@ constexpr const char* CurrentTab_to_icon(CurrentTab ct) {
         return ICON_FA_HOURGLASS_START;
     else if (ct == CurrentTab::Stopwatch)
         return ICON_FA_STOPWATCH;
+    else if (ct == CurrentTab::History)
+        return ICON_FA_CLOCK_ROTATE_LEFT;
     return "Error alskjdfkls;akls";
 }
 
@@ -44,7 +48,7 @@ void draw_sidebar(CurrentTab& current_tab) {
 
     ImGui::BeginViewportSideBar("##ToolBar", viewport, ImGuiDir_Left, 0.0f, windowFlags);
 
-    for (CurrentTab ct : {CurrentTab::PomodoroTimer, CurrentTab::Timer, CurrentTab::Alarms, CurrentTab::Stopwatch}) {
+    for (CurrentTab ct : {CurrentTab::PomodoroTimer, CurrentTab::Timer, CurrentTab::Alarms, CurrentTab::Stopwatch, CurrentTab::History}) {
         bool changed = false;
         ImVec4 orig = colors[ImGuiCol_Button];
         if (ct == current_tab)
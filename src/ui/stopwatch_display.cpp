@@ -2,40 +2,105 @@
 #include "IconsFontAwesome7.h"
 #include "IconsMaterialSymbols.h"
 #include "SDL3/SDL_timer.h"
+#include "clock.hpp"
 #include "imgui.h"
 #include <algorithm>
 #include <cmath>
 #include <cstdio>
 #include <format>
 #include <print>
+#include <utility>
 
 StopwatchDisplay::StopwatchDisplay()
-    : start_time_msM(0)
-    , paused_time_msM(0)
-    , paused_time_start_msM(0)
-    , idM(SDL_GetTicks())
+    : start_time_nsM(0)
+    , paused_time_nsM(0)
+    , paused_time_start_nsM(0)
+    , idM()
     , focusM(FocusType::None)
+    , state_changedM(false)
+    , finished_run_msM(0)
+    , lapsM()
+    , new_lapsM(0)
 {
 }
 
 void StopwatchDisplay::start() {
-    start_time_msM = SDL_GetTicks();
-    paused_time_start_msM = 0;
-    std::println("Starting stopwatch: {}", start_time_msM);
+    start_time_nsM = clock_now_ns();
+    paused_time_start_nsM = 0;
+    state_changedM = true;
+    std::println("Starting stopwatch: {}", start_time_nsM);
 }
 
-unsigned long StopwatchDisplay::calculate_time_progress_ms() {
-    if (start_time_msM == 0)
+void StopwatchDisplay::pause() {
+    paused_time_start_nsM = clock_now_ns();
+    state_changedM = true;
+}
+
+void StopwatchDisplay::resume() {
+    paused_time_nsM += clock_now_ns() - paused_time_start_nsM;
+    paused_time_start_nsM = 0;
+    state_changedM = true;
+}
+
+void StopwatchDisplay::reset() {
+    if (is_started())
+        finished_run_msM = calculate_time_progress_ms();
+    start_time_nsM = 0;
+    paused_time_nsM = 0;
+    paused_time_start_nsM = 0;
+    lapsM.clear();
+    new_lapsM = 0;
+    state_changedM = true;
+    std::println("Stopwatch Reset");
+}
+
+void StopwatchDisplay::lap() {
+    if (is_started() && !is_paused()) {
+        lapsM.add(static_cast<Sint64>(calculate_time_progress_ns()));
+        new_lapsM++;
+    }
+}
+
+void StopwatchDisplay::restore(Uint64 elapsed_ms, bool paused) {
+    auto now = clock_now_ns();
+    Uint64 elapsed_ns = elapsed_ms * 1'000'000;
+    start_time_nsM = now > elapsed_ns ? now - elapsed_ns : 1;
+    paused_time_nsM = 0;
+    paused_time_start_nsM = paused ? now : 0;
+}
+
+bool StopwatchDisplay::take_state_change() {
+    bool changed = state_changedM;
+    state_changedM = false;
+    return changed;
+}
+
+std::optional<Uint64> StopwatchDisplay::take_finished_run() {
+    if (finished_run_msM == 0)
+        return std::nullopt;
+    return std::exchange(finished_run_msM, 0);
+}
+
+Uint64 StopwatchDisplay::take_new_laps() {
+    return std::exchange(new_lapsM, 0);
+}
+
+Uint64 StopwatchDisplay::calculate_time_progress_ms() const {
+    return calculate_time_progress_ns() / 1'000'000;
+}
+
+Uint64 StopwatchDisplay::calculate_time_progress_ns() const {
+    if (start_time_nsM == 0)
         return 0;
     
-    auto now = SDL_GetTicks();
-    auto paused_time_ms = paused_time_msM;
+    auto now = clock_now_ns();
+    auto paused_time_ns = paused_time_nsM;
     
-    if (paused_time_start_msM != 0)
-        paused_time_ms += now - paused_time_start_msM;
+    if (paused_time_start_nsM != 0)
+        paused_time_ns += now - paused_time_start_nsM;
 
-    auto progress_ms = (now - start_time_msM) - paused_time_ms;
-    return progress_ms;
+    auto progress_ns = (now - start_time_nsM) - paused_time_ns;
+    return progress_ns;
 }
 
 std::optional<FocusState> StopwatchDisplay::draw_header() {
@@ -94,8 +159,13 @@ std::optional<FocusState> StopwatchDisplay::draw_header() {
     return return_val;
 }
 
+bool StopwatchDisplay::shows_laps() const {
+    // the picture-in-picture window is too small for the list
+    return !lapsM.empty() && ImGui::GetWindowSize().y >= 300.0f;
+}
+
 void StopwatchDisplay::draw_stopwatch_text() {
-    unsigned long progress_ms = calculate_time_progress_ms();
+    Uint64 progress_ms = calculate_time_progress_ms();
     
     // Calculate hours, minutes, seconds, and centiseconds
     int total_seconds = progress_ms / 1000;
@@ -112,7 +182,7 @@ void StopwatchDisplay::draw_stopwatch_text() {
     // Calculate center position
     ImVec2 window_size = ImGui::GetWindowSize();
     float center_x = window_size.x * 0.5f;
-    float center_y = window_size.y * 0.45f;
+    float center_y = window_size.y * (shows_laps() ? 0.22f : 0.45f);
     
     // Large font for timer display - dynamically sized
     ImGui::PushFont(NULL, 40.0f);
@@ -166,6 +236,65 @@ void StopwatchDisplay::draw_stopwatch_text() {
     ImGui::PopFont();
 }
 
+void StopwatchDisplay::draw_laps() {
+    if (!shows_laps())
+        return;
+
+    // between the labels under the time and the buttons
+    ImVec2 window_size = ImGui::GetWindowSize();
+    float top = ImGui::GetCursorPosY() + 5.0f;
+    float bottom = window_size.y - 60.0f;
+    if (bottom - top < 60.0f)
+        return;
+
+    float width = std::min(window_size.x - 20.0f, 420.0f);
+    ImGui::SetCursorPos({(window_size.x - width) * 0.5f, top});
+    ImGui::BeginChild("laps", {width, bottom - top});
+
+    auto best = lapsM.get_best();
+    auto worst = lapsM.get_worst();
+    ImGui::Text("Best %s  Worst %s  Average %s", format_lap_time(lapsM.get_lap_ns(*best)).c_str(),
+                format_lap_time(lapsM.get_lap_ns(*worst)).c_str(), format_lap_time(lapsM.get_average_ns()).c_str());
+
+    ImGuiTableFlags flags = ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY | ImGuiTableFlags_SizingStretchProp;
+    if (ImGui::BeginTable("laps", 3, flags)) {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("Lap", 0, 0.6f);
+        ImGui::TableSetupColumn("Time", 0, 1.0f);
+        ImGui::TableSetupColumn("Total", 0, 1.0f);
+        ImGui::TableHeadersRow();
+
+        // newest first, only the rows in view are formatted
+        size_t count = lapsM.size();
+        ImGuiListClipper clipper;
+        clipper.Begin(static_cast<int>(count));
+        while (clipper.Step()) {
+            for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++) {
+                size_t index = count - 1 - row;
+                ImGui::TableNextRow();
+
+                ImGui::TableNextColumn();
+                ImGui::Text("%llu", static_cast<unsigned long long>(lapsM.get_number(index)));
+                ImGui::TableNextColumn();
+                auto lap_time = format_lap_time(lapsM.get_lap_ns(index));
+                if (count > 1 && index == *best)
+                    ImGui::TextColored({0.4f, 0.85f, 0.4f, 1.0f}, "%s", lap_time.c_str());
+                else if (count > 1 && index == *worst)
+                    ImGui::TextColored({0.95f, 0.45f, 0.4f, 1.0f}, "%s", lap_time.c_str());
+                else
+                    ImGui::TextUnformatted(lap_time.c_str());
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(format_lap_time(lapsM.get_split_ns(index)).c_str());
+            }
+        }
+        clipper.End();
+
+        ImGui::EndTable();
+    }
+
+    ImGui::EndChild();
+}
+
 void StopwatchDisplay::draw_control_buttons() {
     ImVec2 window_size = ImGui::GetWindowSize();
     float default_button_size = 40.0f;
@@ -180,8 +309,8 @@ void StopwatchDisplay::draw_control_buttons() {
         spacing = 10.0f;
     }
     
-    // Calculate center position for buttons (2 buttons now)
-    float total_width = button_size * 2 + spacing;
+    // Calculate center position for buttons (3 buttons now)
+    float total_width = button_size * 3 + spacing * 2;
     float start_x = (window_size.x - total_width) * 0.5f;
     float button_y = window_size.y - 50.0f + (default_button_size - button_size);
 
@@ -204,24 +333,21 @@ void StopwatchDisplay::draw_control_buttons() {
     ImGui::PushStyleVar(ImGuiStyleVar_FrameRounding, button_size * 0.5f);
     
     const char* play_pause_text = nullptr;
-    if (start_time_msM == 0)
+    if (start_time_nsM == 0)
         play_pause_text = ICON_FA_PLAY;
-    else if (paused_time_start_msM == 0)
+    else if (paused_time_start_nsM == 0)
         play_pause_text = ICON_FA_PAUSE;
     else
         play_pause_text = ICON_FA_PLAY;
     
     if (ImGui::Button(play_pause_text, ImVec2(button_size, button_size))) {
-        if (start_time_msM == 0) {
+        if (start_time_nsM == 0) {
             // Start the stopwatch
             start();
-        } else if (paused_time_start_msM == 0) {
-            // Pause
-            paused_time_start_msM = SDL_GetTicks();
+        } else if (paused_time_start_nsM == 0) {
+            pause();
         } else {
-            // Resume
-            paused_time_msM += SDL_GetTicks() - paused_time_start_msM;
-            paused_time_start_msM = 0;
+            resume();
         }
     }
     
@@ -234,15 +360,24 @@ void StopwatchDisplay::draw_control_buttons() {
     
     ImGui::SameLine(0.0f, spacing);
     
+    // Lap button
+    ImGui::PushStyleVar(ImGuiStyleVar_FrameRounding, button_size * 0.5f);
+    ImGui::BeginDisabled(!is_started() || is_paused());
+    
+    if (ImGui::Button(ICON_FA_FLAG, ImVec2(button_size, button_size))) {
+        lap();
+    }
+    
+    ImGui::EndDisabled();
+    ImGui::PopStyleVar();
+    
+    ImGui::SameLine(0.0f, spacing);
+    
     // Reset button
     ImGui::PushStyleVar(ImGuiStyleVar_FrameRounding, button_size * 0.5f);
     
     if (ImGui::Button(ICON_MS_RESTORE, ImVec2(button_size, button_size))) {
-        // Reset the stopwatch
-        start_time_msM = 0;
-        paused_time_msM = 0;
-        paused_time_start_msM = 0;
-        std::println("Stopwatch Reset");
+        reset();
     }
     
     ImGui::PopStyleVar();
@@ -266,7 +401,7 @@ std::optional<FocusState> StopwatchDisplay::draw() {
         ImGui::SetNextWindowSizeConstraints({-1, -1}, {-1, -1});
     }
     
-    ImGui::Begin(std::format("Stopwatch Display ##{},{}", idM, (int)focusM).c_str(), 
+    ImGui::Begin(std::format("Stopwatch Display ##{}.{},{}", idM.index, idM.generation, (int)focusM).c_str(), 
                  nullptr, 
                  ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoSavedSettings);
     
@@ -281,6 +416,9 @@ std::optional<FocusState> StopwatchDisplay::draw() {
     // Draw the stopwatch time display
     draw_stopwatch_text();
     
+    // Draw the laps under it when there's room
+    draw_laps();
+    
     // Draw control buttons (play/pause, lap, reset)
     draw_control_buttons();
     
@@ -1,6 +1,7 @@
 #pragma once
 #include <optional>
 #include "appstate.hpp"
+#include "lap_store.hpp"
 
 class StopwatchDisplay {
 public:
@@ -10,20 +11,45 @@ public:
     std::optional<FocusState> draw();
 
     void start();
+    void pause();
+    void resume();
+    void reset();
+    // Ends the current lap, only while running
+    void lap();
+    // Picks a run back up `elapsed_ms` in, for stopwatches restored from the journal
+    void restore(Uint64 elapsed_ms, bool paused);
+    // True once after the stopwatch was started, paused, resumed or reset
+    bool take_state_change();
+    // How long the run was, once after a started stopwatch was reset
+    std::optional<Uint64> take_finished_run();
+    // How many laps ended since the last call, the newest of the kept ones
+    Uint64 take_new_laps();
 
-    const unsigned long& get_id() const { return idM; }
+    Uint64 calculate_time_progress_ms() const;
+    Uint64 calculate_time_progress_ns() const;
+    bool is_started() const { return start_time_nsM != 0; }
+    bool is_paused() const { return paused_time_start_nsM != 0; }
+    const LapStore& get_laps() const { return lapsM; }
+
+    const SlotHandle& get_id() const { return idM; }
+    void set_id(SlotHandle id) { idM = id; }
     FocusType get_focus_type() const { return focusM; }
     void set_focus_type(FocusType new_type) { focusM = new_type; }
 private:
-    unsigned long start_time_msM;
-    unsigned long paused_time_msM;
-    unsigned long paused_time_start_msM;
-    unsigned long idM;
+    Uint64 start_time_nsM;
+    Uint64 paused_time_nsM;
+    Uint64 paused_time_start_nsM;
+    SlotHandle idM;
     FocusType focusM;
+    bool state_changedM;
+    Uint64 finished_run_msM;
+    LapStore lapsM;
+    Uint64 new_lapsM;
 
-    unsigned long calculate_time_progress_ms();
     std::optional<FocusState> draw_header();
+    bool shows_laps() const;
     void draw_stopwatch_text();
+    void draw_laps();
     void draw_control_buttons();
 };
 
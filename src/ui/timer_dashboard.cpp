@@ -0,0 +1,176 @@
+#include "timer_dashboard.hpp"
+#include "IconsFontAwesome7.h"
+#include "IconsMaterialSymbols.h"
+#include "clock.hpp"
+#include "imgui.h"
+#include "timer_service.hpp"
+#include "ui/circular_progress_bar.hpp"
+#include "ui/offscreen_imgui.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <print>
+#include <stdexcept>
+
+std::optional<SlotHandle> TimerDashboard::draw(SDL_Renderer* renderer, SlotMap<TimerDisplay>& timers,
+                                               const TimerBatch& batch, AudioPlayer& ap) {
+    std::optional<SlotHandle> return_val = std::nullopt;
+    constexpr float cell_size = 180.0f;
+
+    // the rings are drawn underneath the window, like in TimerDisplay
+    ImGui::SetNextWindowBgAlpha(0.3);
+    ImGui::SetNextWindowSize({600.0f, 450.0f}, ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowPos({200, 30}, ImGuiCond_FirstUseEver);
+    ImGui::Begin("Timer Dashboard");
+
+    const ImGuiStyle& style = ImGui::GetStyle();
+    float avail_width = ImGui::GetContentRegionAvail().x;
+    int columns = std::max(1, static_cast<int>((avail_width + style.ItemSpacing.x) / (cell_size + style.ItemSpacing.x)));
+    int rows = (static_cast<int>(timers.size()) + columns - 1) / columns;
+
+    ring_verticesM.clear();
+
+    // only the rows in view get laid out, the rest is skipped as one block
+    ImGuiListClipper clipper;
+    clipper.Begin(rows, cell_size + style.ItemSpacing.y);
+    while (clipper.Step()) {
+        for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++) {
+            for (int col = 0; col < columns; col++) {
+                size_t i = static_cast<size_t>(row) * columns + col;
+                if (i >= timers.size())
+                    break;
+                if (col != 0)
+                    ImGui::SameLine();
+
+                SlotHandle handle = timers.handle_at(i);
+                auto changed = draw_cell(timers[i], handle, batch.get_frame(handle.index), cell_size, ap);
+                if (changed.has_value())
+                    return_val = changed;
+            }
+        }
+    }
+    clipper.End();
+
+    // one draw call for every visible ring, clipped so the rings of partly
+    // scrolled out rows don't spill over the rest of the screen
+    ImVec2 window_pos = ImGui::GetWindowPos();
+    ImVec2 window_size = ImGui::GetWindowSize();
+    SDL_Rect clip {
+        static_cast<int>(window_pos.x), static_cast<int>(window_pos.y),
+        static_cast<int>(window_size.x), static_cast<int>(window_size.y)
+    };
+    SDL_SetRenderClipRect(renderer, &clip);
+    SDL_RenderGeometry(renderer, nullptr, ring_verticesM.data(), static_cast<int>(ring_verticesM.size()), nullptr, 0);
+    SDL_SetRenderClipRect(renderer, nullptr);
+
+    ImGui::End();
+
+    return return_val;
+}
+
+std::optional<SlotHandle> TimerDashboard::draw_cell(TimerDisplay& timer, SlotHandle handle, const TimerFrame& frame,
+                                                    float cell_size, AudioPlayer& ap) {
+    std::optional<SlotHandle> return_val = std::nullopt;
+    ImVec2 origin = ImGui::GetCursorScreenPos();
+    ImGui::PushID(static_cast<int>(handle.index));
+
+    CircularProgressBar ring(origin.x + cell_size * 0.5f, origin.y + cell_size * 0.45f, cell_size * 0.33f, cell_size * 0.04f);
+    ring.set_progress(frame.progress);
+    ring.append_geometry(ring_verticesM);
+
+    ImGui::SetCursorScreenPos({origin.x + 4.0f, origin.y});
+    ImGui::TextUnformatted(timer.get_label().c_str());
+
+    // rounded up so the timer only shows 00:00:00 once it's done
+    auto text = format_time(static_cast<int>((frame.remaining_ms + 999) / 1000));
+    ImVec2 text_size = ImGui::CalcTextSize(text.c_str());
+    ImGui::SetCursorScreenPos({origin.x + (cell_size - text_size.x) * 0.5f, origin.y + cell_size * 0.45f - text_size.y * 0.5f});
+    auto color = ImVec4(0.263f, 0.49f, 0.525f, 1.0f);
+    if (frame.done)
+        color.w = std::abs(std::sin(frame.elapsed_ms / 500.0));
+    ImGui::TextColored(color, "%s", text.c_str());
+
+    float button_size = 26.0f;
+    float spacing = 10.0f;
+    ImGui::SetCursorScreenPos({origin.x + (cell_size - button_size * 2 - spacing) * 0.5f, origin.y + cell_size - button_size});
+    ImGui::PushStyleVar(ImGuiStyleVar_FrameRounding, button_size * 0.5f);
+
+    const char* play_text = timer.is_started() && !timer.is_paused() ? ICON_FA_PAUSE : ICON_FA_PLAY;
+    if (ImGui::Button(play_text, ImVec2(button_size, button_size))) {
+        if (!timer.is_started())
+            timer.start();
+        else if (!timer.is_paused())
+            timer.pause();
+        else
+            timer.resume();
+        return_val = handle;
+    }
+
+    ImGui::SameLine(0.0f, spacing);
+    if (ImGui::Button(ICON_MS_RESTORE, ImVec2(button_size, button_size))) {
+        timer.reset(ap);
+        return_val = handle;
+    }
+
+    ImGui::PopStyleVar();
+    ImGui::PopID();
+
+    // reserve the whole cell so the grid and the clipper see a fixed size
+    ImGui::SetCursorScreenPos(origin);
+    ImGui::Dummy({cell_size, cell_size});
+
+    return return_val;
+}
+
+bool run_dashboard_benchmark(const char* sound_path) {
+    std::unique_ptr<TimerService> service;
+    try {
+        service.reset(new TimerService {.audio_player = {sound_path, AudioOptions {.no_device = true}}});
+    } catch (const std::runtime_error& e) {
+        std::println(stderr, "Dashboard benchmark failed: {}", e.what());
+        return false;
+    }
+    OffscreenImGui imgui(1280, 800);
+    if (!imgui.is_ready()) {
+        std::println(stderr, "Dashboard benchmark failed: {}", SDL_GetError());
+        return false;
+    }
+
+    constexpr int warm_up_frames = 10;
+    constexpr int frames = 300;
+    TimerDashboard dashboard;
+    for (size_t timer_count : {10, 100, 1000}) {
+        // on top of the timers of the last round, every other one running
+        while (service->timers.size() < timer_count) {
+            auto handle = add_timer(*service, TimerDisplay {static_cast<int>(60 + service->timers.size())});
+            if (service->timers.size() % 2 == 0) {
+                service->timers.get(handle)->start();
+                sync_timer_events(*service, handle);
+            }
+        }
+
+        // what the app's loop does for the dashboard, up to the draw lists
+        // being ready, rasterizing them is the GPU's part
+        std::vector<double> frame_ms;
+        for (int frame = 0; frame < warm_up_frames + frames; frame++) {
+            auto start = std::chrono::steady_clock::now();
+            service->timer_batch.update(clock_now_ms());
+            imgui.new_frame();
+            dashboard.draw(imgui.get_renderer(), service->timers, service->timer_batch, service->audio_player);
+            imgui.end_frame();
+            auto end = std::chrono::steady_clock::now();
+            imgui.present();
+            if (frame >= warm_up_frames)
+                frame_ms.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+        }
+
+        std::sort(frame_ms.begin(), frame_ms.end());
+        double total_ms = 0;
+        for (double ms : frame_ms)
+            total_ms += ms;
+        std::println("{} timers: {:.3f} ms a frame, {:.3f} ms at the 99th percentile", timer_count,
+                     total_ms / frames, frame_ms[frames * 99 / 100]);
+    }
+    return true;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "slot_map.hpp"
+#include "timer_batch.hpp"
+#include "ui/timer_display.hpp"
+#include <SDL3/SDL.h>
+#include <optional>
+#include <vector>
+
+// Shows every timer as a cell of one scrollable grid instead of a window
+// per timer. Rows are virtualized with ImGuiListClipper, so only the cells
+// on screen are laid out, and their rings are sent to the renderer in a
+// single draw call.
+class TimerDashboard {
+public:
+    // Returns the timer whose buttons were used this frame, if any
+    std::optional<SlotHandle> draw(SDL_Renderer* renderer, SlotMap<TimerDisplay>& timers,
+                                   const TimerBatch& batch, AudioPlayer& ap);
+
+private:
+    std::vector<SDL_Vertex> ring_verticesM;
+
+    std::optional<SlotHandle> draw_cell(TimerDisplay& timer, SlotHandle handle, const TimerFrame& frame,
+                                        float cell_size, AudioPlayer& ap);
+};
+
+// Times frames of the dashboard with 10, 100 and 1000 timers, drawn into a
+// software renderer so no window or display is needed, for
+// --dashboard-benchmark
+bool run_dashboard_benchmark(const char* sound_path);
@@ -4,7 +4,9 @@
 #include "SDL3/SDL_timer.h"
 #include "appstate.hpp"
 #include "audio_player.hpp"
+#include "clock.hpp"
 #include "imgui.h"
+#include "imgui_stdlib.h"
 #include "ui/circular_progress_bar.hpp"
 #include <algorithm>
 #include <cmath>
@@ -12,50 +14,71 @@
 #include <format>
 #include <optional>
 #include <print>
+#include <utility>
 
 TimerDisplay::TimerDisplay() 
     : timer_secondsM(60)
     , start_time_msM(0)
     , paused_time_msM(0)
     , paused_time_start_msM(0)
+    , offset_msM(0)
     , progress_barM(0, 0, 100, 12)
-    , idM(SDL_GetTicks())
+    , idM()
     , focusM(FocusType::None)
     , titleM(format_time(60))
+    , schedule_changedM(false)
+    , stopped_run_msM(0)
+    , frameM()
 {
 }
 
 TimerDisplay::TimerDisplay(int timer_seconds)
+    : TimerDisplay(timer_seconds, format_time(timer_seconds))
+{
+}
+
+TimerDisplay::TimerDisplay(int timer_seconds, std::string label)
     : timer_secondsM(timer_seconds)
     , start_time_msM(0)
     , paused_time_msM(0)
     , paused_time_start_msM(0)
+    , offset_msM(0)
     , progress_barM(0, 0, 100, 12)
-    , idM(SDL_GetTicks())
+    , idM()
     , focusM(FocusType::None)
-    , titleM(format_time(timer_seconds))
+    , titleM(std::move(label))
+    , schedule_changedM(false)
+    , stopped_run_msM(0)
+    , frameM()
 {
 }
 
 void TimerDisplay::set_timer_value(int seconds) {
     timer_secondsM = seconds;
+    schedule_changedM = true;
+}
+
+void TimerDisplay::set_phase(int seconds, Uint64 offset_ms) {
+    timer_secondsM = seconds;
+    offset_msM = offset_ms;
+    schedule_changedM = true;
 }
 
 void TimerDisplay::update_progress_bar() {
-    progress_barM.set_progress(calculate_time_progress_ms() / (timer_secondsM * 1000.0f));
+    progress_barM.set_progress(frameM.progress);
 }
 
 void TimerDisplay::reset(AudioPlayer& ap) {
     std::println("Timer Reset");
+    if (is_started() && !is_done())
+        stopped_run_msM = calculate_time_progress_ms();
     start_time_msM = 0;
     paused_time_msM = 0;
     paused_time_start_msM = 0;
     progress_barM.reset();
+    schedule_changedM = true;
 
-    if (ap.is_playing_or_not()) {
-        ap.pause();
-        ap.seek_to(0);
-    }
+    ap.stop(idM.to_key());
 }
 
 std::string format_time(int seconds) {
@@ -66,22 +89,59 @@ std::string format_time(int seconds) {
 }
 
 void TimerDisplay::set_label(std::string label) {
-    titleM = label;
+    titleM = std::move(label);
 }
 
-unsigned long TimerDisplay::calculate_time_progress_ms() const {
+void TimerDisplay::set_sound(std::string path) {
+    if (path == sound_pathM)
+        return;
+    sound_pathM = std::move(path);
+    // the alarm's lead time depends on the sound
+    schedule_changedM = true;
+}
+
+Uint64 TimerDisplay::get_elapsed_ms() const {
+    // a timer that isn't running waits at the start of its phase
     if (start_time_msM == 0)
-        return 0;
-    auto now = SDL_GetTicks();
+        return offset_msM;
+    auto now = clock_now_ms();
     auto paused_time_ms = paused_time_msM;
     if (paused_time_start_msM != 0)
         paused_time_ms += now - paused_time_start_msM;
 
-    auto progress_ms = (now - start_time_msM) - paused_time_ms;
-    return progress_ms;
+    return (now - start_time_msM) - paused_time_ms;
+}
+
+Uint64 TimerDisplay::calculate_time_progress_ms() const {
+    auto elapsed_ms = get_elapsed_ms();
+    return elapsed_ms > offset_msM ? elapsed_ms - offset_msM : 0;
+}
+
+void TimerDisplay::draw_sound_popup(AudioPlayer& ap) {
+    // only one popup is open at a time, so every timer can share the input
+    static std::string path_input;
+    if (ImGui::IsWindowAppearing())
+        path_input = sound_pathM;
+
+    ImGui::SetNextItemWidth(300.0f);
+    ImGui::InputTextWithHint("##sound path", "Default sound", &path_input);
+    ImGui::SameLine();
+    if (ImGui::Button("Use")) {
+        if (!path_input.empty())
+            ap.preload(path_input);
+        set_sound(path_input);
+        ImGui::CloseCurrentPopup();
+    }
+
+    auto stats = ap.get_cache_stats();
+    ImGui::TextDisabled("Sound cache: %zu hits, %zu misses, %.1f of %.1f MB", stats.hits, stats.misses,
+                        stats.bytes / (1024.0 * 1024.0), stats.budget_bytes / (1024.0 * 1024.0));
+    auto latency = ap.get_latency();
+    ImGui::TextDisabled("Output latency: %.1f ms (%u x %u frames at %u Hz)", latency.ms, latency.periods,
+                        latency.period_frames, latency.sample_rate);
 }
 
-std::optional<FocusState> TimerDisplay::draw_header() {
+std::optional<FocusState> TimerDisplay::draw_header(AudioPlayer& ap) {
     std::optional<FocusState> return_val = std::nullopt; 
 
     ImGui::BeginGroup();
@@ -100,7 +160,16 @@ std::optional<FocusState> TimerDisplay::draw_header() {
     // Expand button
     if (focusM != FocusType::Popout) {
         // Right side - action buttons
-        ImGui::SameLine(ImGui::GetContentRegionAvail().x - 80 + (defualt_button_size - button_size) * 2);
+        ImGui::SameLine(ImGui::GetContentRegionAvail().x - 120 + (defualt_button_size - button_size) * 3);
+
+        if (ImGui::Button(ICON_FA_BELL, ImVec2(button_size, button_size)))
+            ImGui::OpenPopup("Alarm sound");
+        if (ImGui::BeginPopup("Alarm sound")) {
+            draw_sound_popup(ap);
+            ImGui::EndPopup();
+        }
+
+        ImGui::SameLine();
 
         const char* icon = ICON_FA_EXPAND;
         if (focusM == FocusType::Fullscreen)
@@ -140,7 +209,7 @@ std::optional<FocusState> TimerDisplay::draw_header() {
 }
 
 void TimerDisplay::draw_timer_text() {
-    auto progress_seconds = (start_time_msM != 0 ? calculate_time_progress_ms() / 1000 : 0);
+    auto progress_seconds = frameM.elapsed_ms / 1000;
     auto time_to_format = (long)timer_secondsM - (long)progress_seconds;
     auto text = format_time(time_to_format);
     
@@ -168,8 +237,8 @@ void TimerDisplay::draw_timer_text() {
                                 window_center.y - text_size.y * 0.5f));
     
     auto color = ImVec4(0.263f, 0.49f, 0.525f, 1.0f);
-    if (calculate_time_progress_ms() >= timer_secondsM * 1000)
-        color.w = std::abs(std::sin(calculate_time_progress_ms() / 500.0));
+    if (frameM.done)
+        color.w = std::abs(std::sin(frameM.elapsed_ms / 500.0));
     ImGui::TextColored(color, "%s", text.c_str());
     
     ImGui::PopFont();
@@ -218,13 +287,9 @@ void TimerDisplay::draw_control_buttons(AudioPlayer& ap) {
         if (start_time_msM == 0)
             this->start();
         else if (paused_time_start_msM == 0)
-            paused_time_start_msM = SDL_GetTicks();
-        else if (paused_time_start_msM != 0) {
-            paused_time_msM += SDL_GetTicks() - paused_time_start_msM;
-            paused_time_start_msM = 0;
-
-            std::println("{} {} {}", paused_time_start_msM, paused_time_msM, start_time_msM);
-        }
+            pause();
+        else if (paused_time_start_msM != 0)
+            resume();
     }
     
     ImGui::PopStyleVar();
@@ -249,10 +314,58 @@ void TimerDisplay::draw_control_buttons(AudioPlayer& ap) {
 }
 
 void TimerDisplay::start() {
-    start_time_msM = SDL_GetTicks();
+    // backdated so the run picks up at the beginning of the current phase
+    auto now = clock_now_ms();
+    start_time_msM = now > offset_msM ? now - offset_msM : 1;
+    schedule_changedM = true;
     std::println("Starting timer: {}", start_time_msM);
 }
 
+void TimerDisplay::pause() {
+    if (start_time_msM == 0 || paused_time_start_msM != 0)
+        return;
+    paused_time_start_msM = clock_now_ms();
+    schedule_changedM = true;
+}
+
+void TimerDisplay::resume() {
+    if (paused_time_start_msM == 0)
+        return;
+    paused_time_msM += clock_now_ms() - paused_time_start_msM;
+    paused_time_start_msM = 0;
+    schedule_changedM = true;
+}
+
+void TimerDisplay::restore(Uint64 elapsed_ms, bool paused) {
+    auto now = clock_now_ms();
+    start_time_msM = now > elapsed_ms ? now - elapsed_ms : 1;
+    paused_time_msM = 0;
+    paused_time_start_msM = paused ? now : 0;
+    schedule_changedM = true;
+}
+
+std::optional<Uint64> TimerDisplay::get_deadline_ms() const {
+    if (start_time_msM == 0 || paused_time_start_msM != 0)
+        return std::nullopt;
+    return start_time_msM + paused_time_msM + offset_msM + static_cast<Uint64>(timer_secondsM) * 1000;
+}
+
+TimerTiming TimerDisplay::get_timing() const {
+    return {start_time_msM, paused_time_msM, paused_time_start_msM, offset_msM, static_cast<Uint64>(timer_secondsM) * 1000};
+}
+
+bool TimerDisplay::take_schedule_change() {
+    bool changed = schedule_changedM;
+    schedule_changedM = false;
+    return changed;
+}
+
+std::optional<Uint64> TimerDisplay::take_stopped_run() {
+    if (stopped_run_msM == 0)
+        return std::nullopt;
+    return std::exchange(stopped_run_msM, 0);
+}
+
 std::optional<FocusState> TimerDisplay::draw(SDL_Renderer* renderer, AudioPlayer& ap) {
     ImGui::SetNextWindowBgAlpha(0.3);
 
@@ -269,10 +382,10 @@ std::optional<FocusState> TimerDisplay::draw(SDL_Renderer* renderer, AudioPlayer
         ImGui::SetNextWindowSizeConstraints({-1, -1}, {-1, -1});
     }
 
-    ImGui::Begin(std::format("Timer Display ##{},{}", idM, (int)focusM).c_str(), nullptr, ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoSavedSettings);
+    ImGui::Begin(std::format("Timer Display ##{}.{},{}", idM.index, idM.generation, (int)focusM).c_str(), nullptr, ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoSavedSettings);
 
     // Draw header with label and action buttons
-    return_val = draw_header();
+    return_val = draw_header(ap);
     if (return_val.has_value())
         this->focusM = return_val->type;
     
@@ -304,15 +417,6 @@ std::optional<FocusState> TimerDisplay::draw(SDL_Renderer* renderer, AudioPlayer
     // Draw control buttons at the bottom
     draw_control_buttons(ap);
 
-    constexpr unsigned timer_sound_goes_off_ms = 10'500;
-    if ((timer_secondsM * 1000) - calculate_time_progress_ms() <= timer_sound_goes_off_ms &&
-        !ap.is_playing_or_not() && start_time_msM != 0) {
-
-        ap.play();
-        if (timer_secondsM * 1000 < timer_sound_goes_off_ms)
-            ap.seek_to(timer_sound_goes_off_ms / 1000.0 - timer_secondsM);
-    }
-
     ImGui::End();
 
     return return_val;
@@ -5,24 +5,40 @@
 #include <SDL3/SDL.h>
 #include "appstate.hpp"
 #include "audio_player.hpp"
+#include "timer_batch.hpp"
 
 std::string format_time(int seconds);
 
+// how long before the end of a timer the alarm sound starts, the ring itself
+// is this far into the sound file
+constexpr unsigned timer_sound_goes_off_ms = 10'500;
+
 class TimerDisplay {
 public:
     TimerDisplay();
     TimerDisplay(int timer_seconds);
+    // Starts out with `label` rather than its length
+    TimerDisplay(int timer_seconds, std::string label);
 
     // Draw the timer UI
     std::optional<FocusState> draw(SDL_Renderer* renderer, AudioPlayer& ap);
 
     // Set the timer value (total time) in seconds
     void set_timer_value(int seconds);
+
+    // Make the timer count down `seconds` starting `offset_ms` into its run
+    // instead of from its start, used to chain pomodoro phases without
+    // restarting the clock between them
+    void set_phase(int seconds, Uint64 offset_ms);
     
-    // update the timer's progress
+    // update the timer's progress from the last frame passed to set_frame
     void update_progress_bar();
 
     void start();
+    void pause();
+    void resume();
+    // Picks a run back up `elapsed_ms` in, for timers restored from the journal
+    void restore(Uint64 elapsed_ms, bool paused);
     
     // Reset the timer
     void reset(AudioPlayer& ap);
@@ -30,27 +46,57 @@ public:
     // Set the label text (e.g., "1 min")
     void set_label(std::string label);
 
+    // Sound file the alarm plays, empty for the default sound
+    void set_sound(std::string path);
+    const std::string& get_sound() const { return sound_pathM; }
+    // How long before the deadline the alarm starts, the default sound
+    // builds up to its ring and others start right on the deadline
+    Uint64 get_alarm_lead_ms() const { return sound_pathM.empty() ? timer_sound_goes_off_ms : 0; }
+
     const CircularProgressBar& get_progress() const { return progress_barM; }
-    const unsigned long& get_id() const { return idM; }
+    const std::string& get_label() const { return titleM; }
+    bool is_started() const { return start_time_msM != 0; }
+    bool is_paused() const { return paused_time_start_msM != 0; }
+    const SlotHandle& get_id() const { return idM; }
+    void set_id(SlotHandle id) { idM = id; }
     FocusType get_focus_type() const { return focusM; }
     void set_focus_type(FocusType new_type) { focusM = new_type; }
     bool is_done() const { return calculate_time_progress_ms() >= timer_secondsM * 1000; }
 
+    // When the timer runs out on the clock from clock.hpp, nullopt unless running
+    std::optional<Uint64> get_deadline_ms() const;
+    // True once after the timer was started, paused, resumed or reset
+    bool take_schedule_change();
+    // How far the run had got, once after it was reset before it ran out
+    std::optional<Uint64> take_stopped_run();
+    // Time the timer has been running for, including the phase offset
+    Uint64 get_elapsed_ms() const;
+
+    TimerTiming get_timing() const;
+    // Progress shown by the next draw, computed by the caller once per tick
+    void set_frame(const TimerFrame& frame) { frameM = frame; }
+
 private:
     CircularProgressBar progress_barM;
     int timer_secondsM;
-    unsigned long start_time_msM;
-    unsigned long paused_time_msM;
-    unsigned long paused_time_start_msM;
-    unsigned long idM;
+    Uint64 start_time_msM;
+    Uint64 paused_time_msM;
+    Uint64 paused_time_start_msM;
+    Uint64 offset_msM;
+    SlotHandle idM;
     FocusType focusM;
     std::string titleM;
+    std::string sound_pathM;
+    bool schedule_changedM;
+    Uint64 stopped_run_msM;
+    TimerFrame frameM;
     
     // Helper methods
-    std::optional<FocusState> draw_header();
+    std::optional<FocusState> draw_header(AudioPlayer& ap);
+    void draw_sound_popup(AudioPlayer& ap);
     void draw_timer_text();
     void draw_control_buttons(AudioPlayer& ap);
-    unsigned long calculate_time_progress_ms() const;
+    Uint64 calculate_time_progress_ms() const;
 };
 
 #endif // TIMER_DISPLAY_HPP
@@ -0,0 +1,201 @@
+#include "timer_table.hpp"
+#include "IconsFontAwesome7.h"
+#include "clock.hpp"
+#include "imgui.h"
+#include "timer_service.hpp"
+#include "ui/offscreen_imgui.hpp"
+#include <SDL3/SDL_time.h>
+#include <algorithm>
+#include <chrono>
+#include <format>
+#include <memory>
+#include <print>
+#include <stdexcept>
+
+namespace {
+
+enum Column {
+    ColumnLabel, ColumnTime, ColumnState, ColumnDeadline
+};
+
+// Local time of day at which a deadline `from_now_ms` away falls
+std::string format_deadline(Uint64 from_now_ms) {
+    SDL_Time now;
+    SDL_DateTime dt;
+    if (!SDL_GetCurrentTime(&now) || !SDL_TimeToDateTime(now + SDL_MS_TO_NS(static_cast<SDL_Time>(from_now_ms)), &dt, true))
+        return "-";
+    return std::format("{:02}:{:02}:{:02}", dt.hour, dt.minute, dt.second);
+}
+
+}
+
+std::optional<SlotHandle> TimerTable::draw(SlotMap<TimerDisplay>& timers, SlotMap<StopwatchDisplay>& stopwatches,
+                                           const TimerBatch& batch, const RemainingIndex& order, Uint64 now_ms) {
+    std::optional<SlotHandle> return_val = std::nullopt;
+
+    ImGui::SetNextWindowSize({600.0f, 450.0f}, ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowPos({200, 30}, ImGuiCond_FirstUseEver);
+    ImGui::Begin("Timer Table");
+
+    ImGuiTableFlags flags = ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV | ImGuiTableFlags_ScrollY |
+                            ImGuiTableFlags_Resizable | ImGuiTableFlags_Sortable | ImGuiTableFlags_SizingStretchProp;
+    if (ImGui::BeginTable("timers", 4, flags)) {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("Label", ImGuiTableColumnFlags_NoSort, 2.0f, ColumnLabel);
+        ImGui::TableSetupColumn("Remaining / Elapsed", ImGuiTableColumnFlags_DefaultSort, 1.5f, ColumnTime);
+        ImGui::TableSetupColumn("State", ImGuiTableColumnFlags_NoSort, 1.0f, ColumnState);
+        ImGui::TableSetupColumn("Deadline", ImGuiTableColumnFlags_NoSort, 1.0f, ColumnDeadline);
+        ImGui::TableHeadersRow();
+
+        // only the time column sorts, so there is at most one spec
+        if (ImGuiTableSortSpecs* specs = ImGui::TableGetSortSpecs(); specs && specs->SpecsDirty) {
+            if (specs->SpecsCount > 0)
+                descendingM = specs->Specs[0].SortDirection == ImGuiSortDirection_Descending;
+            specs->SpecsDirty = false;
+        }
+
+        int timer_rows = static_cast<int>(order.size());
+        ImGuiListClipper clipper;
+        clipper.Begin(timer_rows + static_cast<int>(stopwatches.size()));
+        while (clipper.Step()) {
+            // the index is only walked as far as the last visible timer
+            visible_idsM.clear();
+            if (clipper.DisplayStart < timer_rows)
+                order.collect(now_ms, clipper.DisplayStart, std::min(clipper.DisplayEnd, timer_rows) - clipper.DisplayStart,
+                              descendingM, visible_idsM);
+
+            for (Uint64 id : visible_idsM) {
+                SlotHandle handle = SlotHandle::from_key(id);
+                TimerDisplay* timer = timers.get(handle);
+                if (timer == nullptr)
+                    continue;
+
+                auto changed = draw_timer_row(*timer, handle, batch.get_frame(handle.index), now_ms);
+                if (changed.has_value())
+                    return_val = changed;
+            }
+
+            for (int row = std::max(clipper.DisplayStart, timer_rows); row < clipper.DisplayEnd; row++)
+                draw_stopwatch_row(stopwatches[row - timer_rows], row - timer_rows);
+        }
+        clipper.End();
+
+        ImGui::EndTable();
+    }
+
+    ImGui::End();
+    return return_val;
+}
+
+std::optional<SlotHandle> TimerTable::draw_timer_row(TimerDisplay& timer, SlotHandle handle, const TimerFrame& frame, Uint64 now_ms) {
+    std::optional<SlotHandle> return_val = std::nullopt;
+    ImGui::PushID(static_cast<int>(handle.index));
+    ImGui::TableNextRow();
+
+    ImGui::TableSetColumnIndex(ColumnLabel);
+    ImGui::TextUnformatted(timer.get_label().c_str());
+
+    ImGui::TableSetColumnIndex(ColumnTime);
+    // rounded up like the timer windows, 00:00:00 only shows once it's done
+    ImGui::TextUnformatted(format_time(static_cast<int>((frame.remaining_ms + 999) / 1000)).c_str());
+
+    ImGui::TableSetColumnIndex(ColumnState);
+    const char* state = !timer.is_started() ? "Idle" : timer.is_paused() ? "Paused" : frame.done ? "Done" : "Running";
+    const char* icon = timer.is_started() && !timer.is_paused() ? ICON_FA_PAUSE : ICON_FA_PLAY;
+    if (ImGui::SmallButton(icon)) {
+        if (!timer.is_started())
+            timer.start();
+        else if (!timer.is_paused())
+            timer.pause();
+        else
+            timer.resume();
+        return_val = handle;
+    }
+    ImGui::SameLine();
+    ImGui::TextUnformatted(state);
+
+    ImGui::TableSetColumnIndex(ColumnDeadline);
+    auto deadline = timer.get_deadline_ms();
+    if (deadline.has_value() && *deadline > now_ms)
+        ImGui::TextUnformatted(format_deadline(*deadline - now_ms).c_str());
+    else
+        ImGui::TextDisabled("-");
+
+    ImGui::PopID();
+    return return_val;
+}
+
+void TimerTable::draw_stopwatch_row(StopwatchDisplay& sw, size_t index) {
+    ImGui::TableNextRow();
+
+    ImGui::TableSetColumnIndex(ColumnLabel);
+    ImGui::Text("Stopwatch %zu", index + 1);
+
+    ImGui::TableSetColumnIndex(ColumnTime);
+    ImGui::TextUnformatted(format_time(static_cast<int>(sw.calculate_time_progress_ms() / 1000)).c_str());
+
+    ImGui::TableSetColumnIndex(ColumnState);
+    ImGui::TextUnformatted(!sw.is_started() ? "Idle" : sw.is_paused() ? "Paused" : "Running");
+
+    ImGui::TableSetColumnIndex(ColumnDeadline);
+    ImGui::TextDisabled("-");
+}
+
+bool run_table_benchmark(const char* sound_path) {
+    std::unique_ptr<TimerService> service;
+    try {
+        service.reset(new TimerService {.audio_player = {sound_path, AudioOptions {.no_device = true}}});
+    } catch (const std::runtime_error& e) {
+        std::println(stderr, "Table benchmark failed: {}", e.what());
+        return false;
+    }
+    OffscreenImGui imgui(1280, 800);
+    if (!imgui.is_ready()) {
+        std::println(stderr, "Table benchmark failed: {}", SDL_GetError());
+        return false;
+    }
+
+    // 5000 rows, a tenth of them stopwatches, every other timer running
+    constexpr size_t timer_count = 4500;
+    constexpr size_t stopwatch_count = 500;
+    constexpr double budget_ms = 2.0;
+    for (size_t i = 0; i < timer_count; i++) {
+        auto handle = add_timer(*service, TimerDisplay {static_cast<int>(60 + i)});
+        if (i % 2 == 0) {
+            service->timers.get(handle)->start();
+            sync_timer_events(*service, handle);
+        }
+    }
+    for (size_t i = 0; i < stopwatch_count; i++)
+        add_stopwatch(*service, StopwatchDisplay {});
+
+    // what the app's loop does for the table, up to the draw lists being
+    // ready, rasterizing them is the GPU's part
+    constexpr int warm_up_frames = 10;
+    constexpr int frames = 300;
+    TimerTable table;
+    std::vector<double> frame_ms;
+    for (int frame = 0; frame < warm_up_frames + frames; frame++) {
+        auto start = std::chrono::steady_clock::now();
+        Uint64 now = clock_now_ms();
+        service->timer_batch.update(now);
+        imgui.new_frame();
+        table.draw(service->timers, service->stopwatches, service->timer_batch, service->timer_order, now);
+        imgui.end_frame();
+        auto end = std::chrono::steady_clock::now();
+        imgui.present();
+        if (frame >= warm_up_frames)
+            frame_ms.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    }
+
+    std::sort(frame_ms.begin(), frame_ms.end());
+    double total_ms = 0;
+    for (double ms : frame_ms)
+        total_ms += ms;
+    double average_ms = total_ms / frames;
+    bool ok = average_ms < budget_ms;
+    std::println("{} rows: {:.3f} ms a frame, {:.3f} ms at the 99th percentile, {} the {} ms budget",
+                 timer_count + stopwatch_count, average_ms, frame_ms[frames * 99 / 100], ok ? "within" : "over",
+                 budget_ms);
+    return ok;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "remaining_index.hpp"
+#include "slot_map.hpp"
+#include "timer_batch.hpp"
+#include "ui/stopwatch_display.hpp"
+#include "ui/timer_display.hpp"
+#include <optional>
+#include <vector>
+
+// Dense table of every timer and stopwatch, one row each. Rows are clipped
+// to the visible ones, and timers are sorted by remaining time through a
+// RemainingIndex so the order never has to be rebuilt. Stopwatches have no
+// remaining time and are listed after the timers.
+class TimerTable {
+public:
+    // Returns the timer started or paused from the table this frame, if any
+    std::optional<SlotHandle> draw(SlotMap<TimerDisplay>& timers, SlotMap<StopwatchDisplay>& stopwatches,
+                                   const TimerBatch& batch, const RemainingIndex& order, Uint64 now_ms);
+
+private:
+    bool descendingM = false;
+    // ids of the timers on screen, in display order
+    std::vector<Uint64> visible_idsM;
+
+    std::optional<SlotHandle> draw_timer_row(TimerDisplay& timer, SlotHandle handle, const TimerFrame& frame, Uint64 now_ms);
+    void draw_stopwatch_row(StopwatchDisplay& sw, size_t index);
+};
+
+// Times frames of the table with 4500 timers and 500 stopwatches, drawn
+// into a software renderer so no window or display is needed, and fails
+// if a frame takes 2 ms or more on average, for --table-benchmark
+bool run_table_benchmark(const char* sound_path);